@@ -0,0 +1,60 @@
+#!/usr/bin/perl
+
+# Stops each run with -k, resumes it with -r and checks that the resumed run
+# prints exactly what the uninterrupted run prints from that time unit on
+
+$failed = 0;
+@runs = (
+	# options, input file, time unit to stop at
+	["-c 2 -s fcfs", "examples/proc4.csv", 4],
+	["-c 1 -s sjf", "examples/proc4.csv", 6],
+	["-c 2 -s psjf", "examples/proc4.csv", 3],
+	["-c 2 -s pri", "examples/proc4.csv", 8],
+	["-c 2 -s ppri -a 2", "examples/proc4.csv", 5],
+	["-c 2 -s rr2", "examples/proc4.csv", 5],
+	["-c 4 -s stride2", "examples/proc4.csv", 3],
+	["-c 2 -s lottery2", "examples/proc4.csv", 7],
+	["-c 2 -s rr12:2", "examples/proc4.csv", 9],
+	["-c 4 -s psjf -q least", "examples/proc4.csv", 4],
+	["-c 2 -s ppri -x 1 -m 2", "examples/proc4.csv", 6],
+	["-c 1:2.0,1:1.0 -s psjf", "examples/proc4.csv", 5],
+	["-c 2 -s psjf", "examples/proc1.csv", 12],
+	["-c 4 -s fcfs -g easy", "examples/gang.csv", 4],
+	["-c 1 -s rr2", "examples/io.csv", 6],
+);
+for $run (@runs){
+	($args, $file, $time) = @$run;
+	$full = `./simulator $args $file 2>&1`;
+	`./simulator $args -k $time:checkpoint.bin $file 2>&1`;
+	$resumed = `./simulator -r checkpoint.bin 2>&1`;
+	# the resumed run starts with its own banner
+	$full =~ s/^.*?(?==== \[TIME $time\] ===)//s;
+	$resumed =~ s/^.*?(?==== \[TIME $time\] ===)//s;
+	if($resumed !~ /^=== / || $full ne $resumed){
+		print "Run \"$args $file\" resumed at time $time differs\n";
+		$failed = 1;
+	}
+}
+
+# a checkpoint with another version, or cut short, is refused
+`./simulator -c 2 -s psjf -k 3:checkpoint.bin examples/proc4.csv 2>&1`;
+open(CHECKPOINT, "+<", "checkpoint.bin");
+binmode(CHECKPOINT);
+seek(CHECKPOINT, 8, 0);   # the version follows the 8-byte magic
+print CHECKPOINT pack("l", -1);
+close(CHECKPOINT);
+$error = `./simulator -r checkpoint.bin 2>&1`;
+if($error !~ /is not a checkpoint written by this simulator/){
+	print "A checkpoint with another version was not refused\n$error";
+	$failed = 1;
+}
+`./simulator -c 2 -s psjf -k 3:checkpoint.bin examples/proc4.csv 2>&1`;
+truncate("checkpoint.bin", (-s "checkpoint.bin") - 4);
+$error = `./simulator -r checkpoint.bin 2>&1`;
+if($error !~ /is not a checkpoint written by this simulator/){
+	print "A truncated checkpoint was not refused\n$error";
+	$failed = 1;
+}
+#cleanup
+`rm -f checkpoint.bin`;
+exit $failed;
@@ -0,0 +1,20 @@
+#!/usr/bin/perl
+
+# A cluster of one node is the plain simulator behind a dispatcher, so both
+# must report the same averages. Only traces without same-time arrivals are
+# compared: the simulator submits a time unit's arrivals in the order its job
+# list holds them, which changes as jobs finish, and the dispatcher submits
+# them in job order.
+
+$failed = 0;
+for $scheme ("fcfs", "sjf", "psjf", "pri", "ppri"){
+	for $file ("examples/proc1.csv", "examples/proc2.csv", "examples/proc3.csv"){
+		$cluster = `./simulator -N 1 -c 2 -s $scheme $file | grep ^Average`;
+		$single = `./simulator -c 2 -s $scheme $file | grep ^Average`;
+		if($cluster eq "" || $cluster ne $single){
+			print "One node with \"-c 2 -s $scheme $file\" differs from the simulator\n$cluster$single";
+			$failed = 1;
+		}
+	}
+}
+exit $failed;
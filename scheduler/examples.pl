@@ -3,6 +3,7 @@
 # EECS678
 # Adopted from CS 241 @ The University of Illinois
 
+$failed = 0;
 for $file (<examples/*>){
 	if( $file =~ /proc(\d+)-c(\d+)-(\w+)\.out/){
 	#	print "Proc $1 CORE $2 Proc $3\n";
@@ -11,8 +12,27 @@ for $file (<examples/*>){
 		$diff = `diff output1 output2`;
 		if($diff){
 			print "Test file $file differs\n$diff";
+			$failed = 1;
 		}
 	}
 }
+# Runs that need more than a core count and a scheme: each line of
+# examples/NAME.cmd holds the simulator's arguments, or a whole command when it
+# does not start with -, and examples/NAME.out everything the lines print in
+# turn, including any error message
+for $file (<examples/*.cmd>){
+	($out = $file) =~ s/\.cmd$/.out/;
+	`rm -f output1`;
+	for $args (split(/\n/, `cat $file`)){
+		$command = $args =~ /^-/ ? "./simulator $args" : $args;
+		`$command >> output1 2>&1`;
+	}
+	$diff = `diff output1 $out`;
+	if($diff){
+		print "Test file $out differs\n$diff";
+		$failed = 1;
+	}
+}
 #cleanup
-`rm output1 output2`;
+`rm -f output1 output2 events.bin joblog.csv joblog.bin telemetry.csv`;
+exit $failed;
@@ -0,0 +1 @@
+-c 1 -s rr12:2 examples/proc1.csv
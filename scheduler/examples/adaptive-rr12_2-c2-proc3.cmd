@@ -0,0 +1 @@
+-c 2 -s rr12:2 examples/proc3.csv
@@ -0,0 +1 @@
+-c 2 -s rr8:1 examples/proc4.csv
@@ -0,0 +1 @@
+-c 1 -s ppri -a 3 examples/starve.csv
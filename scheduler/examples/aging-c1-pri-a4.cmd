@@ -0,0 +1 @@
+-c 1 -s pri -a 4 examples/starve.csv
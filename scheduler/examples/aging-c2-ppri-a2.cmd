@@ -0,0 +1 @@
+-c 2 -s ppri -a 2 examples/starve.csv
@@ -0,0 +1 @@
+-N 3 -c 2 -s fcfs -d jsq -t 1 examples/proc3.csv
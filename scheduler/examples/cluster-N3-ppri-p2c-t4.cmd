@@ -0,0 +1 @@
+-N 3 -c 2 -s ppri -d p2c -t 4 examples/proc3.csv
@@ -0,0 +1 @@
+-N 3 -c 2 -s psjf -d random -t 4 examples/proc3.csv
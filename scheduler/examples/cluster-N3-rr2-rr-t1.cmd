@@ -0,0 +1 @@
+-N 3 -c 2 -s rr2 -d rr -t 1 examples/proc3.csv
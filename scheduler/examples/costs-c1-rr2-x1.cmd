@@ -0,0 +1 @@
+-c 1 -s rr2 -x 1 examples/proc1.csv
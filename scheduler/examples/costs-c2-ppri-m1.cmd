@@ -0,0 +1 @@
+-c 2 -s ppri -m 1 examples/proc2.csv
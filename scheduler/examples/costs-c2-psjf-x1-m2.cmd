@@ -0,0 +1 @@
+-c 2 -s psjf -x 1 -m 2 examples/proc4.csv
@@ -0,0 +1 @@
+-c 1 -s psjf examples/dag.csv
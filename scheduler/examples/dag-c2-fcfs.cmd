@@ -0,0 +1 @@
+-c 2 -s fcfs examples/dag.csv
@@ -0,0 +1 @@
+-c 2 -s fcfs -k 3:checkpoint.bin examples/dag.csv
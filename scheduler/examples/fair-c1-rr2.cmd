@@ -0,0 +1 @@
+-c 1 -s rr2 -f 4 examples/fair.csv
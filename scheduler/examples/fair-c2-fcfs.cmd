@@ -0,0 +1 @@
+-c 2 -s fcfs -f 8 -W 1:2,2:1 examples/fair.csv
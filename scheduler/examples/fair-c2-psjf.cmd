@@ -0,0 +1 @@
+-c 2 -s psjf -f 0 -W 0:3 examples/fair.csv
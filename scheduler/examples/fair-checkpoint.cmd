@@ -0,0 +1 @@
+-c 2 -s fcfs -f 8 -k 3:checkpoint.bin examples/fair.csv
@@ -0,0 +1 @@
+-c 2 -s fcfs -g easy examples/gang.csv
@@ -0,0 +1 @@
+-c 4 -s fcfs -g easy examples/gang.csv
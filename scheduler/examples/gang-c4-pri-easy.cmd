@@ -0,0 +1 @@
+-c 4 -s pri -g easy examples/gang.csv
@@ -0,0 +1 @@
+-c 4 -s rr2 examples/gang.csv
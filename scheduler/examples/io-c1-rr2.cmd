@@ -0,0 +1 @@
+-c 1 -s rr2 examples/io.csv
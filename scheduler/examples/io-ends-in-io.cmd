@@ -0,0 +1 @@
+-c 1 -s fcfs examples/io-ends-in-io.csv
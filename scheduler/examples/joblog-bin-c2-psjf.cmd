@@ -0,0 +1,2 @@
+-c 2 -s psjf -Q -j joblog.bin examples/proc4.csv
+od -A n -t d4 -w24 -v joblog.bin
@@ -0,0 +1,2 @@
+-c 2 -s psjf -Q -j joblog.csv examples/proc4.csv
+cat joblog.csv
@@ -0,0 +1 @@
+-c 2 -s psjf -P -Q examples/proc3.csv
@@ -0,0 +1 @@
+-c 2 -s rr2 -P -Q examples/proc4.csv
@@ -0,0 +1 @@
+-c 2 -s psjf examples/psjf-remaining.csv
@@ -0,0 +1 @@
+-c 2 -s ppri -q least examples/proc2.csv
@@ -0,0 +1 @@
+-c 4 -s fcfs -q rr -v busiest -M 2 examples/proc4.csv
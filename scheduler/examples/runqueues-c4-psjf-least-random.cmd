@@ -0,0 +1 @@
+-c 4 -s psjf -q least -v random examples/proc4.csv
@@ -0,0 +1 @@
+-c 4 -s rr2 -q rr examples/proc4.csv
@@ -0,0 +1,2 @@
+-c 1 -s rr2 -Q -e events.bin examples/io.csv
+./schedview -q 6 events.bin
@@ -0,0 +1,2 @@
+-c 2 -s rr2 -Q -e events.bin examples/proc4.csv
+./schedview -r -f 5 -t 8 events.bin
@@ -0,0 +1,2 @@
+-c 2 -s rr2 -Q -e events.bin examples/proc4.csv
+./schedview -f 5 -t 12 -s events.bin
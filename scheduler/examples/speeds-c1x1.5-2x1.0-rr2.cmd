@@ -0,0 +1 @@
+-c 1:1.5,2:1.0 -s rr2 examples/proc2.csv
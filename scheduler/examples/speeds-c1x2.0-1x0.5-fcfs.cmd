@@ -0,0 +1 @@
+-c 1:2.0,1:0.5 -s fcfs examples/proc1.csv
@@ -0,0 +1 @@
+-c 2:2.0,2:1.0 -s psjf examples/proc4.csv
@@ -0,0 +1 @@
+-c 1 -s ppri examples/starve.csv
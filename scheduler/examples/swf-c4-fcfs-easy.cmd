@@ -0,0 +1 @@
+-c 4 -s fcfs -g easy -S 10 examples/trace.swf
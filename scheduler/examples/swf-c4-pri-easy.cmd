@@ -0,0 +1 @@
+-c 4 -s pri -g easy -S 5 examples/trace.swf
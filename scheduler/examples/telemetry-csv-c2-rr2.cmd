@@ -0,0 +1,2 @@
+-c 2 -s rr2 -Q -T telemetry.csv examples/proc4.csv
+cat telemetry.csv
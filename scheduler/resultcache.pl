@@ -0,0 +1,73 @@
+#!/usr/bin/perl
+
+# Runs the simulator with -C and checks that a repeated run is answered from
+# the cache with exactly what it printed the first time, errors included,
+# that a changed input misses, that an unusable cache directory only costs
+# the caching, and that entries from another build are deleted
+
+$failed = 0;
+$dir = "/tmp/resultcache-test.$$";
+`rm -rf $dir; mkdir -p $dir/cache; cp examples/proc4.csv $dir/input.csv`;
+`touch $dir/cache/notes.txt $dir/cache/0123456789abcdef-0123456789abcdef.result`;
+
+sub check {
+	my ($what, $ok) = @_;
+	if(!$ok){
+		print "Result cache: $what\n";
+		$failed = 1;
+	}
+}
+
+# Returns stdout, then a separator, then stderr, then the exit status
+sub run {
+	my ($args) = @_;
+	my $output = `./simulator $args 2>$dir/stderr`;
+	my $status = $? >> 8;
+	return $output . "--- stderr\n" . `cat $dir/stderr` . "--- status $status\n";
+}
+
+sub entries {
+	opendir(my $cache, "$dir/cache");
+	my @names = sort grep(/\.result$/, readdir($cache));
+	closedir($cache);
+	return @names;
+}
+
+$args = "-c 2 -s rr2 $dir/input.csv";
+$plain = run($args);
+$first = run("-C $dir/cache $args");
+@stored = entries();
+$inode = (stat("$dir/cache/$stored[0]"))[1];
+$second = run("-C $dir/cache $args");
+check("the first run differs from an uncached run\n$first$plain", $first eq $plain);
+check("the second run differs from the first\n$second$first", $second eq $first);
+check("expected one entry, found @stored", @stored == 1);
+check("another build's entry was not deleted", !-e "$dir/cache/0123456789abcdef-0123456789abcdef.result");
+check("a file that is not an entry was deleted", -e "$dir/cache/notes.txt");
+check("the second run stored its entry again instead of hitting", (stat("$dir/cache/$stored[0]"))[1] == $inode);
+
+`echo 20,3,1 >> $dir/input.csv`;
+$edited = run("-C $dir/cache $args");
+check("an edited input was answered from the cache", $edited ne $first);
+check("an edited input differs from an uncached run\n$edited", $edited eq run($args));
+check("an edited input was not stored", entries() == 2);
+
+# A trace with jobs that never ran prints a notice on stderr
+$args = "-c 4 -s fcfs -g easy -S 10 examples/trace.swf";
+$plain = run($args);
+$first = run("-C $dir/cache $args");
+$second = run("-C $dir/cache $args");
+check("the SWF notice was not printed", $plain =~ /^Skipped/m);
+check("a cached SWF run differs from an uncached run\n$second$plain", $first eq $plain && $second eq $plain);
+
+# The cache directory would have to be made inside a file
+`touch $dir/file`;
+$args = "-c 2 -s psjf examples/proc3.csv";
+$plain = run($args);
+$fallback = run("-C $dir/file/cache $args");
+($fallback_output = $fallback) =~ s/^Unable to write to the result cache in "[^"]*"; running without it.\n//m;
+check("an unusable cache directory did not fall back to simulating\n$fallback", $fallback ne $fallback_output && $fallback_output eq $plain);
+
+#cleanup
+`rm -rf $dir`;
+exit $failed;
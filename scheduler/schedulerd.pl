@@ -0,0 +1,35 @@
+#!/usr/bin/perl
+
+# Starts schedulerd on a temporary socket, checks which requests it refuses,
+# then replays workloads through it with schedulerdbench -V, which fails on
+# any decision that differs from the library's own.
+
+$socket = "/tmp/schedulerd-test.$$.sock";
+$failed = 0;
+
+$daemon = open(DAEMON, "./schedulerd $socket |") or die "Unable to start schedulerd\n";
+$listening = <DAEMON>;
+if($listening !~ /^Listening/){
+	print "schedulerd did not start listening on $socket\n";
+	exit 1;
+}
+
+# Must be the daemon's first client: it checks requests made before START_UP
+if(system("./schedulerdtest $socket") != 0){
+	$failed = 1;
+}
+
+for $args ("-c 4 -s fcfs -p 1", "-c 4 -s sjf", "-c 4 -s psjf", "-c 4 -s pri", "-c 4 -s ppri",
+		"-c 4 -s rr2", "-c 4 -s stride3", "-c 4 -s lottery2", "-c 16 -s psjf -r 4 -p 8"){
+	$output = `./schedulerdbench $args -n 2000 -V $socket 2>&1`;
+	if($? != 0 || $output !~ /^Decisions differing from the library: 0$/m){
+		print "schedulerdbench $args -V differs from the library\n$output";
+		$failed = 1;
+	}
+}
+
+#cleanup
+kill("TERM", $daemon);
+close(DAEMON);
+unlink($socket);
+exit $failed;
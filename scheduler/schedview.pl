@@ -0,0 +1,30 @@
+#!/usr/bin/perl
+
+# Records each run's event log with -e and checks that schedview draws the
+# same timing diagram as the simulator's FINAL TIMING DIAGRAM
+
+$failed = 0;
+@runs = (
+	"-c 2 -s fcfs examples/proc1.csv",
+	"-c 2 -s psjf examples/proc3.csv",
+	"-c 4 -s ppri examples/proc4.csv",
+	"-c 2 -s rr2 examples/proc4.csv",
+	"-c 2 -s stride2 examples/proc2.csv",
+	"-c 2 -s rr12:2 examples/proc3.csv",
+	"-c 1 -s rr2 examples/io.csv",
+	"-c 4 -s fcfs -g easy examples/gang.csv",
+	"-c 4 -s psjf -q least -v random examples/proc4.csv",
+);
+for $args (@runs){
+	$simulated = `./simulator $args -e events.bin`;
+	$viewed = `./schedview -d events.bin`;
+	$simulated =~ s/.*FINAL TIMING DIAGRAM:\n((?:  Core [^\n]*\n)+).*/$1/s;
+	$viewed =~ s/.*TIMING DIAGRAM \(time units 0 to \d+\):\n((?:  Core [^\n]*\n)+).*/$1/s;
+	if($simulated !~ /^  Core / || $simulated ne $viewed){
+		print "schedview draws \"$args\" differently\n$simulated$viewed";
+		$failed = 1;
+	}
+}
+#cleanup
+`rm -f events.bin`;
+exit $failed;
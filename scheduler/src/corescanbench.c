@@ -0,0 +1,318 @@
+/** @file corescanbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libscheduler/libscheduler.h"
+#include "libpriqueue/libpriqueue.h"
+#include "libcorescan/libcorescan.h"
+
+/*
+ * Benchmark of the searches a preemptive scheduler makes when a job arrives
+ * and every core is busy: the core whose job has the most time left (PSJF),
+ * the core whose job has the worst priority (PPRI), and the first idle core.
+ *
+ * Each is timed three ways: walking the running jobs with priqueue_at(), as
+ * the list path of scheduler_new_job() does for PPRI; walking an array of
+ * pointers to them, as the ready-set path did; and over per-core arrays
+ * with every libcorescan kernel this CPU runs. All of them must pick the
+ * same core.
+ */
+
+#define QUERIES 256
+#define MIN_SECONDS 0.2
+
+// Laid out like the scheduler's job_t: the fields read here, then a cold line
+typedef struct _bench_job_t
+{
+	int job_id, core_id, priority, last_checked_time;
+	long long work;
+	char cold[104];
+} bench_job_t;
+
+typedef struct _bench_t
+{
+	int cores;
+	priqueue_t queue;          // the running jobs, in core order
+	bench_job_t **running;
+	int *speed;
+	long long *finish, *banked;
+	int *priority;
+	int *avail;                // one idle core per query, see idle_core
+	int times[QUERIES];        // when each query is made
+	int idle_core[QUERIES];
+} bench_t;
+
+static unsigned long long rng = 0x9E3779B97F4A7C15ULL;
+
+static unsigned int next_random()
+{
+	rng ^= rng >> 12;
+	rng ^= rng << 25;
+	rng ^= rng >> 27;
+	return (unsigned int)((rng * 2685821657736338717ULL) >> 32);
+}
+
+static long long now_ns()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static int keep_order(const void *a, const void *b)
+{
+	return 0;
+}
+
+static long long remaining_time_scaled(bench_job_t *job, int *speed, int time)
+{
+	int elapsed = time - job->last_checked_time;
+	long long work = elapsed > 0 ? job->work - (long long)elapsed * speed[job->core_id] : job->work;
+	return work * CORE_SPEED_UNIT / speed[job->core_id];
+}
+
+/*
+ * Jobs are picked at random from a pool four times their number, so walking
+ * them misses the cache the way walking live jobs does. Dispatch times run
+ * past the query times, so some cores are still paying dispatch overhead,
+ * and run times are few enough that ties are common.
+ */
+static void bench_init(bench_t *bench, int cores, bench_job_t *pool)
+{
+	int i;
+	bench->cores = cores;
+	priqueue_init(&bench->queue, keep_order);
+	bench->running = malloc(cores * sizeof(bench_job_t *));
+	bench->speed = malloc(cores * sizeof(int));
+	bench->finish = malloc(cores * sizeof(long long));
+	bench->banked = malloc(cores * sizeof(long long));
+	bench->priority = malloc(cores * sizeof(int));
+	bench->avail = malloc(cores * sizeof(int));
+
+	for (i = 0; i < cores; i++)
+	{
+		bench_job_t *job;
+		do
+			job = &pool[next_random() % (4 * cores)];
+		while (job->core_id != -1);
+		job->job_id = i;
+		job->core_id = i;
+		job->priority = next_random() % 10;
+		job->last_checked_time = next_random() % 1200;
+		job->work = (2000 + next_random() % 64) * (long long)CORE_SPEED_UNIT;
+		bench->running[i] = job;
+		bench->speed[i] = CORE_SPEED_UNIT;
+
+		bench->banked[i] = job->work * CORE_SPEED_UNIT / bench->speed[i];
+		bench->finish[i] = bench->banked[i] + (long long)job->last_checked_time * CORE_SPEED_UNIT;
+		bench->priority[i] = job->priority;
+		bench->avail[i] = 1;
+	}
+	priqueue_append_all(&bench->queue, (void **)bench->running, cores);
+	for (i = 0; i < QUERIES; i++)
+	{
+		bench->times[i] = 1000 + next_random() % 100;
+		// every eighth query finds no idle core
+		bench->idle_core[i] = i % 8 == 7 ? -1 : (int)(next_random() % cores);
+	}
+}
+
+static void bench_destroy(bench_t *bench)
+{
+	for (int i = 0; i < bench->cores; i++)
+		bench->running[i]->core_id = -1;
+	priqueue_destroy(&bench->queue);
+	free(bench->running);
+	free(bench->speed);
+	free(bench->finish);
+	free(bench->banked);
+	free(bench->priority);
+	free(bench->avail);
+}
+
+/*  **---SEARCHES---** */
+
+static int longest_listed(bench_t *bench, int query)
+{
+	int best = 0;
+	long long best_left = -1;
+	for (int j = 0; j < bench->cores; j++)
+	{
+		bench_job_t *job = priqueue_at(&bench->queue, j);
+		long long left = remaining_time_scaled(job, bench->speed, bench->times[query]);
+		if (left > best_left)
+		{
+			best_left = left;
+			best = job->core_id;
+		}
+	}
+	return best;
+}
+
+static int longest_pointers(bench_t *bench, int query)
+{
+	int best = 0;
+	for (int j = 1; j < bench->cores; j++)
+	{
+		if (remaining_time_scaled(bench->running[j], bench->speed, bench->times[query]) >
+				remaining_time_scaled(bench->running[best], bench->speed, bench->times[query]))
+			best = j;
+	}
+	return best;
+}
+
+static int longest_arrays(bench_t *bench, int query)
+{
+	return corescan_longest(bench->finish, bench->banked, bench->cores, (long long)bench->times[query] * CORE_SPEED_UNIT);
+}
+
+static int highest_listed(bench_t *bench, int query)
+{
+	int best = 0, worst = -1;
+	for (int j = 0; j < bench->cores; j++)
+	{
+		bench_job_t *job = priqueue_at(&bench->queue, j);
+		if (job->priority > worst)
+		{
+			worst = job->priority;
+			best = job->core_id;
+		}
+	}
+	return best;
+}
+
+static int highest_pointers(bench_t *bench, int query)
+{
+	int best = 0;
+	for (int j = 1; j < bench->cores; j++)
+	{
+		if (bench->running[j]->priority > bench->running[best]->priority)
+			best = j;
+	}
+	return best;
+}
+
+static int highest_arrays(bench_t *bench, int query)
+{
+	return corescan_highest(bench->priority, bench->cores);
+}
+
+// the idle search has no list form; the loop is the one pick_idle_core() had
+static int idle_loop(bench_t *bench, int query)
+{
+	int best = -1;
+	for (int i = 0; i < bench->cores; i++)
+	{
+		if (bench->avail[i] == 0 && (best == -1 || bench->speed[i] > bench->speed[best]))
+			best = i;
+	}
+	return best;
+}
+
+static int idle_arrays(bench_t *bench, int query)
+{
+	return corescan_first_zero(bench->avail, bench->cores);
+}
+
+/*
+ * Runs all the queries until MIN_SECONDS have passed, storing what the first
+ * pass picked, and returns the nanoseconds per search.
+ */
+static double time_search(bench_t *bench, int (*search)(bench_t *, int), int *picked)
+{
+	long long start = now_ns(), elapsed;
+	long long searches = 0;
+	int pass = 0;
+	do
+	{
+		for (int i = 0; i < QUERIES; i++)
+		{
+			int idle = bench->idle_core[i];
+			if (idle != -1)
+				bench->avail[idle] = 0;
+			int core = search(bench, i);
+			if (idle != -1)
+				bench->avail[idle] = 1;
+			if (pass == 0)
+				picked[i] = core;
+		}
+		searches += QUERIES;
+		pass++;
+		elapsed = now_ns() - start;
+	} while (elapsed < MIN_SECONDS * 1e9);
+	return (double)elapsed / searches;
+}
+
+int main(int argc, char **argv)
+{
+	int c, only_cores = 0;
+
+	while ((c = getopt(argc, argv, "c:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': only_cores = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-c <cores>]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (only_cores < 0)
+	{
+		fprintf(stderr, "-c requires a positive number.\n");
+		return 1;
+	}
+
+	corescan_kernel_t detected = corescan_kernel();
+	printf("Kernel picked at startup: %s\n\n", corescan_kernel_name(detected));
+	printf("%6s %-20s %14s %14s %14s\n", "cores", "search over", "longest ns", "worst pri ns", "first idle ns");
+
+	int expected[3][QUERIES], picked[3][QUERIES];
+	int mismatches = 0;
+	for (int cores = only_cores > 0 ? only_cores : 64; cores <= (only_cores > 0 ? only_cores : 4096); cores *= 4)
+	{
+		bench_job_t *pool = malloc(4 * cores * sizeof(bench_job_t));
+		bench_t bench;
+		int i;
+		for (i = 0; i < 4 * cores; i++)
+			pool[i].core_id = -1;
+		bench_init(&bench, cores, pool);
+
+		double listed[2], pointers[3], arrays[3];
+		listed[0] = time_search(&bench, longest_listed, expected[0]);
+		listed[1] = time_search(&bench, highest_listed, expected[1]);
+		printf("%6d %-20s %14.1f %14.1f %14s\n", cores, "priqueue_at()", listed[0], listed[1], "-");
+
+		pointers[0] = time_search(&bench, longest_pointers, picked[0]);
+		pointers[1] = time_search(&bench, highest_pointers, picked[1]);
+		pointers[2] = time_search(&bench, idle_loop, expected[2]);
+		printf("%6d %-20s %14.1f %14.1f %14.1f\n", cores, "running[] pointers", pointers[0], pointers[1], pointers[2]);
+		for (i = 0; i < QUERIES; i++)
+			mismatches += (picked[0][i] != expected[0][i]) + (picked[1][i] != expected[1][i]);
+
+		for (corescan_kernel_t kernel = CORESCAN_SCALAR; kernel < CORESCAN_KERNELS; kernel++)
+		{
+			char label[32];
+			if (corescan_select(kernel) != 0)
+				continue;
+			arrays[0] = time_search(&bench, longest_arrays, picked[0]);
+			arrays[1] = time_search(&bench, highest_arrays, picked[1]);
+			arrays[2] = time_search(&bench, idle_arrays, picked[2]);
+			snprintf(label, sizeof(label), "arrays, %s", corescan_kernel_name(kernel));
+			printf("%6d %-20s %14.1f %14.1f %14.1f\n", cores, label, arrays[0], arrays[1], arrays[2]);
+			for (i = 0; i < QUERIES; i++)
+				mismatches += (picked[0][i] != expected[0][i]) + (picked[1][i] != expected[1][i]) + (picked[2][i] != expected[2][i]);
+		}
+		corescan_select(detected);
+
+		bench_destroy(&bench);
+		free(pool);
+	}
+
+	printf("\nSearches picking a different core: %d\n", mismatches);
+	return mismatches > 0 ? 3 : 0;
+}
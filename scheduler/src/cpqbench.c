@@ -0,0 +1,159 @@
+/** @file cpqbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "libpriqueue/libpriqueue.h"
+#include "libcpriqueue/libcpriqueue.h"
+
+/*
+ * Scaling benchmark using the classic "hold" model: every thread repeatedly
+ * polls an element and offers a new one whose key is the polled key plus a
+ * random increment, the way a scheduler requeues work with later deadlines.
+ * cpriqueue_t is compared against priqueue_t behind a mutex.
+ */
+
+#define PREFILL 1024
+
+typedef struct _bench_thread_t
+{
+	pthread_t thread;
+	int *keys;        // storage for the elements this thread offers
+	int *increments;
+	int ops;
+} bench_thread_t;
+
+int compare1(const void * a, const void * b)
+{
+	return ( *(int*)a - *(int*)b );
+}
+
+static priqueue_t locked_queue;
+static pthread_mutex_t locked_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static cpriqueue_t relaxed_queue;
+
+static double now_seconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void *locked_worker(void *arg)
+{
+	bench_thread_t *self = (bench_thread_t *)arg;
+	int i;
+	for (i = 0; i < self->ops; i++)
+	{
+		pthread_mutex_lock(&locked_queue_lock);
+		int *polled = priqueue_poll(&locked_queue);
+		pthread_mutex_unlock(&locked_queue_lock);
+
+		self->keys[i] = (polled != NULL ? *polled : 0) + self->increments[i];
+
+		pthread_mutex_lock(&locked_queue_lock);
+		priqueue_offer(&locked_queue, &self->keys[i]);
+		pthread_mutex_unlock(&locked_queue_lock);
+	}
+	return NULL;
+}
+
+static void *relaxed_worker(void *arg)
+{
+	bench_thread_t *self = (bench_thread_t *)arg;
+	int i;
+	for (i = 0; i < self->ops; i++)
+	{
+		int *polled = cpriqueue_poll(&relaxed_queue);
+		self->keys[i] = (polled != NULL ? *polled : 0) + self->increments[i];
+		cpriqueue_offer(&relaxed_queue, &self->keys[i]);
+	}
+	return NULL;
+}
+
+static double run(int threads, int ops, int *prefill, bench_thread_t *workers, void *(*worker)(void *))
+{
+	int i;
+	for (i = 0; i < PREFILL; i++)
+	{
+		if (worker == locked_worker)
+			priqueue_offer(&locked_queue, &prefill[i]);
+		else
+			cpriqueue_offer(&relaxed_queue, &prefill[i]);
+	}
+
+	double start = now_seconds();
+	for (i = 0; i < threads; i++)
+		pthread_create(&workers[i].thread, NULL, worker, &workers[i]);
+	for (i = 0; i < threads; i++)
+		pthread_join(workers[i].thread, NULL);
+	// every iteration is one poll and one offer
+	return 2.0 * threads * ops / (now_seconds() - start) / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	int c, max_threads = 64, ops = 100000;
+
+	while ((c = getopt(argc, argv, "t:n:")) != -1)
+	{
+		switch (c)
+		{
+			case 't': max_threads = atoi(optarg); break;
+			case 'n': ops = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-t <max threads>] [-n <poll/offer pairs per thread>]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (max_threads <= 0 || ops <= 0)
+	{
+		fprintf(stderr, "All options require a positive number.\n");
+		return 1;
+	}
+
+	int *prefill = malloc(PREFILL * sizeof(int));
+	bench_thread_t *workers = malloc(max_threads * sizeof(bench_thread_t));
+	int i, threads;
+
+	srand(678);
+	for (i = 0; i < PREFILL; i++)
+		prefill[i] = rand() % 1000;
+	for (i = 0; i < max_threads; i++)
+	{
+		workers[i].ops = ops;
+		workers[i].keys = malloc(ops * sizeof(int));
+		workers[i].increments = malloc(ops * sizeof(int));
+		for (c = 0; c < ops; c++)
+			workers[i].increments[c] = rand() % 1000;
+	}
+
+	printf("%d poll/offer pair(s) per thread, %d prefilled element(s)\n\n", ops, PREFILL);
+	printf("%8s %22s %22s\n", "threads", "mutex+priqueue Mops/s", "cpriqueue Mops/s");
+
+	for (threads = 1; threads <= max_threads; threads *= 2)
+	{
+		priqueue_init(&locked_queue, compare1);
+		double locked = run(threads, ops, prefill, workers, locked_worker);
+		priqueue_destroy(&locked_queue);
+
+		cpriqueue_init(&relaxed_queue, 4 * threads, compare1);
+		double relaxed = run(threads, ops, prefill, workers, relaxed_worker);
+		cpriqueue_destroy(&relaxed_queue);
+
+		printf("%8d %22.2f %22.2f\n", threads, locked, relaxed);
+	}
+
+	for (i = 0; i < max_threads; i++)
+	{
+		free(workers[i].keys);
+		free(workers[i].increments);
+	}
+	free(workers);
+	free(prefill);
+	return 0;
+}
@@ -0,0 +1,104 @@
+/** @file cpqtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "libcpriqueue/libcpriqueue.h"
+
+#define THREADS 8
+#define PER_THREAD 20000
+
+int compare1(const void * a, const void * b)
+{
+	return ( *(int*)a - *(int*)b );
+}
+
+cpriqueue_t stress_queue;
+int *values;
+atomic_int *seen;
+atomic_int popped;
+
+void *producer(void *arg)
+{
+	int t = (int)(long)arg;
+	int i;
+	for (i = 0; i < PER_THREAD; i++)
+		cpriqueue_offer(&stress_queue, &values[i * THREADS + t]);
+	return NULL;
+}
+
+void *consumer(void *arg)
+{
+	while (atomic_load(&popped) < THREADS * PER_THREAD)
+	{
+		int *value = cpriqueue_poll(&stress_queue);
+		if (value != NULL)
+		{
+			atomic_fetch_add(&seen[*value], 1);
+			atomic_fetch_add(&popped, 1);
+		}
+	}
+	return NULL;
+}
+
+int main()
+{
+	cpriqueue_t q;
+	int i, total = THREADS * PER_THREAD;
+
+	values = malloc(total * sizeof(int));
+	for (i = 0; i < total; i++)
+		values[i] = i;
+
+	/* A single shard is a strict priority queue. */
+	cpriqueue_init(&q, 1, compare1);
+	for (i = 0; i < 100; i++)
+		cpriqueue_offer(&q, &values[(i * 37) % 100]);
+	printf("Total elements: %d (expected 100).\n", cpriqueue_size(&q));
+
+	int in_order = 1;
+	for (i = 0; i < 100; i++)
+		if (*(int *)cpriqueue_poll(&q) != i)
+			in_order = 0;
+	printf("Single shard polls in order: %s (expected yes).\n", in_order ? "yes" : "no");
+	printf("Poll on empty queue: %s (expected NULL).\n", cpriqueue_poll(&q) == NULL ? "NULL" : "element");
+	cpriqueue_destroy(&q);
+
+	/* Many shards, many producers and consumers at once. */
+	seen = malloc(total * sizeof(atomic_int));
+	for (i = 0; i < total; i++)
+		atomic_init(&seen[i], 0);
+	atomic_init(&popped, 0);
+	cpriqueue_init(&stress_queue, 4 * THREADS, compare1);
+
+	pthread_t threads[2 * THREADS];
+	for (i = 0; i < THREADS; i++)
+	{
+		pthread_create(&threads[i], NULL, producer, (void *)(long)i);
+		pthread_create(&threads[THREADS + i], NULL, consumer, NULL);
+	}
+	for (i = 0; i < 2 * THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	int missing = 0, duplicated = 0;
+	for (i = 0; i < total; i++)
+	{
+		if (atomic_load(&seen[i]) == 0)
+			missing++;
+		else if (atomic_load(&seen[i]) > 1)
+			duplicated++;
+	}
+	printf("Elements polled under contention: %d (expected %d).\n", atomic_load(&popped), total);
+	printf("Missing elements: %d (expected 0).\n", missing);
+	printf("Duplicated elements: %d (expected 0).\n", duplicated);
+	printf("Total elements: %d (expected 0).\n", cpriqueue_size(&stress_queue));
+
+	cpriqueue_destroy(&stress_queue);
+	free(seen);
+	free(values);
+
+	return 0;
+}
@@ -0,0 +1,220 @@
+/** @file executorbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "libexecutor/libexecutor.h"
+
+/*
+ * Throughput benchmark of libexecutor against a plain FIFO thread pool.
+ *
+ * Every task spins for a fixed number of iterations; under RR it also polls
+ * executor_should_yield() and resumes where it left off.
+ */
+
+typedef struct _bench_task_t
+{
+	long long submitted, started;
+	int iterations, done;
+} bench_task_t;
+
+static unsigned long long sink;
+
+static long long now_ns()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static int run_bench_task(void *arg)
+{
+	bench_task_t *task = (bench_task_t *)arg;
+	if (task->started == 0)
+		task->started = now_ns();
+
+	unsigned long long acc = 0;
+	while (task->done < task->iterations)
+	{
+		acc += task->done * 2654435761ULL;
+		task->done++;
+		if ((task->done & 63) == 0 && executor_should_yield())
+		{
+			__atomic_fetch_add(&sink, acc, __ATOMIC_RELAXED);
+			return 1;
+		}
+	}
+	__atomic_fetch_add(&sink, acc, __ATOMIC_RELAXED);
+	return 0;
+}
+
+
+/*
+ * Baseline: N threads pulling closures from one mutex-protected FIFO.
+ */
+typedef struct _fifo_pool_t
+{
+	pthread_mutex_t lock;
+	pthread_cond_t nonempty, drained;
+	bench_task_t **items;
+	int head, tail, capacity, pending, stopping;
+} fifo_pool_t;
+
+static void *fifo_worker(void *arg)
+{
+	fifo_pool_t *pool = (fifo_pool_t *)arg;
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->lock);
+		while (pool->head == pool->tail && !pool->stopping)
+			pthread_cond_wait(&pool->nonempty, &pool->lock);
+		if (pool->head == pool->tail)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		bench_task_t *task = pool->items[pool->head++ % pool->capacity];
+		pthread_mutex_unlock(&pool->lock);
+
+		run_bench_task(task);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->pending == 0)
+			pthread_cond_signal(&pool->drained);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+static double run_fifo(int workers, bench_task_t *tasks, int count)
+{
+	fifo_pool_t pool;
+	pthread_t *threads = malloc(workers * sizeof(pthread_t));
+	int i;
+
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.nonempty, NULL);
+	pthread_cond_init(&pool.drained, NULL);
+	pool.capacity = count;
+	pool.items = malloc(count * sizeof(bench_task_t *));
+	pool.head = pool.tail = pool.pending = pool.stopping = 0;
+
+	for (i = 0; i < workers; i++)
+		pthread_create(&threads[i], NULL, fifo_worker, &pool);
+
+	long long start = now_ns();
+	for (i = 0; i < count; i++)
+	{
+		tasks[i].submitted = now_ns();
+		pthread_mutex_lock(&pool.lock);
+		pool.items[pool.tail++ % pool.capacity] = &tasks[i];
+		pool.pending++;
+		pthread_cond_signal(&pool.nonempty);
+		pthread_mutex_unlock(&pool.lock);
+	}
+	pthread_mutex_lock(&pool.lock);
+	while (pool.pending > 0)
+		pthread_cond_wait(&pool.drained, &pool.lock);
+	pool.stopping = 1;
+	pthread_cond_broadcast(&pool.nonempty);
+	pthread_mutex_unlock(&pool.lock);
+	long long elapsed = now_ns() - start;
+
+	for (i = 0; i < workers; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	free(pool.items);
+	return elapsed / 1e9;
+}
+
+static double run_executor(int workers, scheme_t scheme, bench_task_t *tasks, int count)
+{
+	int i;
+	if (executor_start(workers, scheme, 50) != 0)
+		return -1;
+
+	long long start = now_ns();
+	for (i = 0; i < count; i++)
+	{
+		tasks[i].submitted = now_ns();
+		executor_submit(run_bench_task, &tasks[i], tasks[i].iterations, i % 4 + 1);
+	}
+	executor_wait();
+	long long elapsed = now_ns() - start;
+
+	executor_shutdown();
+	return elapsed / 1e9;
+}
+
+static void report(const char *name, double seconds, bench_task_t *tasks, int count)
+{
+	long long latency = 0;
+	int i, finished = 0;
+	for (i = 0; i < count; i++)
+	{
+		if (tasks[i].done == tasks[i].iterations)
+			finished++;
+		latency += tasks[i].started - tasks[i].submitted;
+	}
+	printf("%-8s %10d %12.0f %18.2f\n", name, finished, count / seconds, latency / 1000.0 / count);
+}
+
+static void reset(bench_task_t *tasks, int count, int iterations)
+{
+	int i;
+	for (i = 0; i < count; i++)
+	{
+		tasks[i].submitted = tasks[i].started = 0;
+		tasks[i].done = 0;
+		// vary the work so SJF has something to order
+		tasks[i].iterations = iterations / 2 + (i * 7919) % (iterations + 1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int c, workers = 4, count = 100000, iterations = 2000;
+
+	while ((c = getopt(argc, argv, "w:n:k:")) != -1)
+	{
+		switch (c)
+		{
+			case 'w': workers = atoi(optarg); break;
+			case 'n': count = atoi(optarg); break;
+			case 'k': iterations = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-w <workers>] [-n <tasks>] [-k <iterations per task>]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (workers <= 0 || count <= 0 || iterations <= 0)
+	{
+		fprintf(stderr, "All options require a positive number.\n");
+		return 1;
+	}
+
+	bench_task_t *tasks = malloc(count * sizeof(bench_task_t));
+	const char *names[] = {"fcfs", "sjf", "pri", "rr"};
+	scheme_t schemes[] = {FCFS, SJF, PRI, RR};
+	int i;
+
+	printf("%d worker(s), %d task(s), ~%d iteration(s) per task\n\n", workers, count, iterations);
+	printf("%-8s %10s %12s %18s\n", "pool", "completed", "tasks/sec", "mean wait (us)");
+
+	reset(tasks, count, iterations);
+	report("fifo", run_fifo(workers, tasks, count), tasks, count);
+
+	for (i = 0; i < 4; i++)
+	{
+		reset(tasks, count, iterations);
+		report(names[i], run_executor(workers, schemes[i], tasks, count), tasks, count);
+	}
+
+	free(tasks);
+	return 0;
+}
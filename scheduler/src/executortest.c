@@ -0,0 +1,141 @@
+/** @file executortest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "libexecutor/libexecutor.h"
+
+#define WORKERS 4
+#define TASKS 5000
+#define SLICED_TASKS 3
+#define QUANTUM_US 500
+#define SLICED_WORK 200000
+#define TIME_LIMIT 60
+
+typedef struct _sliced_task_t
+{
+	int id;
+	int calls;
+	int finished;
+	int first_call, last_call;
+	int remaining;
+} sliced_task_t;
+
+atomic_int *runs;
+atomic_int calls_made;
+
+static void timed_out(int signal)
+{
+	(void)signal;
+	const char message[] = "Executor did not return within the time limit.\n";
+	write(2, message, sizeof(message) - 1);
+	_exit(1);
+}
+
+static int count_run(void *arg)
+{
+	atomic_fetch_add(&runs[(int)(long)arg], 1);
+	return 0;
+}
+
+/*
+ * Works through its remaining steps, each a poll of executor_should_yield():
+ * several milliseconds in all, so several quanta.
+ */
+static int sliced(void *arg)
+{
+	sliced_task_t *task = (sliced_task_t *)arg;
+	int call = atomic_fetch_add(&calls_made, 1);
+	if (task->calls++ == 0)
+		task->first_call = call;
+	task->last_call = call;
+
+	while (task->remaining > 0)
+	{
+		task->remaining--;
+		if (executor_should_yield())
+			return 1;
+	}
+	task->finished++;
+	return 0;
+}
+
+/* Submits TASKS tasks and counts the ones that did not run exactly once. */
+static int run_once(scheme_t scheme)
+{
+	int i, wrong = 0;
+	for (i = 0; i < TASKS; i++)
+		atomic_init(&runs[i], 0);
+	if (executor_start(WORKERS, scheme, QUANTUM_US) != 0)
+		return -1;
+	for (i = 0; i < TASKS; i++)
+		executor_submit(count_run, (void *)(long)i, i % 7 + 1, i % 5 + 1);
+	executor_wait();
+	for (i = 0; i < TASKS; i++)
+		if (atomic_load(&runs[i]) != 1)
+			wrong++;
+	executor_shutdown();
+	return wrong;
+}
+
+int main()
+{
+	scheme_t schemes[] = { FCFS, SJF, PRI, RR, STRIDE, LOTTERY };
+	const char *names[] = { "FCFS", "SJF", "PRI", "RR", "STRIDE", "LOTTERY" };
+	int failed = 0, i, s;
+
+	/* A hang in wait or shutdown fails the test rather than stalling make. */
+	signal(SIGALRM, timed_out);
+	alarm(TIME_LIMIT);
+
+	runs = malloc(TASKS * sizeof(atomic_int));
+	for (s = 0; s < (int)(sizeof(schemes) / sizeof(schemes[0])); s++)
+	{
+		int wrong = run_once(schemes[s]);
+		printf("%s tasks not run exactly once: %d (expected 0).\n", names[s], wrong);
+		failed |= wrong != 0;
+	}
+	free(runs);
+
+	int refused = executor_start(WORKERS, PSJF, QUANTUM_US) != 0 && executor_start(WORKERS, PPRI, QUANTUM_US) != 0;
+	printf("Preemptive schemes refused: %s (expected yes).\n", refused ? "yes" : "no");
+	failed |= !refused;
+
+	/* On one worker, RR rotates the tasks and each resumes where it left off. */
+	sliced_task_t tasks[SLICED_TASKS];
+	atomic_init(&calls_made, 0);
+	executor_start(1, RR, QUANTUM_US);
+	for (i = 0; i < SLICED_TASKS; i++)
+	{
+		tasks[i] = (sliced_task_t) { i, 0, 0, 0, 0, SLICED_WORK };
+		executor_submit(sliced, &tasks[i], 5, 0);
+	}
+	executor_wait();
+	int single_slice = 0, unfinished = 0, not_rotated = 0;
+	for (i = 0; i < SLICED_TASKS; i++)
+	{
+		if (tasks[i].calls < 2)
+			single_slice++;
+		if (tasks[i].finished != 1)
+			unfinished++;
+		if (i > 0 && tasks[i].first_call > tasks[0].last_call)
+			not_rotated++;
+	}
+	printf("RR tasks that never yielded: %d (expected 0).\n", single_slice);
+	printf("RR tasks not finished exactly once: %d (expected 0).\n", unfinished);
+	printf("RR tasks first run after task 0 finished: %d (expected 0).\n", not_rotated);
+	failed |= single_slice != 0 || unfinished != 0 || not_rotated != 0;
+	executor_shutdown();
+
+	/* Shutting down with nothing submitted returns at once. */
+	executor_start(WORKERS, FCFS, QUANTUM_US);
+	executor_wait();
+	executor_shutdown();
+	printf("Wait and shutdown returned: yes (expected yes).\n");
+
+	return failed;
+}
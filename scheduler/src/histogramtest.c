@@ -0,0 +1,90 @@
+/** @file histogramtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libhistogram/libhistogram.h"
+
+#define VALUES 100000
+
+/*
+ * Middle of the bucket holding value, worked out from the bucket width
+ * rather than the library's own index arithmetic.
+ */
+static int expected_midpoint(int value)
+{
+	int width = 1;
+	while (value >= (HISTOGRAM_EXACT / 2) * width * 2)
+		width *= 2;
+	int lower = value - value % width;
+	return lower + (width - 1) / 2;
+}
+
+int main()
+{
+	histogram_t h, direct, first, second;
+	int failed = 0, errors, i;
+
+	/* Every value below HISTOGRAM_EXACT is read back exactly. */
+	histogram_init(&h);
+	for (i = 0; i < HISTOGRAM_EXACT; i++)
+		histogram_record(&h, i);
+	errors = 0;
+	for (i = 0; i < HISTOGRAM_EXACT; i++)
+		if (histogram_quantile(&h, (i + 1) / (double)HISTOGRAM_EXACT) != i)
+			errors++;
+	printf("Exact values read back wrong: %d (expected 0).\n", errors);
+	failed |= errors != 0;
+
+	/* Above it, a value reads back as the middle of its bucket, within 1%. */
+	errors = 0;
+	for (i = HISTOGRAM_EXACT; i < 1 << 24; i += i / 7 + 1)
+	{
+		histogram_init(&h);
+		histogram_record(&h, 0);
+		histogram_record(&h, i);
+		histogram_record(&h, 1 << 30);
+		int read = histogram_quantile(&h, 0.5);
+		if (read != expected_midpoint(i) || (read > i ? read - i : i - read) * 100 > i)
+			errors++;
+	}
+	printf("Values read back outside their bucket's middle: %d (expected 0).\n", errors);
+	failed |= errors != 0;
+
+	/* q = 0 and q = 1 give the exact extremes, not bucket middles. */
+	histogram_init(&h);
+	histogram_record(&h, 1001);
+	histogram_record(&h, 5000);
+	histogram_record(&h, 77777);
+	printf("Minimum and maximum: %d %d (expected 1001 77777).\n", histogram_quantile(&h, 0.0), histogram_quantile(&h, 1.0));
+	failed |= histogram_quantile(&h, 0.0) != 1001 || histogram_quantile(&h, 1.0) != 77777;
+
+	histogram_init(&h);
+	printf("Quantile of an empty histogram: %d (expected 0).\n", histogram_quantile(&h, 0.5));
+	failed |= histogram_quantile(&h, 0.5) != 0;
+
+	/* Merging two halves reads back the same as recording everything in one. */
+	srand(678);
+	histogram_init(&direct);
+	histogram_init(&first);
+	histogram_init(&second);
+	for (i = 0; i < VALUES; i++)
+	{
+		int value = rand() % 4 == 0 ? rand() % 100 : rand() % 2000000;
+		histogram_record(&direct, value);
+		histogram_record(i % 3 == 0 ? &first : &second, value);
+	}
+	histogram_merge(&first, &second);
+	errors = 0;
+	for (i = 0; i <= 1000; i++)
+		if (histogram_quantile(&first, i / 1000.0) != histogram_quantile(&direct, i / 1000.0))
+			errors++;
+	printf("Quantiles that differ after a merge: %d (expected 0).\n", errors);
+	printf("Count and sum match after a merge: %d (expected 1).\n",
+			histogram_count(&first) == histogram_count(&direct) && histogram_sum(&first) == histogram_sum(&direct));
+	failed |= errors != 0 || memcmp(&first, &direct, sizeof(histogram_t)) != 0;
+
+	return failed;
+}
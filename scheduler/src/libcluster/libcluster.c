@@ -0,0 +1,541 @@
+/** @file libcluster.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "libcluster.h"
+#include "../libtimerwheel/libtimerwheel.h"
+
+/**
+  One core of a node. finish fires when the job on it runs out of work,
+  quantum when its time slice ends.
+*/
+typedef struct _cluster_core_t
+{
+  int job;  //index into the job array, or -1 when idle
+  timerwheel_entry_t finish, quantum;
+} cluster_core_t;
+
+/**
+  One machine: a scheduler instance of its own, driven off its own timer
+  wheel.
+
+  During a window only the worker that owns the node touches it. The
+  dispatcher appends to inbox and reads next_event between windows, while
+  every worker is parked on a barrier.
+*/
+typedef struct _cluster_node_t
+{
+  scheduler_t* scheduler;
+  timerwheel_t wheel;
+  cluster_core_t* cores;
+  int* inbox;  //jobs sent to the node, in arrival order
+  int inbox_size, inbox_capacity, inbox_next;
+  int next_event;  //earliest pending timer, INT_MAX if there is none
+} cluster_node_t;
+
+/**
+  A thread driving the nodes first to last - 1. Statistics are kept per
+  worker and merged once the run is over, so finishing a job never touches
+  memory another worker writes.
+*/
+typedef struct _cluster_worker_t
+{
+  pthread_t thread;
+  int first, last;
+  int failed;
+  int* finished;  //scratch: cores whose finish timer fired
+  int* expired;  //scratch: cores whose quantum timer fired
+  long long jobs;
+  long long waiting_time, turnaround_time, response_time;
+  histogram_t waiting_histogram, turnaround_histogram, response_histogram;
+  int makespan;
+} cluster_worker_t;
+
+static cluster_config_t settings;
+static cluster_job_t* job_list;
+static int* remaining;  //run time left while a job is off its core, indexed by job
+static int* first_run;  //time a job first ran, -1 until it has
+static cluster_node_t* node_list;
+static cluster_worker_t* worker_list;
+static int worker_count;
+
+//node_load[n] is written by node n's worker during a window and by the dispatcher between windows
+static int* node_load;
+static int* node_jobs;
+
+//window_open lets the workers run a window, window_closed waits until they all have
+static pthread_barrier_t window_open, window_closed;
+static int window_end;
+static int stopping;
+static unsigned long long dispatch_rng;
+static int round_robin_next;
+//loads only grow during a window, so the shortest queue is found by sweeping one load level at a time
+static int shortest_load, shortest_next;
+
+
+static int compare_int(const void* a, const void* b)
+{
+  return *(const int*)a - *(const int*)b;
+}
+
+static int compare_arrival(const void* a, const void* b)
+{
+  int left = *(const int*)a, right = *(const int*)b;
+  if(job_list[left].arrival_time != job_list[right].arrival_time)
+  {
+    return job_list[left].arrival_time < job_list[right].arrival_time ? -1 : 1;
+  }
+  return left - right;
+}
+
+//xorshift64*, seeded from the config so every run of a workload dispatches alike
+static unsigned long long next_random()
+{
+  dispatch_rng ^= dispatch_rng >> 12;
+  dispatch_rng ^= dispatch_rng << 25;
+  dispatch_rng ^= dispatch_rng >> 27;
+  return dispatch_rng * 2685821657736338717ULL;
+}
+
+static int pick_node()
+{
+  int n = settings.nodes;
+
+  switch(settings.dispatch)
+  {
+    case DISPATCH_ROUND_ROBIN:
+    {
+      int node = round_robin_next;
+      round_robin_next = (round_robin_next + 1) % n;
+      return node;
+    }
+
+    case DISPATCH_SHORTEST_QUEUE:
+      //the lowest numbered of the least loaded nodes
+      for(;;)
+      {
+        for(; shortest_next < n; shortest_next++)
+        {
+          if(node_load[shortest_next] == shortest_load)
+          {
+            return shortest_next++;
+          }
+        }
+        shortest_load++;
+        shortest_next = 0;
+      }
+
+    case DISPATCH_TWO_CHOICES:
+    {
+      if(n == 1)
+      {
+        return 0;
+      }
+      int first = (int)(next_random() % (unsigned long long)n);
+      int second = (int)(next_random() % (unsigned long long)(n - 1));
+      if(second >= first)
+      {
+        second++;
+      }
+      return node_load[second] < node_load[first] ? second : first;
+    }
+
+    default:
+      return (int)(next_random() % (unsigned long long)n);
+  }
+}
+
+static void send_job(int node_id, int job)
+{
+  cluster_node_t* node = &node_list[node_id];
+  if(node->inbox_size == node->inbox_capacity)
+  {
+    node->inbox_capacity = node->inbox_capacity > 0 ? node->inbox_capacity * 2 : 16;
+    node->inbox = realloc(node->inbox, node->inbox_capacity * sizeof(int));
+  }
+  node->inbox[node->inbox_size++] = job;
+  node_load[node_id]++;
+  node_jobs[node_id]++;
+}
+
+static void start_job(cluster_node_t* node, int core_id, int job, int time)
+{
+  cluster_core_t* core = &node->cores[core_id];
+  core->job = job;
+  timerwheel_arm(&node->wheel, &core->finish, time + remaining[job]);
+  if(settings.quantum > 0)
+  {
+    timerwheel_arm(&node->wheel, &core->quantum, time + scheduler_quantum(core_id));
+  }
+  if(first_run[job] == -1)
+  {
+    first_run[job] = time;
+  }
+}
+
+//takes the job off its core, banking the run time it has left
+static void stop_job(cluster_node_t* node, int core_id, int time)
+{
+  cluster_core_t* core = &node->cores[core_id];
+  remaining[core->job] = core->finish.m_deadline - time;
+  //as in the scheduler, a job preempted in the time unit it first started has not responded yet
+  if(first_run[core->job] == time)
+  {
+    first_run[core->job] = -1;
+  }
+  timerwheel_cancel(&node->wheel, &core->finish);
+  timerwheel_cancel(&node->wheel, &core->quantum);
+  core->job = -1;
+}
+
+static void finish_job(cluster_node_t* node, cluster_worker_t* worker, int core_id, int time)
+{
+  cluster_core_t* core = &node->cores[core_id];
+  int job = core->job;
+  int turnaround = time - job_list[job].arrival_time;
+  int waiting = turnaround - job_list[job].run_time;
+  int response = first_run[job] - job_list[job].arrival_time;
+
+  worker->jobs++;
+  worker->waiting_time += waiting;
+  worker->turnaround_time += turnaround;
+  worker->response_time += response;
+  histogram_record(&worker->waiting_histogram, waiting);
+  histogram_record(&worker->turnaround_histogram, turnaround);
+  histogram_record(&worker->response_histogram, response);
+  if(time > worker->makespan)
+  {
+    worker->makespan = time;
+  }
+
+  timerwheel_cancel(&node->wheel, &core->quantum);
+  core->job = -1;
+  node_load[node - node_list]--;
+
+  int next = scheduler_job_finished(core_id, job, time);
+  if(next != -1)
+  {
+    start_job(node, core_id, next, time);
+  }
+}
+
+/*
+ * Runs one node up to, but not including, window_end. Time jumps straight
+ * from one event to the next; within a time unit, finishes come first, then
+ * quantum expiries, then arrivals, as in the single-node simulator.
+ */
+static void run_node(cluster_node_t* node, cluster_worker_t* worker)
+{
+  int node_id = node - node_list;
+  scheduler_use(node->scheduler);
+
+  for(;;)
+  {
+    int time = node->next_event = timerwheel_next_deadline(&node->wheel);
+    if(node->inbox_next < node->inbox_size && job_list[node->inbox[node->inbox_next]].arrival_time < time)
+    {
+      time = job_list[node->inbox[node->inbox_next]].arrival_time;
+    }
+    if(time >= window_end)
+    {
+      break;
+    }
+
+    int finished = 0, expired = 0;
+    for(timerwheel_entry_t* timer = timerwheel_advance(&node->wheel, time); timer != NULL; timer = timer->m_next)
+    {
+      cluster_core_t* core = timer->m_data;
+      if(timer == &core->finish)
+      {
+        worker->finished[finished++] = core - node->cores;
+      }
+      else
+      {
+        worker->expired[expired++] = core - node->cores;
+      }
+    }
+
+    qsort(worker->finished, finished, sizeof(int), compare_int);
+    for(int i = 0; i < finished; i++)
+    {
+      finish_job(node, worker, worker->finished[i], time);
+    }
+
+    qsort(worker->expired, expired, sizeof(int), compare_int);
+    for(int i = 0; i < expired; i++)
+    {
+      int core_id = worker->expired[i];
+      //a job that started on this core after a finish above has a fresh quantum
+      if(node->cores[core_id].job == -1 || timerwheel_pending(&node->cores[core_id].quantum))
+      {
+        continue;
+      }
+      stop_job(node, core_id, time);
+      int next = scheduler_quantum_expired(core_id, time);
+      if(next != -1)
+      {
+        start_job(node, core_id, next, time);
+      }
+    }
+
+    while(node->inbox_next < node->inbox_size && job_list[node->inbox[node->inbox_next]].arrival_time == time)
+    {
+      int job = node->inbox[node->inbox_next++];
+      int core_id = scheduler_new_job(job, time, job_list[job].run_time, job_list[job].priority);
+      if(core_id != -1)
+      {
+        if(node->cores[core_id].job != -1)
+        {
+          stop_job(node, core_id, time);
+        }
+        start_job(node, core_id, job, time);
+      }
+    }
+  }
+
+  if(node->inbox_next == node->inbox_size)
+  {
+    node->inbox_next = node->inbox_size = 0;
+  }
+
+  //jobs are waiting but no core will ever ask for one
+  if(node_load[node_id] > 0 && node->next_event == INT_MAX)
+  {
+    worker->failed = 1;
+  }
+}
+
+static void run_window(cluster_worker_t* worker)
+{
+  for(int n = worker->first; n < worker->last; n++)
+  {
+    if(node_list[n].next_event < window_end || node_list[n].inbox_next < node_list[n].inbox_size)
+    {
+      run_node(&node_list[n], worker);
+    }
+  }
+}
+
+static void* worker_main(void* arg)
+{
+  cluster_worker_t* worker = arg;
+  for(;;)
+  {
+    pthread_barrier_wait(&window_open);
+    if(stopping)
+    {
+      break;
+    }
+    run_window(worker);
+    pthread_barrier_wait(&window_closed);
+  }
+  return NULL;
+}
+
+
+/**
+  Simulates a cluster of identical nodes, each running its own scheduler
+  instance, behind a dispatcher that sends every arriving job to one node.
+
+  Nodes are split across worker threads and synchronize conservatively: the
+  dispatcher fixes which jobs arriving in the next window go where, then every
+  worker runs its nodes to the end of the window independently, since nodes
+  never interact within one. Dispatch decisions therefore see node loads as
+  of the start of their window; a window of 1 gives exact loads at the cost
+  of a synchronization per time unit. Windows in which no node has anything
+  to do are skipped. Results depend on the window but not on the number of
+  threads.
+
+  Assumptions:
+    - Only one cluster_run() is active per process at a time.
+    - Jobs have positive run times.
+
+  @param jobs the jobs to run; a job's number is its index
+  @param count the number of jobs
+  @param config the cluster to simulate
+  @param stats filled in with the results
+  @return 0 on success
+  @return -1 if a node's scheduler left jobs waiting with every core idle
+ */
+int cluster_run(cluster_job_t *jobs, int count, cluster_config_t *config, cluster_stats_t *stats)
+{
+  settings = *config;
+  if(settings.window < 1)
+  {
+    settings.window = 1;
+  }
+  job_list = jobs;
+  dispatch_rng = 0x9E3779B97F4A7C15ULL ^ settings.seed;
+  round_robin_next = 0;
+  stopping = 0;
+
+  remaining = malloc(count * sizeof(int));
+  first_run = malloc(count * sizeof(int));
+  int* order = malloc(count * sizeof(int));
+  for(int i = 0; i < count; i++)
+  {
+    remaining[i] = jobs[i].run_time;
+    first_run[i] = -1;
+    order[i] = i;
+  }
+  qsort(order, count, sizeof(int), compare_arrival);
+
+  node_list = calloc(settings.nodes, sizeof(cluster_node_t));
+  node_load = calloc(settings.nodes, sizeof(int));
+  node_jobs = calloc(settings.nodes, sizeof(int));
+  for(int n = 0; n < settings.nodes; n++)
+  {
+    cluster_node_t* node = &node_list[n];
+    node->scheduler = scheduler_create();
+    scheduler_use(node->scheduler);
+    scheduler_start_up(settings.cores, settings.scheme);
+    scheduler_set_aging(settings.aging);
+    scheduler_set_quantum(settings.quantum, settings.granularity);
+
+    timerwheel_init(&node->wheel, 0);
+    node->cores = malloc(settings.cores * sizeof(cluster_core_t));
+    for(int c = 0; c < settings.cores; c++)
+    {
+      node->cores[c].job = -1;
+      timerwheel_entry_init(&node->cores[c].finish, &node->cores[c]);
+      timerwheel_entry_init(&node->cores[c].quantum, &node->cores[c]);
+    }
+    node->next_event = INT_MAX;
+  }
+  scheduler_use(NULL);
+
+  worker_count = settings.threads > 0 ? settings.threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if(worker_count > settings.nodes)
+  {
+    worker_count = settings.nodes;
+  }
+  if(worker_count < 1)
+  {
+    worker_count = 1;
+  }
+  worker_list = calloc(worker_count, sizeof(cluster_worker_t));
+  pthread_barrier_init(&window_open, NULL, worker_count);
+  pthread_barrier_init(&window_closed, NULL, worker_count);
+  for(int i = 0; i < worker_count; i++)
+  {
+    cluster_worker_t* worker = &worker_list[i];
+    //contiguous ranges keep each worker's node_load writes off the others' cache lines
+    worker->first = (int)((long long)settings.nodes * i / worker_count);
+    worker->last = (int)((long long)settings.nodes * (i + 1) / worker_count);
+    worker->finished = malloc(settings.cores * sizeof(int));
+    worker->expired = malloc(settings.cores * sizeof(int));
+    histogram_init(&worker->waiting_histogram);
+    histogram_init(&worker->turnaround_histogram);
+    histogram_init(&worker->response_histogram);
+  }
+  //the calling thread dispatches and also drives the first worker's nodes
+  for(int i = 1; i < worker_count; i++)
+  {
+    pthread_create(&worker_list[i].thread, NULL, worker_main, &worker_list[i]);
+  }
+
+  memset(stats, 0, sizeof(cluster_stats_t));
+  int next = 0, failed = 0;
+  while(!failed)
+  {
+    int start = next < count ? jobs[order[next]].arrival_time : INT_MAX;
+    shortest_load = INT_MAX;
+    shortest_next = 0;
+    for(int n = 0; n < settings.nodes; n++)
+    {
+      if(node_list[n].next_event < start)
+      {
+        start = node_list[n].next_event;
+      }
+      if(node_load[n] < shortest_load)
+      {
+        shortest_load = node_load[n];
+      }
+    }
+    if(start == INT_MAX)
+    {
+      break;
+    }
+
+    window_end = start > INT_MAX - settings.window ? INT_MAX : start + settings.window;
+    while(next < count && jobs[order[next]].arrival_time < window_end)
+    {
+      send_job(pick_node(), order[next]);
+      next++;
+    }
+    stats->windows++;
+
+    pthread_barrier_wait(&window_open);
+    run_window(&worker_list[0]);
+    pthread_barrier_wait(&window_closed);
+
+    for(int i = 0; i < worker_count; i++)
+    {
+      failed |= worker_list[i].failed;
+    }
+  }
+
+  stopping = 1;
+  pthread_barrier_wait(&window_open);
+  for(int i = 1; i < worker_count; i++)
+  {
+    pthread_join(worker_list[i].thread, NULL);
+  }
+
+  histogram_init(&stats->waiting_histogram);
+  histogram_init(&stats->turnaround_histogram);
+  histogram_init(&stats->response_histogram);
+  for(int i = 0; i < worker_count; i++)
+  {
+    cluster_worker_t* worker = &worker_list[i];
+    stats->jobs += worker->jobs;
+    stats->waiting_time += worker->waiting_time;
+    stats->turnaround_time += worker->turnaround_time;
+    stats->response_time += worker->response_time;
+    histogram_merge(&stats->waiting_histogram, &worker->waiting_histogram);
+    histogram_merge(&stats->turnaround_histogram, &worker->turnaround_histogram);
+    histogram_merge(&stats->response_histogram, &worker->response_histogram);
+    if(worker->makespan > stats->makespan)
+    {
+      stats->makespan = worker->makespan;
+    }
+    free(worker->finished);
+    free(worker->expired);
+  }
+
+  stats->min_node_jobs = INT_MAX;
+  for(int n = 0; n < settings.nodes; n++)
+  {
+    if(node_jobs[n] < stats->min_node_jobs)
+    {
+      stats->min_node_jobs = node_jobs[n];
+    }
+    if(node_jobs[n] > stats->max_node_jobs)
+    {
+      stats->max_node_jobs = node_jobs[n];
+    }
+
+    scheduler_use(node_list[n].scheduler);
+    scheduler_clean_up();
+    scheduler_destroy(node_list[n].scheduler);
+    free(node_list[n].cores);
+    free(node_list[n].inbox);
+  }
+
+  pthread_barrier_destroy(&window_open);
+  pthread_barrier_destroy(&window_closed);
+  free(worker_list);
+  free(node_list);
+  free(node_load);
+  free(node_jobs);
+  free(remaining);
+  free(first_run);
+  free(order);
+
+  return failed ? -1 : 0;
+}
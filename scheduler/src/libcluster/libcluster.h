@@ -0,0 +1,60 @@
+/** @file libcluster.h
+ */
+
+#ifndef LIBCLUSTER_H_
+#define LIBCLUSTER_H_
+
+#include "../libscheduler/libscheduler.h"
+#include "../libhistogram/libhistogram.h"
+
+/**
+  How the dispatcher picks the node for an arriving job. The queue-aware
+  policies compare node loads, a load being the number of jobs sent to a node
+  that have not finished yet.
+*/
+typedef enum {DISPATCH_RANDOM = 0, DISPATCH_ROUND_ROBIN, DISPATCH_SHORTEST_QUEUE, DISPATCH_TWO_CHOICES} dispatch_t;
+
+/**
+  A job submitted to the cluster. Jobs are identified by their index.
+*/
+typedef struct _cluster_job_t
+{
+  int arrival_time;
+  int run_time;
+  int priority;
+} cluster_job_t;
+
+/**
+  Shape of the cluster and how it is simulated.
+*/
+typedef struct _cluster_config_t
+{
+  int nodes;
+  int cores;           //per node
+  scheme_t scheme;
+  int quantum;         //time slice for RR, STRIDE and LOTTERY
+  int granularity;     //passed to scheduler_set_quantum()
+  int aging;           //passed to scheduler_set_aging()
+  dispatch_t dispatch;
+  int window;          //time units the nodes run between synchronizations
+  int threads;         //0 for one per online CPU
+  unsigned int seed;   //for DISPATCH_RANDOM and DISPATCH_TWO_CHOICES
+} cluster_config_t;
+
+/**
+  Results of a cluster run. The time sums are exact; the averages the
+  single-node scheduler reports are these sums over jobs.
+*/
+typedef struct _cluster_stats_t
+{
+  long long jobs;
+  long long waiting_time, turnaround_time, response_time;
+  histogram_t waiting_histogram, turnaround_histogram, response_histogram;
+  int makespan;
+  int min_node_jobs, max_node_jobs;
+  long long windows;
+} cluster_stats_t;
+
+int   cluster_run             (cluster_job_t *jobs, int count, cluster_config_t *config, cluster_stats_t *stats);
+
+#endif /* LIBCLUSTER_H_ */
@@ -0,0 +1,438 @@
+/** @file libcorescan.c
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+
+#include "libcorescan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CORESCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef struct _corescan_ops_t
+{
+	int (*longest)(const long long *finish, const long long *banked, int count, long long now);
+	int (*highest)(const int *values, int count);
+	int (*first_zero)(const int *values, int count);
+} corescan_ops_t;
+
+
+/*
+ * Time left on core i: its finish time less now, but never more than the
+ * work banked at dispatch, which a core still paying dispatch overhead has
+ * not started on.
+ */
+static inline long long time_left(const long long *finish, const long long *banked, int i, long long now)
+{
+	long long left = finish[i] - now;
+	return left < banked[i] ? left : banked[i];
+}
+
+/*
+ * Lane holding the largest value, the lowest index among equal ones. Each
+ * lane already holds the first index of its own largest value.
+ */
+static int pick_lane(const long long *values, const long long *indices, int lanes)
+{
+	int best = 0;
+	for(int lane = 1; lane < lanes; lane++)
+	{
+		if(values[lane] > values[best] || (values[lane] == values[best] && indices[lane] < indices[best]))
+		{
+			best = lane;
+		}
+	}
+	return best;
+}
+
+
+/*  **---SCALAR---** */
+
+static int longest_scalar(const long long *finish, const long long *banked, int count, long long now)
+{
+	int best = 0;
+	long long best_left = time_left(finish, banked, 0, now);
+	for(int i = 1; i < count; i++)
+	{
+		long long left = time_left(finish, banked, i, now);
+		if(left > best_left)
+		{
+			best_left = left;
+			best = i;
+		}
+	}
+	return best;
+}
+
+static int highest_scalar(const int *values, int count)
+{
+	int best = 0;
+	for(int i = 1; i < count; i++)
+	{
+		if(values[i] > values[best])
+		{
+			best = i;
+		}
+	}
+	return best;
+}
+
+static int first_zero_scalar(const int *values, int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		if(values[i] == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+#ifdef CORESCAN_X86
+
+/*  **---SSE4.2---** */
+
+__attribute__((target("sse4.2")))
+static int longest_sse(const long long *finish, const long long *banked, int count, long long now)
+{
+	if(count < 2)
+	{
+		return longest_scalar(finish, banked, count, now);
+	}
+	__m128i now2 = _mm_set1_epi64x(now);
+	__m128i step = _mm_set1_epi64x(2);
+	__m128i index = _mm_set_epi64x(1, 0);
+	__m128i best = _mm_set1_epi64x(LLONG_MIN);
+	__m128i best_index = index;
+	int i = 0;
+	for(; i + 2 <= count; i += 2)
+	{
+		__m128i left = _mm_sub_epi64(_mm_loadu_si128((const __m128i *)(finish + i)), now2);
+		__m128i bank = _mm_loadu_si128((const __m128i *)(banked + i));
+		left = _mm_blendv_epi8(left, bank, _mm_cmpgt_epi64(left, bank));
+		__m128i better = _mm_cmpgt_epi64(left, best);
+		best = _mm_blendv_epi8(best, left, better);
+		best_index = _mm_blendv_epi8(best_index, index, better);
+		index = _mm_add_epi64(index, step);
+	}
+	long long values[2], indices[2];
+	_mm_storeu_si128((__m128i *)values, best);
+	_mm_storeu_si128((__m128i *)indices, best_index);
+	int lane = pick_lane(values, indices, 2);
+	int winner = (int)indices[lane];
+	long long winner_left = values[lane];
+	for(; i < count; i++)
+	{
+		long long left = time_left(finish, banked, i, now);
+		if(left > winner_left)
+		{
+			winner_left = left;
+			winner = i;
+		}
+	}
+	return winner;
+}
+
+__attribute__((target("sse4.2")))
+static int highest_sse(const int *values, int count)
+{
+	if(count < 4)
+	{
+		return highest_scalar(values, count);
+	}
+	__m128i step = _mm_set1_epi32(4);
+	__m128i index = _mm_set_epi32(3, 2, 1, 0);
+	__m128i best = _mm_set1_epi32(INT_MIN);
+	__m128i best_index = index;
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i value = _mm_loadu_si128((const __m128i *)(values + i));
+		__m128i better = _mm_cmpgt_epi32(value, best);
+		best = _mm_max_epi32(best, value);
+		best_index = _mm_blendv_epi8(best_index, index, better);
+		index = _mm_add_epi32(index, step);
+	}
+	int lanes[4], lane_indices[4];
+	long long wide[4], wide_indices[4];
+	_mm_storeu_si128((__m128i *)lanes, best);
+	_mm_storeu_si128((__m128i *)lane_indices, best_index);
+	for(int lane = 0; lane < 4; lane++)
+	{
+		wide[lane] = lanes[lane];
+		wide_indices[lane] = lane_indices[lane];
+	}
+	int winner = (int)wide_indices[pick_lane(wide, wide_indices, 4)];
+	for(; i < count; i++)
+	{
+		if(values[i] > values[winner])
+		{
+			winner = i;
+		}
+	}
+	return winner;
+}
+
+__attribute__((target("sse4.2")))
+static int first_zero_sse(const int *values, int count)
+{
+	__m128i zero = _mm_setzero_si128();
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128i hit = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(values + i)), zero);
+		int mask = _mm_movemask_ps(_mm_castsi128_ps(hit));
+		if(mask != 0)
+		{
+			return i + __builtin_ctz(mask);
+		}
+	}
+	int found = first_zero_scalar(values + i, count - i);
+	return found == -1 ? -1 : i + found;
+}
+
+
+/*  **---AVX2---** */
+
+__attribute__((target("avx2")))
+static int longest_avx2(const long long *finish, const long long *banked, int count, long long now)
+{
+	if(count < 4)
+	{
+		return longest_sse(finish, banked, count, now);
+	}
+	__m256i now4 = _mm256_set1_epi64x(now);
+	__m256i step = _mm256_set1_epi64x(4);
+	__m256i index = _mm256_set_epi64x(3, 2, 1, 0);
+	__m256i best = _mm256_set1_epi64x(LLONG_MIN);
+	__m256i best_index = index;
+	int i = 0;
+	for(; i + 4 <= count; i += 4)
+	{
+		__m256i left = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i *)(finish + i)), now4);
+		__m256i bank = _mm256_loadu_si256((const __m256i *)(banked + i));
+		left = _mm256_blendv_epi8(left, bank, _mm256_cmpgt_epi64(left, bank));
+		__m256i better = _mm256_cmpgt_epi64(left, best);
+		best = _mm256_blendv_epi8(best, left, better);
+		best_index = _mm256_blendv_epi8(best_index, index, better);
+		index = _mm256_add_epi64(index, step);
+	}
+	long long values[4], indices[4];
+	_mm256_storeu_si256((__m256i *)values, best);
+	_mm256_storeu_si256((__m256i *)indices, best_index);
+	int lane = pick_lane(values, indices, 4);
+	int winner = (int)indices[lane];
+	long long winner_left = values[lane];
+	for(; i < count; i++)
+	{
+		long long left = time_left(finish, banked, i, now);
+		if(left > winner_left)
+		{
+			winner_left = left;
+			winner = i;
+		}
+	}
+	return winner;
+}
+
+__attribute__((target("avx2")))
+static int highest_avx2(const int *values, int count)
+{
+	if(count < 8)
+	{
+		return highest_sse(values, count);
+	}
+	__m256i step = _mm256_set1_epi32(8);
+	__m256i index = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	__m256i best = _mm256_set1_epi32(INT_MIN);
+	__m256i best_index = index;
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i value = _mm256_loadu_si256((const __m256i *)(values + i));
+		__m256i better = _mm256_cmpgt_epi32(value, best);
+		best = _mm256_max_epi32(best, value);
+		best_index = _mm256_blendv_epi8(best_index, index, better);
+		index = _mm256_add_epi32(index, step);
+	}
+	int lanes[8], lane_indices[8];
+	long long wide[8], wide_indices[8];
+	_mm256_storeu_si256((__m256i *)lanes, best);
+	_mm256_storeu_si256((__m256i *)lane_indices, best_index);
+	for(int lane = 0; lane < 8; lane++)
+	{
+		wide[lane] = lanes[lane];
+		wide_indices[lane] = lane_indices[lane];
+	}
+	int winner = (int)wide_indices[pick_lane(wide, wide_indices, 8)];
+	for(; i < count; i++)
+	{
+		if(values[i] > values[winner])
+		{
+			winner = i;
+		}
+	}
+	return winner;
+}
+
+__attribute__((target("avx2")))
+static int first_zero_avx2(const int *values, int count)
+{
+	__m256i zero = _mm256_setzero_si256();
+	int i = 0;
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i hit = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i)), zero);
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+		if(mask != 0)
+		{
+			return i + __builtin_ctz(mask);
+		}
+	}
+	int found = first_zero_sse(values + i, count - i);
+	return found == -1 ? -1 : i + found;
+}
+
+static const corescan_ops_t kernels[CORESCAN_KERNELS] =
+{
+	{longest_scalar, highest_scalar, first_zero_scalar},
+	{longest_sse, highest_sse, first_zero_sse},
+	{longest_avx2, highest_avx2, first_zero_avx2},
+};
+
+#else
+
+static const corescan_ops_t kernels[CORESCAN_KERNELS] =
+{
+	{longest_scalar, highest_scalar, first_zero_scalar},
+	{longest_scalar, highest_scalar, first_zero_scalar},
+	{longest_scalar, highest_scalar, first_zero_scalar},
+};
+
+#endif
+
+
+static corescan_kernel_t selected = CORESCAN_SCALAR;
+
+static int kernel_supported(corescan_kernel_t kernel)
+{
+	switch(kernel)
+	{
+		case CORESCAN_SCALAR: return 1;
+#ifdef CORESCAN_X86
+		case CORESCAN_SSE: return __builtin_cpu_supports("sse4.2");
+		case CORESCAN_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+		default: return 0;
+	}
+}
+
+/*
+ * Picks the widest kernel before main() runs, so the searches never race
+ * on the choice however many scheduler threads use them.
+ */
+__attribute__((constructor))
+static void corescan_detect()
+{
+	__builtin_cpu_init();
+	for(int kernel = CORESCAN_KERNELS - 1; kernel > CORESCAN_SCALAR; kernel--)
+	{
+		if(kernel_supported(kernel))
+		{
+			selected = kernel;
+			return;
+		}
+	}
+}
+
+
+/**
+  Finds the core whose job has the most time left. A core's time left is
+  finish[i] - now, capped at banked[i]: finish is when the job will be done
+  and banked how long it runs from its dispatch, so the cap covers a core
+  that has not started the job yet.
+
+  @param finish when each core's job will be done
+  @param banked how long each core's job runs after its dispatch
+  @param count the number of cores, at least 1
+  @param now the current time, in the units of finish
+  @return the lowest core with the most time left
+ */
+int corescan_longest(const long long *finish, const long long *banked, int count, long long now)
+{
+	return kernels[selected].longest(finish, banked, count, now);
+}
+
+
+/**
+  Finds the largest value, such as the worst priority among running jobs.
+
+  @param values one value per core
+  @param count the number of cores, at least 1
+  @return the lowest index holding the largest value
+ */
+int corescan_highest(const int *values, int count)
+{
+	return kernels[selected].highest(values, count);
+}
+
+
+/**
+  Finds the first zero, such as the first idle core in a busy flag array.
+
+  @param values one value per core
+  @param count the number of cores
+  @return the lowest index holding 0
+  @return -1 if there is none
+ */
+int corescan_first_zero(const int *values, int count)
+{
+	return kernels[selected].first_zero(values, count);
+}
+
+
+/**
+  Returns the kernel the searches use.
+
+  @return the kernel in use
+ */
+corescan_kernel_t corescan_kernel()
+{
+	return selected;
+}
+
+
+/**
+  Makes the searches use a kernel, as a benchmark does to compare them.
+  Not thread safe; call it before any scheduler thread starts.
+
+  @param kernel the kernel to use
+  @return 0 on success
+  @return -1 if this CPU cannot run kernel
+ */
+int corescan_select(corescan_kernel_t kernel)
+{
+	if(kernel < CORESCAN_SCALAR || kernel >= CORESCAN_KERNELS || !kernel_supported(kernel))
+	{
+		return -1;
+	}
+	selected = kernel;
+	return 0;
+}
+
+
+/**
+  Returns a kernel's name.
+
+  @param kernel the kernel
+  @return its name
+ */
+const char *corescan_kernel_name(corescan_kernel_t kernel)
+{
+	static const char *names[CORESCAN_KERNELS] = {"scalar", "sse4.2", "avx2"};
+	return kernel >= CORESCAN_SCALAR && kernel < CORESCAN_KERNELS ? names[kernel] : "unknown";
+}
@@ -0,0 +1,25 @@
+/** @file libcorescan.h
+ */
+
+#ifndef LIBCORESCAN_H_
+#define LIBCORESCAN_H_
+
+/**
+  Searches over per-core arrays, the kind a scheduler makes on every
+  arrival once all cores are busy. Each search has a plain C version and,
+  on x86, SSE4.2 and AVX2 versions; the best one the CPU supports is picked
+  when the program starts. Every version returns the same index, ties going
+  to the lowest one.
+*/
+typedef enum {CORESCAN_SCALAR = 0, CORESCAN_SSE, CORESCAN_AVX2, CORESCAN_KERNELS} corescan_kernel_t;
+
+
+int               corescan_longest    (const long long *finish, const long long *banked, int count, long long now);
+int               corescan_highest    (const int *values, int count);
+int               corescan_first_zero (const int *values, int count);
+
+corescan_kernel_t corescan_kernel     ();
+int               corescan_select     (corescan_kernel_t kernel);
+const char *      corescan_kernel_name(corescan_kernel_t kernel);
+
+#endif /* LIBCORESCAN_H_ */
@@ -0,0 +1,189 @@
+/** @file libcpriqueue.c
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "libcpriqueue.h"
+
+
+static __thread uint64_t shard_rng;
+
+//per-thread xorshift64, seeded from the thread's stack address
+static unsigned int random_shard(int count)
+{
+	if(shard_rng == 0)
+	{
+		shard_rng = (uint64_t)(uintptr_t)&shard_rng * 0x9E3779B97F4A7C15ULL | 1;
+	}
+	shard_rng ^= shard_rng << 13;
+	shard_rng ^= shard_rng >> 7;
+	shard_rng ^= shard_rng << 17;
+	return (unsigned int)(shard_rng % (uint64_t)count);
+}
+
+static int try_lock(cpriqueue_shard_t *shard)
+{
+	return !atomic_flag_test_and_set_explicit(&shard->m_lock, memory_order_acquire);
+}
+
+static void unlock(cpriqueue_shard_t *shard)
+{
+	atomic_store_explicit(&shard->m_top, heap_peek(&shard->m_heap), memory_order_release);
+	atomic_flag_clear_explicit(&shard->m_lock, memory_order_release);
+}
+
+
+/**
+  Initializes the cpriqueue_t data structure. Not thread safe.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @param shards number of sub-heaps; a few times the number of threads works well
+  @param comparer a function pointer that compares two elements.
+  See also @ref comparer-page
+  @return 0 on success
+  @return -1 if memory could not be allocated
+ */
+int cpriqueue_init(cpriqueue_t *q, int shards, int(*comparer)(const void *, const void *))
+{
+	if(shards < 1)
+	{
+		shards = 1;
+	}
+	q->m_shards = aligned_alloc(64, sizeof(cpriqueue_shard_t) * shards);
+	if(q->m_shards == NULL)
+	{
+		return -1;
+	}
+	q->m_count = shards;
+	atomic_init(&q->m_size, 0);
+	for(int i = 0; i < shards; i++)
+	{
+		atomic_flag_clear(&q->m_shards[i].m_lock);
+		atomic_init(&q->m_shards[i].m_top, NULL);
+		heap_init(&q->m_shards[i].m_heap, comparer);
+	}
+	return 0;
+}
+
+
+/**
+  Inserts the specified element into a random shard. Thread safe.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @param ptr a pointer to the data to be inserted
+  @return 0 on success
+  @return -1 if memory could not be allocated
+ */
+int cpriqueue_offer(cpriqueue_t *q, void *ptr)
+{
+	cpriqueue_shard_t *shard;
+	do
+	{
+		shard = &q->m_shards[random_shard(q->m_count)];
+	} while(!try_lock(shard));
+
+	int result = heap_offer(&shard->m_heap, ptr);
+	unlock(shard);
+	if(result < 0)
+	{
+		return -1;
+	}
+	atomic_fetch_add_explicit(&q->m_size, 1, memory_order_relaxed);
+	return 0;
+}
+
+
+/**
+  Removes and returns a small element: the minimum of the better of two
+  randomly sampled shards. Thread safe. See cpriqueue_t for the exact
+  ordering guarantees.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @return an element of the queue
+  @return NULL if the queue is empty
+ */
+void *cpriqueue_poll(cpriqueue_t *q)
+{
+	for(;;)
+	{
+		if(atomic_load_explicit(&q->m_size, memory_order_relaxed) <= 0)
+		{
+			//the size is only a hint; confirm every shard really is empty
+			int i;
+			for(i = 0; i < q->m_count; i++)
+			{
+				if(atomic_load_explicit(&q->m_shards[i].m_top, memory_order_acquire) != NULL)
+				{
+					break;
+				}
+			}
+			if(i == q->m_count)
+			{
+				return NULL;
+			}
+		}
+
+		cpriqueue_shard_t *first = &q->m_shards[random_shard(q->m_count)];
+		cpriqueue_shard_t *second = &q->m_shards[random_shard(q->m_count)];
+		void *first_top = atomic_load_explicit(&first->m_top, memory_order_acquire);
+		void *second_top = atomic_load_explicit(&second->m_top, memory_order_acquire);
+
+		cpriqueue_shard_t *best;
+		if(first_top == NULL)
+		{
+			best = second;
+		}
+		else if(second_top == NULL)
+		{
+			best = first;
+		}
+		else
+		{
+			best = first->m_heap.comp(first_top, second_top) <= 0 ? first : second;
+		}
+		if((best == first ? first_top : second_top) == NULL || !try_lock(best))
+		{
+			continue;
+		}
+
+		void *entry = heap_poll(&best->m_heap);
+		unlock(best);
+		if(entry != NULL)
+		{
+			atomic_fetch_sub_explicit(&q->m_size, 1, memory_order_relaxed);
+			return entry;
+		}
+	}
+}
+
+
+/**
+  Returns the number of elements in the queue. Under concurrent use this is
+  only a snapshot.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @return the number of elements in the queue
+ */
+int cpriqueue_size(cpriqueue_t *q)
+{
+	return atomic_load_explicit(&q->m_size, memory_order_relaxed);
+}
+
+
+/**
+  Destroys and frees all the memory associated with q. Not thread safe; the
+  elements themselves are owned by the caller.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+ */
+void cpriqueue_destroy(cpriqueue_t *q)
+{
+	for(int i = 0; i < q->m_count; i++)
+	{
+		heap_destroy(&q->m_shards[i].m_heap);
+	}
+	free(q->m_shards);
+	q->m_shards = NULL;
+	q->m_count = 0;
+}
@@ -0,0 +1,62 @@
+/** @file libcpriqueue.h
+ */
+
+#ifndef LIBCPRIQUEUE_H_
+#define LIBCPRIQUEUE_H_
+
+#include <stdatomic.h>
+
+#include "../libheap/libheap.h"
+
+/**
+  One sub-heap of a cpriqueue_t, padded to its own cache line.
+
+  m_top mirrors the minimum of m_heap so pollers can compare shards without
+  taking m_lock.
+*/
+typedef struct _cpriqueue_shard_t
+{
+  _Alignas(64) atomic_flag m_lock;
+  _Atomic(void*) m_top;
+  heap_t m_heap;
+} cpriqueue_shard_t;
+
+/**
+  Concurrent relaxed priority queue (a "MultiQueue").
+
+  Elements are spread over k independently locked binary heaps. An offer
+  goes to a random shard; a poll samples two random shards, compares their
+  cached minima and removes from the better one ("power of two choices").
+  Shard locks are only ever try-locked: a thread that finds a shard busy
+  moves on to another one instead of waiting.
+
+  Ordering guarantees:
+    - Every offered element is returned by exactly one poll.
+    - Polls are NOT strictly in priority order. The element returned is the
+      minimum of one shard, and on average is within O(k) ranks of the true
+      minimum. With a single shard the queue is strict.
+    - There is no FIFO order among equal elements, not even for elements
+      offered by the same thread.
+    - cpriqueue_poll() may return NULL while an offer from another thread
+      is still in progress; it only guarantees NULL was correct at some
+      moment during the call.
+    - The comparer is called on elements owned by other threads, so elements
+      must not be modified while they are in the queue.
+*/
+typedef struct _cpriqueue_t
+{
+  cpriqueue_shard_t* m_shards;
+  int m_count;
+  atomic_int m_size;
+} cpriqueue_t;
+
+
+int    cpriqueue_init    (cpriqueue_t *q, int shards, int(*comparer)(const void *, const void *));
+
+int    cpriqueue_offer   (cpriqueue_t *q, void *ptr);
+void * cpriqueue_poll    (cpriqueue_t *q);
+int    cpriqueue_size    (cpriqueue_t *q);
+
+void   cpriqueue_destroy (cpriqueue_t *q);
+
+#endif /* LIBCPRIQUEUE_H_ */
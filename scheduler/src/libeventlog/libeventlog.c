@@ -0,0 +1,204 @@
+/** @file libeventlog.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libeventlog.h"
+
+// Records buffered before each write
+#define EVENTLOG_BUFFER 4096
+
+
+static void eventlog_flush(eventlog_t *log)
+{
+	if(log->m_size > 0 && fwrite(log->m_buffer, sizeof(eventlog_record_t), log->m_size, log->m_file) != (size_t)log->m_size)
+	{
+		log->m_error = 1;
+	}
+	log->m_size = 0;
+}
+
+
+/**
+  Initializes the eventlog_t data structure and writes the log header.
+
+  @param log a pointer to an instance of the eventlog_t data structure
+  @param out the stream to write to, opened in binary mode
+  @param cores the number of cores in the run
+  @param scheme the scheme_t of the run
+  @param quantum the quantum of the run, 0 if it has none
+  @return 0 on success
+  @return -1 if memory could not be allocated or the header could not be written
+ */
+int eventlog_open(eventlog_t *log, FILE *out, int cores, int scheme, int quantum)
+{
+	eventlog_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, EVENTLOG_MAGIC, sizeof(header.magic));
+	header.version = EVENTLOG_VERSION;
+	header.cores = cores;
+	header.scheme = scheme;
+	header.quantum = quantum;
+
+	log->m_file = out;
+	log->m_capacity = EVENTLOG_BUFFER;
+	log->m_size = 0;
+	log->m_count = 0;
+	log->m_error = 0;
+	log->m_buffer = malloc(log->m_capacity * sizeof(eventlog_record_t));
+	if(log->m_buffer == NULL || fwrite(&header, sizeof(header), 1, out) != 1)
+	{
+		free(log->m_buffer);
+		log->m_buffer = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+
+/**
+  Appends one record. Records must be appended in time order.
+
+  @param log a pointer to an instance of the eventlog_t data structure
+  @param time the time of the event
+  @param type what happened
+  @param job_id the job it happened to
+  @param core_id the core it happened on, or -1
+  @param result see eventlog_type_t
+ */
+void eventlog_append(eventlog_t *log, int time, eventlog_type_t type, int job_id, int core_id, int result)
+{
+	eventlog_record_t *record = &log->m_buffer[log->m_size++];
+	record->time = time;
+	record->type = type;
+	record->job_id = job_id;
+	record->core_id = core_id;
+	record->result = result;
+	log->m_count++;
+	if(log->m_size == log->m_capacity)
+	{
+		eventlog_flush(log);
+	}
+}
+
+
+/**
+  Returns the number of records appended.
+
+  @param log a pointer to an instance of the eventlog_t data structure
+  @return the number of records appended
+ */
+long long eventlog_count(eventlog_t *log)
+{
+	return log->m_count;
+}
+
+
+/**
+  Writes out any buffered records and frees the buffer. The stream itself
+  is left open.
+
+  @param log a pointer to an instance of the eventlog_t data structure
+  @return 0 on success, -1 if any write failed
+ */
+int eventlog_close(eventlog_t *log)
+{
+	eventlog_flush(log);
+	free(log->m_buffer);
+	log->m_buffer = NULL;
+	return log->m_error || fflush(log->m_file) != 0 ? -1 : 0;
+}
+
+
+/**
+  Maps a log written by eventlog_t into memory for reading. A trailing
+  partial record, as left by a run that was cut short, is ignored.
+
+  @param view a pointer to an instance of the eventlog_view_t data structure
+  @param path the log file
+  @return 0 on success
+  @return -1 if the file cannot be read or is not an event log
+ */
+int eventlog_map(eventlog_view_t *view, const char *path)
+{
+	struct stat status;
+	int fd = open(path, O_RDONLY);
+	memset(view, 0, sizeof(*view));
+	if(fd == -1)
+	{
+		return -1;
+	}
+	if(fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(eventlog_header_t))
+	{
+		close(fd);
+		return -1;
+	}
+
+	view->m_length = status.st_size;
+	view->m_map = mmap(NULL, view->m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(view->m_map == MAP_FAILED)
+	{
+		view->m_map = NULL;
+		return -1;
+	}
+
+	view->m_header = view->m_map;
+	if(memcmp(view->m_header->magic, EVENTLOG_MAGIC, sizeof(view->m_header->magic)) != 0 ||
+	   view->m_header->version != EVENTLOG_VERSION)
+	{
+		eventlog_unmap(view);
+		return -1;
+	}
+	view->m_records = (eventlog_record_t *)(view->m_header + 1);
+	view->m_count = (view->m_length - sizeof(eventlog_header_t)) / sizeof(eventlog_record_t);
+	return 0;
+}
+
+
+/**
+  Finds the first record at or after a time by binary search.
+
+  @param view a pointer to an instance of the eventlog_view_t data structure
+  @param time the time to look for
+  @return the index of the first record with a time of at least time
+  @return the number of records if there is none
+ */
+long long eventlog_seek(eventlog_view_t *view, int time)
+{
+	long long low = 0, high = view->m_count;
+	while(low < high)
+	{
+		long long middle = low + (high - low) / 2;
+		if(view->m_records[middle].time < time)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+
+/**
+  Unmaps a log mapped by eventlog_map().
+
+  @param view a pointer to an instance of the eventlog_view_t data structure
+ */
+void eventlog_unmap(eventlog_view_t *view)
+{
+	if(view->m_map != NULL)
+	{
+		munmap(view->m_map, view->m_length);
+	}
+	memset(view, 0, sizeof(*view));
+}
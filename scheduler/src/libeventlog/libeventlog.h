@@ -0,0 +1,91 @@
+/** @file libeventlog.h
+ */
+
+#ifndef LIBEVENTLOG_H_
+#define LIBEVENTLOG_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define EVENTLOG_MAGIC "SCHEDLOG"
+#define EVENTLOG_VERSION 1
+
+/**
+  What a record describes. result means something different for each:
+    - ARRIVAL: job arrived and was put on core (-1 if it waits); result is its running time
+    - FINISH: job finished on core; result is the job the core runs next (-1 for none)
+    - EXPIRY: job's quantum expired on core; result is the job the core runs next
+    - PREEMPT: job was taken off core by an arrival or wake-up; result is the job that took it
+    - BLOCK: job blocked on I/O on core; result is the job the core runs next
+    - WAKE: job woke from I/O and was put on core (-1 if it waits); result is its next CPU burst
+    - START: job was given core outside the events above, as gang scheduling does; result is 0
+    - PENALTY: the job just put on core first pays result time units of dispatch overhead
+
+  A FINISH or BLOCK of a job holding several cores frees all of them.
+*/
+typedef enum {EVENTLOG_ARRIVAL = 0, EVENTLOG_FINISH, EVENTLOG_EXPIRY, EVENTLOG_PREEMPT, EVENTLOG_BLOCK, EVENTLOG_WAKE,
+              EVENTLOG_START, EVENTLOG_PENALTY, EVENTLOG_TYPES} eventlog_type_t;
+
+/**
+  One scheduling event. The log is a header followed by these records in
+  the order the events happened, so time never decreases; both are written
+  in native byte order.
+*/
+typedef struct _eventlog_record_t
+{
+  int time;
+  int type;
+  int job_id;
+  int core_id;
+  int result;
+} eventlog_record_t;
+
+/**
+  Start of every log: which run it records.
+*/
+typedef struct _eventlog_header_t
+{
+  char magic[8];
+  int version;
+  int cores;
+  int scheme;
+  int quantum;
+} eventlog_header_t;
+
+/**
+  Buffered writer. Records collect in m_buffer and reach the file one
+  buffer-sized write at a time, so logging an event costs a few stores.
+*/
+typedef struct _eventlog_t
+{
+  FILE* m_file;
+  eventlog_record_t* m_buffer;
+  int m_size;
+  int m_capacity;
+  long long m_count;
+  int m_error;
+} eventlog_t;
+
+/**
+  Read-only view of a whole log, mapped into memory.
+*/
+typedef struct _eventlog_view_t
+{
+  void* m_map;
+  size_t m_length;
+  eventlog_header_t* m_header;
+  eventlog_record_t* m_records;
+  long long m_count;
+} eventlog_view_t;
+
+
+int       eventlog_open   (eventlog_t *log, FILE *out, int cores, int scheme, int quantum);
+void      eventlog_append (eventlog_t *log, int time, eventlog_type_t type, int job_id, int core_id, int result);
+long long eventlog_count  (eventlog_t *log);
+int       eventlog_close  (eventlog_t *log);
+
+int       eventlog_map    (eventlog_view_t *view, const char *path);
+long long eventlog_seek   (eventlog_view_t *view, int time);
+void      eventlog_unmap  (eventlog_view_t *view);
+
+#endif /* LIBEVENTLOG_H_ */
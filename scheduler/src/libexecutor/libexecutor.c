@@ -0,0 +1,329 @@
+/** @file libexecutor.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+#include "libexecutor.h"
+
+//polls of an empty mailbox before a worker goes to sleep on its semaphore
+#define SPIN_LIMIT 4096
+
+/**
+  A submitted task. job_id is the id the scheduler knows the task by.
+*/
+typedef struct _executor_task_t
+{
+  task_fn fn;
+  void* arg;
+  int job_id;
+} executor_task_t;
+
+/**
+  One worker thread per scheduler core.
+
+  mailbox is a single-slot handoff written by the submitting thread and
+  drained by the worker; the scheduler only hands a task to an idle core,
+  so the slot never holds more than one task. The worker spins on the slot
+  for a while and only then parks on wakeup, so a busy executor dispatches
+  without any system call.
+*/
+typedef struct _executor_worker_t
+{
+  pthread_t thread;
+  int core_id;
+  _Atomic(executor_task_t*) mailbox;
+  atomic_int sleeping;
+  sem_t wakeup;
+  long long slice_start;
+} executor_worker_t;
+
+static executor_worker_t* pool;
+static int worker_count;
+static scheme_t executor_scheme;
+static int executor_quantum_us;
+static struct timespec start_time;
+static atomic_int stopping;
+
+//sched_lock guards every call into libscheduler and the fields below it
+static pthread_mutex_t sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;
+static executor_task_t** tasks;  //indexed by job_id
+static int task_capacity;
+static int next_job_id;
+static int outstanding;
+
+static __thread executor_worker_t* current_worker;
+
+
+static long long now_us()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start_time.tv_sec) * 1000000LL + (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+//the scheduler's clock: milliseconds since executor_start(), which fits an
+//int for 24 days where microseconds would wrap after 35 minutes
+static int scheduler_now()
+{
+  return (int)(now_us() / 1000);
+}
+
+static int is_quantum_scheme()
+{
+  return executor_scheme == RR || executor_scheme == STRIDE || executor_scheme == LOTTERY;
+}
+
+static void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+static void handoff(executor_worker_t* worker, executor_task_t* task)
+{
+  atomic_store_explicit(&worker->mailbox, task, memory_order_release);
+  if(atomic_exchange(&worker->sleeping, 0))
+  {
+    sem_post(&worker->wakeup);
+  }
+}
+
+//blocks until a task is handed to worker, or returns NULL on shutdown
+static executor_task_t* receive(executor_worker_t* worker)
+{
+  executor_task_t* task;
+  for(;;)
+  {
+    for(int spin = 0; spin < SPIN_LIMIT; spin++)
+    {
+      task = atomic_exchange_explicit(&worker->mailbox, NULL, memory_order_acquire);
+      if(task != NULL)
+      {
+        return task;
+      }
+      if(atomic_load_explicit(&stopping, memory_order_relaxed))
+      {
+        return NULL;
+      }
+      cpu_relax();
+    }
+    //announce the sleep before the final check so handoff() cannot miss us
+    atomic_store(&worker->sleeping, 1);
+    task = atomic_exchange(&worker->mailbox, NULL);
+    if(task != NULL)
+    {
+      atomic_store(&worker->sleeping, 0);
+      return task;
+    }
+    if(atomic_load(&stopping))
+    {
+      return NULL;
+    }
+    sem_wait(&worker->wakeup);
+  }
+}
+
+static void* worker_main(void* arg)
+{
+  executor_worker_t* worker = (executor_worker_t*)arg;
+  current_worker = worker;
+  executor_task_t* task = receive(worker);
+  while(task != NULL)
+  {
+    worker->slice_start = now_us();
+    int yielded = task->fn(task->arg);
+    if(yielded && !is_quantum_scheme())
+    {
+      //nothing to rotate to outside RR-style schemes, keep going
+      continue;
+    }
+
+    pthread_mutex_lock(&sched_lock);
+    int next;
+    if(yielded)
+    {
+      next = scheduler_quantum_expired(worker->core_id, scheduler_now());
+    }
+    else
+    {
+      next = scheduler_job_finished(worker->core_id, task->job_id, scheduler_now());
+      tasks[task->job_id] = NULL;
+      free(task);
+      outstanding--;
+      if(outstanding == 0)
+      {
+        pthread_cond_broadcast(&idle_cond);
+      }
+    }
+    task = next != -1 ? tasks[next] : NULL;
+    pthread_mutex_unlock(&sched_lock);
+
+    if(task == NULL)
+    {
+      task = receive(worker);
+    }
+  }
+  return NULL;
+}
+
+
+/**
+  Starts the executor and its worker threads.
+
+  The executor owns the scheduler: it calls scheduler_start_up() with one
+  core per worker and feeds every submission, completion and yield through
+  the scheduler, running whatever task it picks for a core on that core's
+  worker. Tasks cannot be interrupted, so the preemptive schemes (PSJF,
+  PPRI) are not supported.
+
+  Assumptions:
+    - Only one executor runs per process, and nothing else uses libscheduler's default instance meanwhile.
+    - The threads calling into the executor have not switched away from the default instance with scheduler_use().
+
+  @param workers number of worker threads (scheduler cores) to start
+  @param scheme the scheduling scheme used to pick the next task
+  @param quantum_us time slice in microseconds for RR, STRIDE and LOTTERY
+  @return 0 on success
+  @return -1 if the scheme is not supported or the threads could not be started
+ */
+int executor_start(int workers, scheme_t scheme, int quantum_us)
+{
+  if(workers <= 0 || scheme == PSJF || scheme == PPRI)
+  {
+    return -1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+  executor_scheme = scheme;
+  executor_quantum_us = quantum_us > 0 ? quantum_us : 1000;
+  atomic_store(&stopping, 0);
+  tasks = NULL;
+  task_capacity = 0;
+  next_job_id = 0;
+  outstanding = 0;
+
+  scheduler_start_up(workers, scheme);
+
+  worker_count = workers;
+  pool = malloc(sizeof(executor_worker_t) * worker_count);
+  for(int i = 0; i < worker_count; i++)
+  {
+    pool[i].core_id = i;
+    atomic_init(&pool[i].mailbox, NULL);
+    atomic_init(&pool[i].sleeping, 0);
+    sem_init(&pool[i].wakeup, 0, 0);
+    pool[i].slice_start = 0;
+  }
+  for(int i = 0; i < worker_count; i++)
+  {
+    if(pthread_create(&pool[i].thread, NULL, worker_main, &pool[i]) != 0)
+    {
+      worker_count = i;
+      executor_shutdown();
+      return -1;
+    }
+  }
+  return 0;
+}
+
+
+/**
+  Submits a task. It starts immediately if the scheduler assigns it an
+  idle worker, otherwise it waits in the scheduler's queue.
+
+  @param fn the task function
+  @param arg argument passed to fn every time it runs
+  @param estimated_run_time expected run time, used as the key by SJF
+  @param priority priority of the task (lower is more important); ticket count for STRIDE and LOTTERY
+  @return the job id the task was given
+ */
+int executor_submit(task_fn fn, void *arg, int estimated_run_time, int priority)
+{
+  executor_task_t* task = malloc(sizeof(executor_task_t));
+  task->fn = fn;
+  task->arg = arg;
+
+  pthread_mutex_lock(&sched_lock);
+  int job_id = next_job_id++;
+  task->job_id = job_id;
+  if(task->job_id == task_capacity)
+  {
+    task_capacity = task_capacity == 0 ? 1024 : task_capacity * 2;
+    tasks = realloc(tasks, sizeof(executor_task_t*) * task_capacity);
+  }
+  tasks[task->job_id] = task;
+  outstanding++;
+  int core_id = scheduler_new_job(job_id, scheduler_now(), estimated_run_time > 0 ? estimated_run_time : 1, priority);
+  pthread_mutex_unlock(&sched_lock);
+
+  //the core stays reserved for this task until its worker reports back, so
+  //the handoff can happen outside the lock (task may be freed after it)
+  if(core_id != -1)
+  {
+    handoff(&pool[core_id], task);
+  }
+  return job_id;
+}
+
+
+/**
+  Cooperative time slicing for RR, STRIDE and LOTTERY. A running task should
+  call this periodically and return non-zero from its function when it
+  returns 1.
+
+  @return 1 if the calling task has used up its quantum
+  @return 0 otherwise, or when not called from a task
+ */
+int executor_should_yield()
+{
+  if(current_worker == NULL || !is_quantum_scheme())
+  {
+    return 0;
+  }
+  return now_us() - current_worker->slice_start >= executor_quantum_us;
+}
+
+
+/**
+  Blocks until every submitted task has completed.
+ */
+void executor_wait()
+{
+  pthread_mutex_lock(&sched_lock);
+  while(outstanding > 0)
+  {
+    pthread_cond_wait(&idle_cond, &sched_lock);
+  }
+  pthread_mutex_unlock(&sched_lock);
+}
+
+
+/**
+  Waits for outstanding tasks, stops the workers and releases the scheduler.
+ */
+void executor_shutdown()
+{
+  executor_wait();
+  atomic_store(&stopping, 1);
+  for(int i = 0; i < worker_count; i++)
+  {
+    sem_post(&pool[i].wakeup);
+  }
+  for(int i = 0; i < worker_count; i++)
+  {
+    pthread_join(pool[i].thread, NULL);
+    sem_destroy(&pool[i].wakeup);
+  }
+  scheduler_clean_up();
+  free(pool);
+  free(tasks);
+  pool = NULL;
+  tasks = NULL;
+  worker_count = 0;
+}
@@ -0,0 +1,25 @@
+/** @file libexecutor.h
+ */
+
+#ifndef LIBEXECUTOR_H_
+#define LIBEXECUTOR_H_
+
+#include "../libscheduler/libscheduler.h"
+
+/**
+  A unit of work run by the executor.
+
+  The function returns 0 once the task is complete. Under a quantum-driven
+  scheme (RR, STRIDE, LOTTERY) a long task should poll executor_should_yield()
+  and return non-zero when it says so; the task is then requeued and called
+  again later with the same argument, so it must keep its own progress in arg.
+*/
+typedef int (*task_fn) (void *arg);
+
+int   executor_start          (int workers, scheme_t scheme, int quantum_us);
+int   executor_submit         (task_fn fn, void *arg, int estimated_run_time, int priority);
+int   executor_should_yield   ();
+void  executor_wait           ();
+void  executor_shutdown       ();
+
+#endif /* LIBEXECUTOR_H_ */
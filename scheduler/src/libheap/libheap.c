@@ -0,0 +1,237 @@
+/** @file libheap.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "libheap.h"
+
+
+static void heap_swap(heap_t *h, int i, int j)
+{
+	void* temp = h->m_entries[i];
+	h->m_entries[i] = h->m_entries[j];
+	h->m_entries[j] = temp;
+}
+
+static int heap_sift_up(heap_t *h, int index)
+{
+	while(index > 0)
+	{
+		int parent = (index - 1) / 2;
+		if(h->comp(h->m_entries[index], h->m_entries[parent]) >= 0)
+		{
+			break;
+		}
+		heap_swap(h, index, parent);
+		index = parent;
+	}
+	return index;
+}
+
+static void heap_sift_down(heap_t *h, int index)
+{
+	for(;;)
+	{
+		int left = 2 * index + 1;
+		int smallest = index;
+		if(left < h->m_size && h->comp(h->m_entries[left], h->m_entries[smallest]) < 0)
+		{
+			smallest = left;
+		}
+		if(left + 1 < h->m_size && h->comp(h->m_entries[left + 1], h->m_entries[smallest]) < 0)
+		{
+			smallest = left + 1;
+		}
+		if(smallest == index)
+		{
+			return;
+		}
+		heap_swap(h, index, smallest);
+		index = smallest;
+	}
+}
+
+
+/**
+  Initializes the heap_t data structure.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param comparer a function pointer that compares two elements.
+  See also @ref comparer-page
+ */
+void heap_init(heap_t *h, int(*comparer)(const void *, const void *))
+{
+	h->m_entries = NULL;
+	h->m_size = 0;
+	h->m_capacity = 0;
+	h->comp = comparer;
+}
+
+
+/**
+  Inserts the specified element into the heap.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param ptr a pointer to the data to be inserted into the heap
+  @return the array index where ptr ended up, where 0 indicates ptr is the new minimum
+  @return -1 if memory could not be allocated
+ */
+int heap_offer(heap_t *h, void *ptr)
+{
+	if(h->m_size == h->m_capacity)
+	{
+		int capacity = h->m_capacity == 0 ? 16 : h->m_capacity * 2;
+		void** entries = realloc(h->m_entries, capacity * sizeof(void*));
+		if(entries == NULL)
+		{
+			return -1;
+		}
+		h->m_entries = entries;
+		h->m_capacity = capacity;
+	}
+	h->m_entries[h->m_size] = ptr;
+	h->m_size++;
+	return heap_sift_up(h, h->m_size - 1);
+}
+
+
+/**
+  Appends elements to the heap's array as they are, without sifting. This
+  rebuilds a heap exactly as heap_at() saw it, index by index, so elements
+  whose keys changed while they were in the heap keep their places too.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param ptrs the elements in array order
+  @param count the number of elements in ptrs
+  @return the number of elements appended
+  @return -1 if memory could not be allocated
+ */
+int heap_append_all(heap_t *h, void **ptrs, int count)
+{
+	if(h->m_size + count > h->m_capacity)
+	{
+		int capacity = h->m_capacity == 0 ? 16 : h->m_capacity;
+		while(capacity < h->m_size + count)
+		{
+			capacity *= 2;
+		}
+		void** entries = realloc(h->m_entries, capacity * sizeof(void*));
+		if(entries == NULL)
+		{
+			return -1;
+		}
+		h->m_entries = entries;
+		h->m_capacity = capacity;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		h->m_entries[h->m_size++] = ptrs[i];
+	}
+	return count;
+}
+
+
+/**
+  Retrieves, but does not remove, the minimum element of the heap.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @return pointer to the minimum element
+  @return NULL if the heap is empty
+ */
+void *heap_peek(heap_t *h)
+{
+	if(h->m_size == 0)
+	{
+		return NULL;
+	}
+	return h->m_entries[0];
+}
+
+
+/**
+  Retrieves and removes the minimum element of the heap.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @return the minimum element
+  @return NULL if the heap is empty
+ */
+void *heap_poll(heap_t *h)
+{
+	return heap_remove_at(h, 0);
+}
+
+
+/**
+  Returns the element stored at the given array position. Positions follow
+  heap order, not sorted order; this is meant for iteration and debugging.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param index array position of the element
+  @return the element at index
+  @return NULL if index is out of range
+ */
+void *heap_at(heap_t *h, int index)
+{
+	if(index < 0 || index >= h->m_size)
+	{
+		return NULL;
+	}
+	return h->m_entries[index];
+}
+
+
+/**
+  Removes the element stored at the given array position and restores the
+  heap property.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param index array position of the element to be removed
+  @return the element removed
+  @return NULL if index is out of range
+ */
+void *heap_remove_at(heap_t *h, int index)
+{
+	if(index < 0 || index >= h->m_size)
+	{
+		return NULL;
+	}
+	void* entry = h->m_entries[index];
+	h->m_size--;
+	if(index != h->m_size)
+	{
+		h->m_entries[index] = h->m_entries[h->m_size];
+		if(heap_sift_up(h, index) == index)
+		{
+			heap_sift_down(h, index);
+		}
+	}
+	return entry;
+}
+
+
+/**
+  Returns the number of elements in the heap.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @return the number of elements in the heap
+ */
+int heap_size(heap_t *h)
+{
+	return h->m_size;
+}
+
+
+/**
+  Destroys and frees all the memory associated with h. The elements
+  themselves are owned by the caller and are not freed.
+
+  @param h a pointer to an instance of the heap_t data structure
+ */
+void heap_destroy(heap_t *h)
+{
+	free(h->m_entries);
+	h->m_entries = NULL;
+	h->m_size = 0;
+	h->m_capacity = 0;
+}
@@ -0,0 +1,36 @@
+/** @file libheap.h
+ */
+
+#ifndef LIBHEAP_H_
+#define LIBHEAP_H_
+
+/**
+  Array-backed binary min-heap.
+
+  Unlike priqueue_t, which keeps a fully sorted list, heap_t only guarantees
+  that heap_peek()/heap_poll() return the smallest element according to the
+  comparer, giving O(log n) offer and poll. The comparer should be a strict
+  ordering (break ties explicitly) since the heap is not stable.
+*/
+typedef struct _heap_t
+{
+  void** m_entries;
+  int m_size;
+  int m_capacity;
+  int (*comp)(const void *a, const void *b);
+} heap_t;
+
+
+void   heap_init     (heap_t *h, int(*comparer)(const void *, const void *));
+
+int    heap_offer    (heap_t *h, void *ptr);
+int    heap_append_all(heap_t *h, void **ptrs, int count);
+void * heap_peek     (heap_t *h);
+void * heap_poll     (heap_t *h);
+void * heap_at       (heap_t *h, int index);
+void * heap_remove_at(heap_t *h, int index);
+int    heap_size     (heap_t *h);
+
+void   heap_destroy  (heap_t *h);
+
+#endif /* LIBHEAP_H_ */
@@ -0,0 +1,191 @@
+/** @file libhistogram.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "libhistogram.h"
+
+
+static int histogram_index(int value)
+{
+	if(value < HISTOGRAM_EXACT)
+	{
+		return value;
+	}
+	int exponent = 31 - __builtin_clz((unsigned int)value);
+	int shift = exponent - HISTOGRAM_SUB_BITS;
+	int sub = (value >> shift) - (1 << HISTOGRAM_SUB_BITS);
+	return HISTOGRAM_EXACT + (exponent - HISTOGRAM_SUB_BITS - 1) * (1 << HISTOGRAM_SUB_BITS) + sub;
+}
+
+/*
+ * Middle of the range of values that land in bucket index.
+ */
+static long long histogram_midpoint(int index)
+{
+	if(index < HISTOGRAM_EXACT)
+	{
+		return index;
+	}
+	int offset = index - HISTOGRAM_EXACT;
+	int shift = offset / (1 << HISTOGRAM_SUB_BITS) + 1;
+	int sub = offset % (1 << HISTOGRAM_SUB_BITS);
+	long long lower = (long long)((1 << HISTOGRAM_SUB_BITS) + sub) << shift;
+	return lower + ((1LL << shift) - 1) / 2;
+}
+
+
+/**
+  Initializes the histogram_t data structure.
+
+  @param h a pointer to an instance of the histogram_t data structure
+ */
+void histogram_init(histogram_t *h)
+{
+	memset(h->m_counts, 0, sizeof(h->m_counts));
+	h->m_count = 0;
+	h->m_sum = 0;
+	h->m_min = INT_MAX;
+	h->m_max = 0;
+}
+
+
+/**
+  Adds one value to the histogram. Negative values are recorded as 0.
+
+  @param h a pointer to an instance of the histogram_t data structure
+  @param value the value to record
+ */
+void histogram_record(histogram_t *h, int value)
+{
+	if(value < 0)
+	{
+		value = 0;
+	}
+	h->m_counts[histogram_index(value)]++;
+	h->m_count++;
+	h->m_sum += value;
+	if(value < h->m_min)
+	{
+		h->m_min = value;
+	}
+	if(value > h->m_max)
+	{
+		h->m_max = value;
+	}
+}
+
+
+/**
+  Estimates the value below which a fraction q of the recorded values fall.
+  The answer is exact for values below HISTOGRAM_EXACT and within the
+  bucket precision above that; q = 0 and q = 1 return the exact minimum and
+  maximum.
+
+  @param h a pointer to an instance of the histogram_t data structure
+  @param q the quantile, between 0 and 1 (0.99 for p99)
+  @return the estimated quantile
+  @return 0 if nothing has been recorded
+ */
+int histogram_quantile(histogram_t *h, double q)
+{
+	if(h->m_count == 0)
+	{
+		return 0;
+	}
+	if(q <= 0.0)
+	{
+		return h->m_min;
+	}
+	if(q >= 1.0)
+	{
+		return h->m_max;
+	}
+
+	// Smallest rank whose cumulative share reaches q
+	long long rank = (long long)(q * h->m_count);
+	if(rank < q * h->m_count)
+	{
+		rank++;
+	}
+	if(rank < 1)
+	{
+		rank = 1;
+	}
+
+	long long seen = 0;
+	int i;
+	for(i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		seen += h->m_counts[i];
+		if(seen >= rank)
+		{
+			break;
+		}
+	}
+
+	long long value = histogram_midpoint(i);
+	if(value < h->m_min)
+	{
+		value = h->m_min;
+	}
+	if(value > h->m_max)
+	{
+		value = h->m_max;
+	}
+	return (int)value;
+}
+
+
+/**
+  Returns the number of values recorded.
+
+  @param h a pointer to an instance of the histogram_t data structure
+  @return the number of values recorded
+ */
+long long histogram_count(histogram_t *h)
+{
+	return h->m_count;
+}
+
+
+/**
+  Returns the exact sum of the values recorded.
+
+  @param h a pointer to an instance of the histogram_t data structure
+  @return the sum of the values recorded
+ */
+long long histogram_sum(histogram_t *h)
+{
+	return h->m_sum;
+}
+
+
+/**
+  Adds every value recorded in src to dst, as if each had been recorded
+  into dst directly. Merging is exact, so a histogram kept per thread and
+  merged at the end reads back the same as one shared histogram.
+
+  @param dst a pointer to the histogram_t that receives the values
+  @param src a pointer to the histogram_t to add, which is left unchanged
+ */
+void histogram_merge(histogram_t *dst, histogram_t *src)
+{
+	int i;
+	for(i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		dst->m_counts[i] += src->m_counts[i];
+	}
+	dst->m_count += src->m_count;
+	dst->m_sum += src->m_sum;
+	if(src->m_min < dst->m_min)
+	{
+		dst->m_min = src->m_min;
+	}
+	if(src->m_max > dst->m_max)
+	{
+		dst->m_max = src->m_max;
+	}
+}
@@ -0,0 +1,38 @@
+/** @file libhistogram.h
+ */
+
+#ifndef LIBHISTOGRAM_H_
+#define LIBHISTOGRAM_H_
+
+#define HISTOGRAM_SUB_BITS 6
+#define HISTOGRAM_EXACT (2 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS (HISTOGRAM_EXACT + (31 - HISTOGRAM_SUB_BITS - 1) * (1 << HISTOGRAM_SUB_BITS))
+
+/**
+  Fixed-size log-linear histogram of non-negative integers.
+
+  Values below HISTOGRAM_EXACT get a bucket each; above that every power of
+  two is split into 2^HISTOGRAM_SUB_BITS buckets, so any quantile read back
+  is within 1/2^(HISTOGRAM_SUB_BITS+1) (under 1%) of a value that was
+  actually recorded. Memory is constant no matter how many values are
+  recorded, and the sum is kept exactly in 64 bits.
+*/
+typedef struct _histogram_t
+{
+  long long m_counts[HISTOGRAM_BUCKETS];
+  long long m_count;
+  long long m_sum;
+  int m_min;
+  int m_max;
+} histogram_t;
+
+
+void      histogram_init    (histogram_t *h);
+
+void      histogram_record  (histogram_t *h, int value);
+int       histogram_quantile(histogram_t *h, double q);
+long long histogram_count   (histogram_t *h);
+long long histogram_sum     (histogram_t *h);
+void      histogram_merge   (histogram_t *dst, histogram_t *src);
+
+#endif /* LIBHISTOGRAM_H_ */
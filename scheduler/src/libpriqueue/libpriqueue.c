@@ -68,6 +68,151 @@ int priqueue_offer(priqueue_t *q, void *ptr)
 }
 
 
+/**
+  Inserts several elements in one pass over the queue.
+
+  The result is the same as calling priqueue_offer() on each element of ptrs
+  in order: the elements are stable-sorted with the comparer and then merged
+  into the list, so the queue is walked once instead of once per element.
+
+  @param q a pointer to an instance of the priqueue_t data structure
+  @param ptrs the elements to insert, in the order they would have been offered
+  @param count the number of elements in ptrs
+  @return the number of elements inserted
+ */
+int priqueue_offer_all(priqueue_t *q, void **ptrs, int count)
+{
+	void** sorted = malloc(count * sizeof(void*));
+	void** scratch = malloc(count * sizeof(void*));
+	if(sorted==NULL || scratch==NULL)
+	{
+		free(sorted);
+		free(scratch);
+		for(int i = 0; i < count; i++)
+		{
+			priqueue_offer(q, ptrs[i]);
+		}
+		return count;
+	}
+
+	//bottom-up merge sort; the left run wins ties so equal elements keep
+	//their offer order, as they would with repeated priqueue_offer() calls
+	for(int i = 0; i < count; i++)
+	{
+		sorted[i] = ptrs[i];
+	}
+	for(int width = 1; width < count; width *= 2)
+	{
+		for(int lo = 0; lo < count; lo += 2 * width)
+		{
+			int mid = lo + width < count ? lo + width : count;
+			int hi = lo + 2 * width < count ? lo + 2 * width : count;
+			int l = lo, r = mid, out = lo;
+			while(l < mid && r < hi)
+			{
+				scratch[out++] = q->comp(sorted[l], sorted[r]) <= 0 ? sorted[l++] : sorted[r++];
+			}
+			while(l < mid)
+			{
+				scratch[out++] = sorted[l++];
+			}
+			while(r < hi)
+			{
+				scratch[out++] = sorted[r++];
+			}
+		}
+		void** temp = sorted;
+		sorted = scratch;
+		scratch = temp;
+	}
+
+	//merge into the list; the insertion point only ever moves forward
+	node_t* temp = q->m_front;
+	node_t* prev = NULL;
+	for(int i = 0; i < count; i++)
+	{
+		while(temp!=NULL && q->comp(temp->m_entry, sorted[i]) <= 0)
+		{
+			prev = temp;
+			temp = temp->m_next;
+		}
+		node_t* newNode = malloc(sizeof(*newNode));
+		newNode->m_entry = sorted[i];
+		newNode->m_next = temp;
+		if(prev==NULL)
+		{
+			q->m_front = newNode;
+		}
+		else
+		{
+			prev->m_next = newNode;
+		}
+		prev = newNode;
+		q->m_size++;
+	}
+
+	free(sorted);
+	free(scratch);
+	return count;
+}
+
+
+/**
+  Copies the elements, front to back, into ptrs.
+
+  @param q a pointer to an instance of the priqueue_t data structure
+  @param ptrs receives the elements; must have room for priqueue_size(q) of them
+  @return the number of elements copied
+ */
+int priqueue_to_array(priqueue_t *q, void **ptrs)
+{
+	int count = 0;
+	for(node_t* temp = q->m_front; temp!=NULL; temp = temp->m_next)
+	{
+		ptrs[count++] = temp->m_entry;
+	}
+	return count;
+}
+
+
+/**
+  Appends elements to the back of this queue in the order given, without
+  consulting the comparer. This rebuilds a queue exactly as
+  priqueue_to_array() saw it, including orders the comparer would no longer
+  produce because the elements changed after they were offered.
+
+  @param q a pointer to an instance of the priqueue_t data structure
+  @param ptrs the elements to append, front to back
+  @param count the number of elements in ptrs
+  @return the number of elements appended
+ */
+int priqueue_append_all(priqueue_t *q, void **ptrs, int count)
+{
+	node_t* tail = q->m_front;
+	while(tail!=NULL && tail->m_next!=NULL)
+	{
+		tail = tail->m_next;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		node_t* newNode = malloc(sizeof(*newNode));
+		newNode->m_entry = ptrs[i];
+		newNode->m_next = NULL;
+		if(tail==NULL)
+		{
+			q->m_front = newNode;
+		}
+		else
+		{
+			tail->m_next = newNode;
+		}
+		tail = newNode;
+		q->m_size++;
+	}
+	return count;
+}
+
+
 /**
   Retrieves, but does not remove, the head of this queue, returning NULL if
   this queue is empty.
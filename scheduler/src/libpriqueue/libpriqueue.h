@@ -28,6 +28,9 @@ typedef struct _priqueue_t
 void   priqueue_init     (priqueue_t *q, int(*comparer)(const void *, const void *));
 
 int    priqueue_offer    (priqueue_t *q, void *ptr);
+int    priqueue_offer_all(priqueue_t *q, void **ptrs, int count);
+int    priqueue_to_array (priqueue_t *q, void **ptrs);
+int    priqueue_append_all(priqueue_t *q, void **ptrs, int count);
 void * priqueue_peek     (priqueue_t *q);
 void * priqueue_poll     (priqueue_t *q);
 void * priqueue_at       (priqueue_t *q, int index);
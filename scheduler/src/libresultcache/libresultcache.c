@@ -0,0 +1,419 @@
+/** @file libresultcache.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "libresultcache.h"
+
+// Bytes read at a time when hashing a file or copying output
+#define RESULTCACHE_BUFFER 65536
+#define FNV_PRIME 0x100000001b3ULL
+
+
+/*
+ * Writes all of length bytes to fd, which may take several writes on a pipe.
+ * Returns 0 on success, -1 on a write error.
+ */
+static int write_all(int fd, const char *data, size_t length)
+{
+	while(length > 0)
+	{
+		ssize_t written = write(fd, data, length);
+		if(written <= 0)
+		{
+			return -1;
+		}
+		data += written;
+		length -= written;
+	}
+	return 0;
+}
+
+/*
+ * Copies length bytes of the file open on from, starting at offset, to the
+ * stream out. Returns 0 on success, -1 on a read or write error.
+ */
+static int copy_out(int from, off_t offset, long long length, FILE *out)
+{
+	char *buffer = malloc(RESULTCACHE_BUFFER);
+	int ok = buffer != NULL;
+	while(ok && length > 0)
+	{
+		ssize_t got = pread(from, buffer, length < RESULTCACHE_BUFFER ? length : RESULTCACHE_BUFFER, offset);
+		ok = got > 0 && fwrite(buffer, 1, got, out) == (size_t)got;
+		offset += got;
+		length -= got;
+	}
+	free(buffer);
+	return ok && fflush(out) == 0 ? 0 : -1;
+}
+
+/*
+ * Appends the first length bytes of the file open on from to the file open
+ * on to. Returns 0 on success, -1 on a read or write error.
+ */
+static int append(int from, long long length, int to)
+{
+	char *buffer = malloc(RESULTCACHE_BUFFER);
+	int ok = buffer != NULL;
+	off_t offset = 0;
+	while(ok && length > 0)
+	{
+		ssize_t got = pread(from, buffer, length < RESULTCACHE_BUFFER ? length : RESULTCACHE_BUFFER, offset);
+		ok = got > 0 && write_all(to, buffer, got) == 0;
+		offset += got;
+		length -= got;
+	}
+	free(buffer);
+	return ok ? 0 : -1;
+}
+
+/*
+ * Points fd at to, keeping a duplicate of what it pointed at in *saved.
+ * Returns 0 on success, -1 with fd unchanged and *saved -1 on failure.
+ */
+static int redirect(int fd, int to, int *saved)
+{
+	*saved = dup(fd);
+	if(*saved < 0)
+	{
+		return -1;
+	}
+	if(dup2(to, fd) < 0)
+	{
+		close(*saved);
+		*saved = -1;
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Undoes redirect(), if it took effect.
+ */
+static void restore(int fd, int *saved)
+{
+	if(*saved >= 0)
+	{
+		dup2(*saved, fd);
+		close(*saved);
+		*saved = -1;
+	}
+}
+
+/*
+ * Deletes the entries in dir that another build of the program wrote. Only
+ * names of the form an entry or its temporary file takes are touched.
+ */
+static void prune(const char *dir, unsigned long long build)
+{
+	char own[17];
+	DIR *entries = opendir(dir);
+	struct dirent *entry;
+	if(entries == NULL)
+	{
+		return;
+	}
+	snprintf(own, sizeof(own), "%016llx", build);
+	while((entry = readdir(entries)) != NULL)
+	{
+		const char *name = entry->d_name;
+		if(strlen(name) >= 40 && strspn(name, "0123456789abcdef") == 16 && name[16] == '-' &&
+		   strspn(name + 17, "0123456789abcdef") == 16 && strncmp(name + 33, ".result", 7) == 0 &&
+		   (name[40] == '\0' || name[40] == '.') && strncmp(name, own, 16) != 0)
+		{
+			unlinkat(dirfd(entries), name, 0);
+		}
+	}
+	closedir(entries);
+}
+
+
+/**
+  Folds bytes into a 64-bit FNV-1a hash. Start from RESULTCACHE_SEED.
+
+  @param hash the hash so far
+  @param data the bytes to add
+  @param length the number of bytes
+  @return the new hash
+ */
+unsigned long long resultcache_hash(unsigned long long hash, const void *data, size_t length)
+{
+	const unsigned char *bytes = data;
+	for(size_t i = 0; i < length; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+
+/**
+  Folds the contents of a file, then its length, into a hash, so that two
+  files hashed one after the other cannot be mistaken for a different split
+  of the same bytes.
+
+  @param hash the hash to add to
+  @param path the file
+  @return 0 on success
+  @return -1 if the file could not be read, in which case hash is left as it was
+ */
+int resultcache_hash_file(unsigned long long *hash, const char *path)
+{
+	FILE *in = fopen(path, "rb");
+	char *buffer = malloc(RESULTCACHE_BUFFER);
+	unsigned long long result = *hash;
+	long long length = 0;
+	size_t got;
+	if(in == NULL || buffer == NULL)
+	{
+		if(in != NULL)
+		{
+			fclose(in);
+		}
+		free(buffer);
+		return -1;
+	}
+	while((got = fread(buffer, 1, RESULTCACHE_BUFFER, in)) > 0)
+	{
+		result = resultcache_hash(result, buffer, got);
+		length += got;
+	}
+	int failed = ferror(in);
+	fclose(in);
+	free(buffer);
+	if(failed)
+	{
+		return -1;
+	}
+	*hash = resultcache_hash(result, &length, sizeof(length));
+	return 0;
+}
+
+
+/**
+  Initializes the resultcache_t data structure for one run, creating dir if
+  it does not exist and deleting the entries other builds left in it, which
+  this build could never read.
+
+  @param cache a pointer to an instance of the resultcache_t data structure
+  @param dir the directory holding the entries
+  @param build a hash identifying the program, so a rebuild invalidates every entry
+  @param key a hash of everything the output depends on
+  @param args the run's arguments, stored in the entry and compared on a hit to rule out a collision of key
+  @param args_length the number of bytes of args
+  @return 0 on success
+  @return -1 if memory could not be allocated
+ */
+int resultcache_open(resultcache_t *cache, const char *dir, unsigned long long build, unsigned long long key,
+		const char *args, int args_length)
+{
+	size_t length = strlen(dir) + 48;
+	mkdir(dir, 0777);
+	prune(dir, build);
+	cache->m_path = malloc(length);
+	cache->m_temp = NULL;
+	cache->m_args = args;
+	cache->m_args_length = args_length;
+	cache->m_build = build;
+	cache->m_key = key;
+	cache->m_fd = -1;
+	cache->m_saved_fd = -1;
+	cache->m_temp_fd = -1;
+	cache->m_err_fd = -1;
+	cache->m_saved_err_fd = -1;
+	cache->m_err_temp_fd = -1;
+	if(cache->m_path == NULL)
+	{
+		return -1;
+	}
+	snprintf(cache->m_path, length, "%s/%016llx-%016llx.result", dir, build, key);
+	return 0;
+}
+
+
+/**
+  Writes the cached output and error output of the run to out and err, if
+  there is an entry for it.
+
+  @param cache a pointer to an instance of the resultcache_t data structure
+  @param out the stream to write the output to
+  @param err the stream to write the error output to
+  @return 1 on a hit, once both have been written
+  @return 0 on a miss, including an entry that is damaged or from another run with the same key
+  @return -1 if the entry could not be written to out or err
+ */
+int resultcache_replay(resultcache_t *cache, FILE *out, FILE *err)
+{
+	resultcache_header_t header;
+	struct stat status;
+	int fd = open(cache->m_path, O_RDONLY);
+	if(fd < 0)
+	{
+		return 0;
+	}
+	char *args = malloc(cache->m_args_length + 1);
+	int hit = args != NULL && fstat(fd, &status) == 0 &&
+	          pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+	          memcmp(header.magic, RESULTCACHE_MAGIC, sizeof(header.magic)) == 0 && header.version == RESULTCACHE_VERSION &&
+	          header.build == cache->m_build && header.key == cache->m_key && header.args_length == cache->m_args_length &&
+	          header.output_length >= 0 && header.error_length >= 0 &&
+	          status.st_size == (off_t)(sizeof(header) + header.args_length + header.output_length + header.error_length) &&
+	          pread(fd, args, header.args_length, sizeof(header)) == header.args_length &&
+	          memcmp(args, cache->m_args, header.args_length) == 0;
+	free(args);
+	off_t start = sizeof(header) + header.args_length;
+	if(hit && (copy_out(fd, start, header.output_length, out) != 0 ||
+	           copy_out(fd, start + header.output_length, header.error_length, err) != 0))
+	{
+		hit = -1;
+	}
+	close(fd);
+	return hit;
+}
+
+
+/**
+  Starts sending everything written to out and err into a new entry
+  instead. Both are flushed first; the caller must not close them before
+  resultcache_finish().
+
+  @param cache a pointer to an instance of the resultcache_t data structure
+  @param out the stream to capture, such as stdout
+  @param err the error stream to capture, such as stderr
+  @return 0 on success
+  @return -1 if the entry could not be created, in which case out and err are left as they were
+ */
+int resultcache_capture(resultcache_t *cache, FILE *out, FILE *err)
+{
+	resultcache_header_t header;
+	size_t length = strlen(cache->m_path) + 8;
+	fflush(out);
+	fflush(err);
+	cache->m_temp = malloc(length);
+	char *err_temp = malloc(length);
+	if(cache->m_temp == NULL || err_temp == NULL)
+	{
+		free(cache->m_temp);
+		free(err_temp);
+		cache->m_temp = NULL;
+		return -1;
+	}
+	snprintf(cache->m_temp, length, "%s.XXXXXX", cache->m_path);
+	cache->m_temp_fd = mkstemp(cache->m_temp);
+	//the error output only needs its name until it is open
+	snprintf(err_temp, length, "%s.XXXXXX", cache->m_path);
+	cache->m_err_temp_fd = mkstemp(err_temp);
+	if(cache->m_err_temp_fd >= 0)
+	{
+		unlink(err_temp);
+	}
+	free(err_temp);
+
+	//the header is filled in once the output's length is known
+	memset(&header, 0, sizeof(header));
+	cache->m_fd = fileno(out);
+	cache->m_err_fd = fileno(err);
+	if(cache->m_temp_fd < 0 || cache->m_err_temp_fd < 0 ||
+	   write_all(cache->m_temp_fd, (const char *)&header, sizeof(header)) != 0 ||
+	   write_all(cache->m_temp_fd, cache->m_args, cache->m_args_length) != 0 ||
+	   redirect(cache->m_fd, cache->m_temp_fd, &cache->m_saved_fd) != 0 ||
+	   redirect(cache->m_err_fd, cache->m_err_temp_fd, &cache->m_saved_err_fd) != 0)
+	{
+		restore(cache->m_fd, &cache->m_saved_fd);
+		if(cache->m_temp_fd >= 0)
+		{
+			close(cache->m_temp_fd);
+			unlink(cache->m_temp);
+			cache->m_temp_fd = -1;
+		}
+		if(cache->m_err_temp_fd >= 0)
+		{
+			close(cache->m_err_temp_fd);
+			cache->m_err_temp_fd = -1;
+		}
+		free(cache->m_temp);
+		cache->m_temp = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+
+/**
+  Ends a capture started by resultcache_capture(): out and err go back to
+  where they pointed, get everything written to them meanwhile, and the
+  entry is stored if keep is set, replacing any older one.
+
+  @param cache a pointer to an instance of the resultcache_t data structure
+  @param out the stream given to resultcache_capture()
+  @param err the error stream given to resultcache_capture()
+  @param keep 1 to store the entry, 0 to drop it (as for a failed run)
+  @return 0 on success
+  @return -1 if the output could not be copied to out and err or the entry could not be stored
+ */
+int resultcache_finish(resultcache_t *cache, FILE *out, FILE *err, int keep)
+{
+	if(cache->m_temp == NULL)
+	{
+		return -1;
+	}
+	fflush(out);
+	fflush(err);
+	restore(cache->m_fd, &cache->m_saved_fd);
+	restore(cache->m_err_fd, &cache->m_saved_err_fd);
+
+	//the entry is stored before the output is copied, so a reader that
+	//stops early, as head does, still leaves a whole entry and no stray file
+	resultcache_header_t header;
+	off_t start = sizeof(header) + cache->m_args_length;
+	off_t end = lseek(cache->m_temp_fd, 0, SEEK_END);
+	off_t error_length = lseek(cache->m_err_temp_fd, 0, SEEK_END);
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RESULTCACHE_MAGIC, sizeof(header.magic));
+	header.version = RESULTCACHE_VERSION;
+	header.args_length = cache->m_args_length;
+	header.build = cache->m_build;
+	header.key = cache->m_key;
+	header.output_length = end - start;
+	header.error_length = error_length;
+	int stored = keep && end >= start && error_length >= 0 &&
+	             append(cache->m_err_temp_fd, error_length, cache->m_temp_fd) == 0 &&
+	             pwrite(cache->m_temp_fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+	             rename(cache->m_temp, cache->m_path) == 0;
+	if(!stored)
+	{
+		unlink(cache->m_temp);
+	}
+
+	int ok = end >= start && error_length >= 0 && copy_out(cache->m_temp_fd, start, end - start, out) == 0 &&
+	         copy_out(cache->m_err_temp_fd, 0, error_length, err) == 0 && stored == keep;
+	close(cache->m_temp_fd);
+	close(cache->m_err_temp_fd);
+	cache->m_temp_fd = -1;
+	cache->m_err_temp_fd = -1;
+	free(cache->m_temp);
+	cache->m_temp = NULL;
+	return ok ? 0 : -1;
+}
+
+
+/**
+  Frees the memory associated with cache.
+
+  @param cache a pointer to an instance of the resultcache_t data structure
+ */
+void resultcache_close(resultcache_t *cache)
+{
+	free(cache->m_path);
+	free(cache->m_temp);
+	cache->m_path = NULL;
+	cache->m_temp = NULL;
+}
@@ -0,0 +1,68 @@
+/** @file libresultcache.h
+ */
+
+#ifndef LIBRESULTCACHE_H_
+#define LIBRESULTCACHE_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define RESULTCACHE_MAGIC "SIMCACHE"
+#define RESULTCACHE_VERSION 2
+
+/**
+  Start value of a hash built with resultcache_hash() (the FNV-1a offset basis)
+*/
+#define RESULTCACHE_SEED 0xcbf29ce484222325ULL
+
+/**
+  Start of every cache entry. It is followed by the run's arguments
+  (args_length bytes), the output being cached (output_length bytes) and
+  the error output (error_length bytes), all in native byte order.
+*/
+typedef struct _resultcache_header_t
+{
+  char magic[8];
+  int version;
+  int args_length;
+  unsigned long long build;     //hash of the program that wrote the entry
+  unsigned long long key;
+  long long output_length;
+  long long error_length;
+} resultcache_header_t;
+
+/**
+  One lookup, and the capture of the output to store if it missed.
+
+  An entry is the file <dir>/<build>-<key>.result, so a different build of
+  the program never reads another build's entries; resultcache_open()
+  deletes them instead. An entry is written to a temporary file in the same
+  directory and renamed into place, so a reader never sees half of one.
+*/
+typedef struct _resultcache_t
+{
+  char* m_path;                 //the entry
+  char* m_temp;                 //the entry being written, NULL when not capturing
+  const char* m_args;
+  int m_args_length;
+  unsigned long long m_build, m_key;
+  int m_fd;                     //stream being captured
+  int m_saved_fd;               //where it pointed before the capture
+  int m_temp_fd;
+  int m_err_fd;                 //error stream being captured
+  int m_saved_err_fd;
+  int m_err_temp_fd;            //unlinked file holding the error output until it joins the entry
+} resultcache_t;
+
+
+unsigned long long resultcache_hash     (unsigned long long hash, const void *data, size_t length);
+int                resultcache_hash_file(unsigned long long *hash, const char *path);
+
+int                resultcache_open     (resultcache_t *cache, const char *dir, unsigned long long build, unsigned long long key,
+                                         const char *args, int args_length);
+int                resultcache_replay   (resultcache_t *cache, FILE *out, FILE *err);
+int                resultcache_capture  (resultcache_t *cache, FILE *out, FILE *err);
+int                resultcache_finish   (resultcache_t *cache, FILE *out, FILE *err, int keep);
+void               resultcache_close    (resultcache_t *cache);
+
+#endif /* LIBRESULTCACHE_H_ */
@@ -4,23 +4,332 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <math.h>
 
 #include "libscheduler.h"
 #include "../libpriqueue/libpriqueue.h"
+#include "../libheap/libheap.h"
+#include "../libhistogram/libhistogram.h"
+#include "../libcorescan/libcorescan.h"
 
 
 /**
-  Stores information making up a job to be scheduled including any statistics.
+  Stores information making up a job to be scheduled.
 
-  You may need to define some global variables or a struct to store your job queue elements.
+  Every key a comparer reads, and everything dispatching or preempting the
+  job touches, is in these 64 bytes; jobs come from cache-line aligned
+  chunks (see JOB POOL), so walking a queue costs one cache line per job.
+  What only the scheme in use needs shares one union, and what is read
+  rarely lives in job_stats_t instead.
 */
 typedef struct _job_t
 {
-  int job_id, last_checked_time,waiting_time, original_start_time, last_queue_time, response_time, arrival_time, original_run_time, run_time, priority, last_start_time, core_id;
+  int job_id, core_id, run_time, priority;
+  //ready-set path: remaining work in CORE_SPEED_UNITs per time unit
+  long long work;
+  union
+  {
+    //STRIDE: the job's pass value, see STRIDE_comp
+    long long pass;
+    //aging: aged_priority * aging_interval + last_queue_time, see AGING_comp
+    struct
+    {
+      long long aging_key;
+      int aged_priority;
+    };
+    //LOTTERY: the job's leaf in lottery_tree, -1 while it is not in it
+    int lottery_slot;
+    //gang scheduling: cores the job holds at once and its node in the
+    //backfill index (see BACKFILL INDEX)
+    struct
+    {
+      struct _job_t *backfill_left, *backfill_right;
+      int backfill_min_cores;   //smallest cores_required in this subtree
+      int cores_required;
+    };
+    //a job in the pool's free list
+    struct _job_t* next_free;
+  };
+  int queue_seq;
+  //I/O: when the job's current I/O completes
+  int wake_time;
+  int last_checked_time;
+  //the job's entry in job_stats
+  int slot;
 } job_t;
 
-int last_time_checked_PSJF;
-priqueue_t queue;
+//the rest of a job, kept apart so queues never load it
+typedef struct _job_stats_t
+{
+  int arrival_time, original_run_time;
+  int last_queue_time, last_start_time, original_start_time;
+  //core the job last ran on, -1 before its first dispatch (affinity hint)
+  int last_core;
+  //times the job was taken off a core before finishing
+  int preemptions;
+  //time units actually spent making progress, and spent on I/O
+  int service_time, io_time;
+  //length of the CPU burst the job is on, see ADAPTIVE QUANTUM
+  int burst_time;
+  //gang scheduling: whether the job's queue entry is stale, and whether the
+  //job is done while that entry still holds it
+  char backfilled, finished;
+} job_stats_t;
+
+//expected end of a running gang job, used to place the queue head's reservation
+typedef struct _gang_end_t
+{
+  int end, cores;
+} gang_end_t;
+
+//one tenant under fair share, see FAIR SHARE
+typedef struct _group_t
+{
+  heap_t ready;                 //the group's waiting jobs, by the scheme's own key
+  //log2 of the group's decayed usage over its weight, kept in units of the
+  //time the run started so it never has to be decayed as the clock moves
+  double usage_key;
+  long long waiting_time;       //summed over its finished jobs
+  int finished_count;
+  int weight;
+  int heap_slot;                //where the group is in fair_heap, -1 if absent
+} group_t;
+
+#define STRIDE1 (1 << 20)
+
+#define CACHE_LINE 64
+#define JOB_CHUNK 1024              //jobs allocated at a time
+
+/**
+  Everything one scheduler instance knows. The scheduler_* calls of a thread
+  act on the instance it picked with scheduler_use(), or on a default
+  instance until it picks one, so independent schedulers can run side by
+  side in one process.
+*/
+struct _scheduler_t
+{
+  long long m_waiting_time, m_turnaround_time, m_response_time;
+  int num_jobs;
+  int* avail_cores;//will be an array with the status (0/1) of each core
+  int num_cores;
+  scheme_t scheduling_scheme;
+  int last_time_checked_PSJF;
+  priqueue_t queue;
+
+  /*                                          **
+  **-------------READY SET STATE--------------**
+  **                                          */
+  //PSJF, STRIDE, LOTTERY and aged PRI/PPRI do not keep running jobs in a
+  //queue; running[i] is the job on core i (or NULL) and only ready jobs live
+  //in the selection structure
+  job_t** running;
+  //what the victim search needs of running[i], kept per core so the search
+  //reads flat arrays; set on dispatch and stale while the core is idle
+  long long* run_finish;        //when the job will be done, scaled by CORE_SPEED_UNIT
+  long long* run_banked;        //its remaining time at dispatch, scaled the same way
+  int* run_priority;            //its aged_priority
+  //PSJF: busy cores in a max-heap on run_finish, ties to the lower core, so
+  //without dispatch overhead the job with the most time left is at the root
+  int* finish_heap;             //core ids
+  int* finish_heap_slot;        //where each core is in finish_heap, -1 if absent
+  int finish_heap_size;
+  heap_t ready;                 //STRIDE: min-heap on pass value, aging: on aging_key
+  int aging_interval;           //0 disables aging
+  long long global_pass;
+  int next_queue_seq;
+  long long* lottery_tree;      //LOTTERY: Fenwick tree over ready tickets, 1-based
+  job_t** lottery_jobs;         //job held in each tree slot (1-based)
+  int* lottery_free_slots;      //stack of vacated slots to reuse
+  int lottery_capacity, lottery_used, lottery_free_count;
+  long long lottery_total;
+  unsigned long long lottery_rng;
+
+  /*                                          **
+  **-----------PER-CORE RUN QUEUES------------**
+  **                                          */
+  //in multi-queue mode every core pulls from its own local_queues[i] and an
+  //idle core steals from another core's queue instead of a shared ready set
+  int multiqueue;
+  placement_t placement_policy;
+  steal_t steal_policy;
+  int migration_cost;           //overhead charged to a job stolen from another core
+  heap_t* local_queues;
+  int next_placement;
+  int* pending_penalty;         //overhead accrued for the next dispatch on each core
+  int* dispatch_penalty;        //overhead charged to the latest dispatch on each core
+  long long overhead_time;
+  int switch_cost;              //overhead charged when a core changes jobs
+  int migration_penalty;        //overhead charged when a job resumes on another core
+  int migration_count;
+  int* core_speed;              //work each core does per time unit, CORE_SPEED_UNIT = 1.0
+  int heterogeneous;            //1 once any core runs at other than CORE_SPEED_UNIT
+  int steal_count, max_imbalance, imbalance_samples;
+  long long imbalance_total;
+
+  /*                                          **
+  **-------------GANG SCHEDULING--------------**
+  **                                          */
+  //jobs may hold several cores at once; the queue head starts once enough
+  //cores are free and, with EASY backfilling, later jobs may use the idle
+  //cores as long as they do not delay the head's reservation
+  int gang;
+  int gang_backfill;            //1 for EASY backfilling, 0 for strict queue order
+  int free_cores;
+  int gang_waiting;             //queued jobs that have not started
+  int backfill_count;
+  job_t* backfill_root;         //waiting jobs ordered by (run time, queue_seq)
+  gang_end_t* gang_ends;        //scratch space, one entry per core
+
+  /*                                          **
+  **---------------BLOCKED JOBS---------------**
+  **                                          */
+  //jobs waiting on I/O hold no core and sit in a min-heap on the time their
+  //I/O completes, then go back through admission like an arrival
+  int io_bursts;
+  heap_t wake_heap;
+  int blocked_count, block_count;
+
+  /*                                          **
+  **---------------DEPENDENCIES---------------**
+  **                                          */
+  //a job may not start before the jobs it depends on finish; the successors
+  //of job j are dag_successors[dag_first[j] .. dag_first[j + 1]) (CSR), so
+  //a finish releases them in O(out-degree). An arrival with predecessors
+  //left waits in dag_held, off every queue, until the last of them finishes
+  int dag_jobs;                 //job numbers the graph covers, 0 without one
+  int* dag_first;               //dag_jobs + 1 offsets into dag_successors
+  int* dag_successors;
+  int* dag_pending;             //unfinished predecessors of each job
+  job_t** dag_held;             //arrived jobs still waiting, by job number
+  int* dag_released;            //job numbers due for admission, in release order
+  int dag_released_head, dag_released_tail;
+  int held_count;
+
+  /*                                          **
+  **----------------FAIR SHARE----------------**
+  **                                          */
+  //every group queues its jobs apart and the next job comes from the group
+  //with the least decayed usage per unit of weight; fair_heap holds the
+  //groups with waiting jobs as a min-heap on usage_key, ties to the lower id
+  int fair_share;
+  int fair_jobs;                //job numbers fair_group covers
+  int* fair_group;              //group of each job number
+  group_t* groups;
+  int group_count;
+  int* fair_heap;               //group ids
+  int fair_heap_size;
+  double fair_half_life;        //time units for usage to halve, 0 for no decay
+
+  /*                                          **
+  **-------------ADAPTIVE QUANTUM-------------**
+  **                                          */
+  //every dispatch under a quantum gets its slice from scheduler_quantum();
+  //with a granularity the slice is the target latency split between the
+  //jobs taking turns on the core, never below the granularity
+  int quantum;                  //the fixed slice, or the target latency
+  int quantum_granularity;      //smallest adaptive slice, 0 for a fixed quantum
+  double burst_average;         //moving average of finished CPU bursts, 0 before one
+  int last_quantum;             //slice handed out last, 0 before one
+  long long quantum_total;
+  int quantum_count;
+
+  /*                                          **
+  **-------------JOB STATISTICS---------------**
+  **                                          */
+  //fixed-size histograms for percentiles, so memory does not grow with the
+  //number of jobs; completion records are streamed to job_log, if set
+  histogram_t waiting_histogram, turnaround_histogram, response_histogram;
+  FILE* job_log;
+  int job_log_binary;
+  int* last_job_on_core;        //id of the job each core ran last, -1 if none yet
+  int preemption_count, context_switch_count, finished_count;
+
+  /*                                          **
+  **-----------------JOB POOL-----------------**
+  **                                          */
+  //jobs are carved from chunks that are only freed by scheduler_clean_up();
+  //a finished job goes to free_jobs and is the next one handed out
+  job_t** job_chunks;
+  int job_chunk_count;
+  job_t* free_jobs;
+  job_stats_t* job_stats;       //indexed by job_t.slot, grows with the chunks
+};
+
+static scheduler_t default_scheduler;
+static __thread scheduler_t* state = &default_scheduler;
+
+/*                                          **
+**-----------------JOB POOL-----------------**
+**                                          */
+//returns NULL if memory could not be allocated, leaving the pool as it was
+static job_t* job_alloc(scheduler_t* scheduler)
+{
+  if(scheduler->free_jobs == NULL)
+  {
+    int base = scheduler->job_chunk_count * JOB_CHUNK;
+    job_t* chunk = aligned_alloc(CACHE_LINE, sizeof(job_t) * JOB_CHUNK);
+    job_t** chunks = chunk == NULL ? NULL : realloc(scheduler->job_chunks, sizeof(job_t*) * (scheduler->job_chunk_count + 1));
+    if(chunks != NULL)
+    {
+      scheduler->job_chunks = chunks;
+    }
+    job_stats_t* stats = chunks == NULL ? NULL : realloc(scheduler->job_stats, sizeof(job_stats_t) * (base + JOB_CHUNK));
+    if(stats == NULL)
+    {
+      free(chunk);
+      return NULL;
+    }
+    scheduler->job_stats = stats;
+    scheduler->job_chunks[scheduler->job_chunk_count++] = chunk;
+    //pushed back to front so the chunk is handed out in address order
+    for(int i = JOB_CHUNK - 1; i >= 0; i--)
+    {
+      chunk[i].slot = base + i;
+      chunk[i].next_free = scheduler->free_jobs;
+      scheduler->free_jobs = &chunk[i];
+    }
+  }
+  job_t* job = scheduler->free_jobs;
+  scheduler->free_jobs = job->next_free;
+  return job;
+}
+
+static void job_release(job_t* job)
+{
+  job->next_free = state->free_jobs;
+  state->free_jobs = job;
+}
+
+static void job_pool_destroy(scheduler_t* scheduler)
+{
+  for(int i = 0; i < scheduler->job_chunk_count; i++)
+  {
+    free(scheduler->job_chunks[i]);
+  }
+  free(scheduler->job_chunks);
+  free(scheduler->job_stats);
+  scheduler->job_chunks = NULL;
+  scheduler->job_chunk_count = 0;
+  scheduler->free_jobs = NULL;
+  scheduler->job_stats = NULL;
+}
+
+static job_stats_t* job_stats(job_t* job)
+{
+  return &state->job_stats[job->slot];
+}
+
+//the CSV priority doubles as the ticket count for proportional share
+static int job_tickets(job_t* job)
+{
+  return job->priority > 0 ? job->priority : 1;
+}
+
+static long long job_stride(job_t* job)
+{
+  return STRIDE1 / job_tickets(job);
+}
 
 /*                                          **
 **------------COMPARISON FUNCTIONS----------**
@@ -57,393 +366,3191 @@ int PRI_comp(const void* left, const void* right)
     return l - r;
   }
 }
-//end comparers
-/**
-  Initalizes the scheduler.
-
-  Assumptions:
-    - You may assume this will be the first scheduler function called.
-    - You may assume this function will be called once once.
-    - You may assume that cores is a positive, non-zero number.
-    - You may assume that scheme is a valid scheduling scheme.
-
-  @param cores the number of cores that is available by the scheduler. These cores will be known as core(id=0), core(id=1), ..., core(id=cores-1).
-  @param scheme  the scheduling scheme that should be used. This value will be one of the six enum values of scheme_t
+int STRIDE_comp(const void* left, const void* right)
+{
+  job_t* left_job = (job_t*)left;
+  job_t* right_job = (job_t*)right;
+  if(left_job->pass != right_job->pass)
+  {
+    return left_job->pass < right_job->pass ? -1 : 1;
+  }
+  //break ties by the order the jobs were queued
+  return left_job->queue_seq - right_job->queue_seq;
+}
+/*
+  A job waiting since last_queue_time gains one priority level every
+  aging_interval time units, so at time now its effective priority is
+  aged_priority - (now - last_queue_time) / aging_interval. Scaled by
+  aging_interval that is aging_key - now: every waiting job ages at the same
+  rate, so ordering by the fixed aging_key orders by effective priority at
+  any time and the heap never has to be re-keyed as the clock advances.
 */
-void scheduler_start_up(int cores, scheme_t scheme)
+int AGING_comp(const void* left, const void* right)
 {
-  /*                               **
-  *---INITIALIZE GLOBAL VARIABLES---*
-  **                               */
-  m_waiting_time = 0.0;
-  m_turnaround_time = 0.0;
-  m_response_time = 0.0;
-  num_jobs = 0;
-
-  num_cores = cores;
-  //this array will be filled with 0 for a free core, 1 for a busy core
-  avail_cores = malloc((sizeof(int)) * cores);
-  for(int i = 0; i < num_cores; i++)
+  job_t* left_job = (job_t*)left;
+  job_t* right_job = (job_t*)right;
+  if(left_job->aging_key != right_job->aging_key)
   {
-    avail_cores[i] = 0;
+    return left_job->aging_key < right_job->aging_key ? -1 : 1;
   }
-  //set comparison scheme
-  scheduling_scheme = scheme;
-
-  switch(scheduling_scheme)
+  return left_job->queue_seq - right_job->queue_seq;
+}
+//orders blocked jobs by when their I/O completes
+int WAKE_comp(const void* left, const void* right)
+{
+  job_t* left_job = (job_t*)left;
+  job_t* right_job = (job_t*)right;
+  if(left_job->wake_time != right_job->wake_time)
+  {
+    return left_job->wake_time - right_job->wake_time;
+  }
+  return left_job->job_id - right_job->job_id;
+}
+//orders a core's local run queue by the key of the current scheme
+int LOCAL_comp(const void* left, const void* right)
+{
+  job_t* left_job = (job_t*)left;
+  job_t* right_job = (job_t*)right;
+  long long l = 0, r = 0;
+  switch(state->scheduling_scheme)
   {
-    case FCFS:
-    {
-      priqueue_init(&queue,&FCFS_comp);
-
-      break;
-    }
     case SJF:
-    {
-      priqueue_init(&queue,SJF_comp);
-      break;
-    }
     case PSJF:
     {
-      priqueue_init(&queue,SJF_comp);
+      l = left_job->work;
+      r = right_job->work;
       break;
     }
     case PRI:
-    {
-      priqueue_init(&queue,PRI_comp);
-      break;
-    }
     case PPRI:
     {
-      priqueue_init(&queue,PRI_comp);
-      break;
-    }
-    case RR:
-    {
-      priqueue_init(&queue,FCFS_comp);
+      l = state->aging_interval > 0 ? left_job->aging_key : left_job->priority;
+      r = state->aging_interval > 0 ? right_job->aging_key : right_job->priority;
       break;
     }
     default:
     {
-      printf("something happened\n");
       break;
     }
   }
+  if(l != r)
+  {
+    return l < r ? -1 : 1;
+  }
+  return left_job->queue_seq - right_job->queue_seq;
 }
+//end comparers
 
-
-/**
-  Called when a new job arrives.
-
-  If multiple cores are idle, the job should be assigned to the core with the
-  lowest id.
-  If the job arriving should be scheduled to run during the next
-  time cycle, return the zero-based index of the core the job should be
-  scheduled on. If another job is already running on the core specified,
-  this will preempt the currently running job.
-  Assumptions:
-    - You may assume that every job wil have a unique arrival time.
-
-  @param job_number a globally unique identification number of the job arriving.
-  @param time the current time of the simulator.
-  @param running_time the total number of time units this job will run before it will be finished.
-  @param priority the priority of the job. (The lower the value, the higher the priority.)
-  @return index of core job should be scheduled on
-  @return -1 if no scheduling changes should be made.
-
- */
-int scheduler_new_job(int job_number, int time, int running_time, int priority)
+/*                                          **
+**-----------LOTTERY FENWICK TREE-----------**
+**                                          */
+static void lottery_tree_add(int slot, long long delta)
 {
+  state->lottery_total += delta;
+  for(; slot <= state->lottery_capacity; slot += slot & -slot)
+  {
+    state->lottery_tree[slot] += delta;
+  }
+}
 
-  job_t* to_add = malloc(sizeof(job_t));
-  to_add->job_id = job_number;
-  to_add->original_run_time = running_time;
-  to_add->run_time = running_time;
-  to_add->arrival_time = time;
-  to_add->priority = priority;
-  to_add->original_start_time = -1;
-  to_add->last_start_time = -1;
-  to_add->last_queue_time = -1;
-  to_add->core_id = -1;
-  to_add->last_checked_time = -1;
-  to_add->response_time = 0;
-  //find the first available core
-  int to_return = -1;
-  int i = 0;
-  for(;i < num_cores; i++)
+//doubles the number of slots, rebuilding the tree in O(n)
+static void lottery_grow()
+{
+  int capacity = state->lottery_capacity == 0 ? 64 : state->lottery_capacity * 2;
+  state->lottery_tree = realloc(state->lottery_tree, (capacity + 1) * sizeof(long long));
+  state->lottery_jobs = realloc(state->lottery_jobs, (capacity + 1) * sizeof(job_t*));
+  state->lottery_free_slots = realloc(state->lottery_free_slots, capacity * sizeof(int));
+  for(int i = state->lottery_capacity + 1; i <= capacity; i++)
   {
-    if(avail_cores[i] == 0)
+    state->lottery_jobs[i] = NULL;
+  }
+  state->lottery_capacity = capacity;
+  for(int i = 1; i <= capacity; i++)
+  {
+    state->lottery_tree[i] = state->lottery_jobs[i] != NULL ? job_tickets(state->lottery_jobs[i]) : 0;
+  }
+  for(int i = 1; i <= capacity; i++)
+  {
+    int parent = i + (i & -i);
+    if(parent <= capacity)
     {
-      to_return = i;
-      break;
+      state->lottery_tree[parent] += state->lottery_tree[i];
     }
   }
-  //mark the chosen core as in use
-  if(i < num_cores)
+}
+
+static void lottery_insert(job_t* job)
+{
+  int slot;
+  if(state->lottery_free_count > 0)
+  {
+    slot = state->lottery_free_slots[--state->lottery_free_count];
+  }
+  else
   {
-    avail_cores[i] = 1;
-    if(scheduling_scheme == PSJF)
+    if(state->lottery_used == state->lottery_capacity)
     {
-      to_add->last_checked_time = time;
+      lottery_grow();
     }
-  }else
-  //i == num_cores => there is no free core, we need to check for preemption
+    slot = ++state->lottery_used;
+  }
+  state->lottery_jobs[slot] = job;
+  job->lottery_slot = slot;
+  lottery_tree_add(slot, job_tickets(job));
+}
+
+static void lottery_erase(job_t* job)
+{
+  int slot = job->lottery_slot;
+  lottery_tree_add(slot, -job_tickets(job));
+  state->lottery_jobs[slot] = NULL;
+  state->lottery_free_slots[state->lottery_free_count++] = slot;
+  job->lottery_slot = -1;
+}
+
+//xorshift64*, seeded in scheduler_start_up so runs are reproducible
+static unsigned long long lottery_random()
+{
+  state->lottery_rng ^= state->lottery_rng >> 12;
+  state->lottery_rng ^= state->lottery_rng << 25;
+  state->lottery_rng ^= state->lottery_rng >> 27;
+  return state->lottery_rng * 2685821657736338717ULL;
+}
+
+//draws a winning ticket and descends the tree to its holder in O(log n)
+static job_t* lottery_draw()
+{
+  if(state->lottery_total == 0)
+  {
+    return NULL;
+  }
+  long long winner = (long long)(lottery_random() % (unsigned long long)state->lottery_total);
+  int pos = 0;
+  int step = 1;
+  while(step * 2 <= state->lottery_capacity)
+  {
+    step *= 2;
+  }
+  for(; step > 0; step /= 2)
   {
-    switch(scheduling_scheme)
+    if(pos + step <= state->lottery_capacity && state->lottery_tree[pos + step] <= winner)
     {
-      case PSJF:
-      {
-        //we need to know how long since we added the last job
-        //int time_diff = time - last_time_checked_PSJF;
-        //need to find the longest remaining time of jobs on cores
-        int longest_run_time = -1;
-        //this is the core to be run on
-        //also the index of the job in the queue
-        int core_of_longest_run_time = -1;
-        job_t* curr_check;
-        int index;
-        int j;
-        for(j = 0; j < num_cores; j++)
-        {
-          curr_check = (job_t*)priqueue_at(&queue,j);
-          curr_check->run_time = curr_check->run_time - (time - curr_check->last_checked_time);
-          curr_check->last_checked_time = time;
-          if(curr_check->run_time > longest_run_time)
-          {
-            longest_run_time = curr_check->run_time;
-            core_of_longest_run_time = curr_check->core_id;
-            index = j;
-          }
-        }
-        if(running_time < longest_run_time)
-        {
-          to_return = core_of_longest_run_time;
-          curr_check = (job_t*)priqueue_at(&queue,index);
-          curr_check->core_id = -1;
-          if(curr_check->original_start_time == time)
-          {
-            //curr_check->run_time += time_diff;
-            curr_check->original_start_time = -1;
-            curr_check->last_start_time = -1;
-          }
-          else if(curr_check->last_start_time == time)
-          {
-          }
-          else
-          {
-            curr_check->last_queue_time = time;
-          }
-        }
-        to_add->last_checked_time = time;
-        break;
-      }
-      case PPRI:
-      {
-        int j;
-        job_t* curr_check = (job_t*)priqueue_peek(&queue);
-        int lowest_priority = curr_check->priority;
-        int core_of_lowest_priority = curr_check->core_id;
-        for(j = 0; j < num_cores; j++)
-        {
-          curr_check = (job_t*) priqueue_at(&queue,j);
-          if (curr_check->priority > lowest_priority)
-          {
-            lowest_priority = curr_check->priority;
-            core_of_lowest_priority = curr_check->core_id;
-          }
-        }
-        if(priority < lowest_priority)
-        {
-          core_of_lowest_priority = curr_check->core_id;
-          to_return = core_of_lowest_priority;
-          curr_check->core_id = -1;
-          if(curr_check->original_start_time == time)
-          {
-            curr_check->original_start_time = -1;
-            curr_check->last_start_time = -1;
-          }
-          else if(curr_check->last_start_time == time)
-          {
-
-          }
-          else
-          {
-            curr_check->last_queue_time = time;
-          }
-        }
-        break;
-      }
-      default:
-      {
-        break;
-      }
+      pos += step;
+      winner -= state->lottery_tree[pos];
     }
   }
-  //update the core id of the new job
-  to_add->core_id = to_return;
-  //if the job is assigned to a core, set its start time to be current time
-  if(to_return != -1)
+  return state->lottery_jobs[pos + 1];
+}
+
+/*                                          **
+**--------------BACKFILL INDEX--------------**
+**                                          */
+//a treap of the waiting gang jobs ordered by run time (queue order breaks
+//ties), where every node also knows the fewest cores any job below it
+//needs, so the shortest job that fits a hole is found in O(log n)
+static int backfill_less(job_t* left, job_t* right)
+{
+  if(left->run_time != right->run_time)
   {
-    to_add->original_start_time = time;
-    to_add->last_start_time = time;
+    return left->run_time < right->run_time;
   }
-  //add to queue
-  num_jobs++;
-  priqueue_offer(&queue,to_add);
-	return to_return;
+  return left->queue_seq < right->queue_seq;
 }
 
-
-/**
-  Called when a job has completed execution.
-
-  The core_id, job_number and time parameters are provided for convenience. You may be able to calculate the values with your own data structure.
-  If any job should be scheduled to run on the core free'd up by the
-  finished job, return the job_number of the job that should be scheduled to
-  run on core core_id.
-
-  @param core_id the zero-based index of the core where the job was located.
-  @param job_number a globally unique identification number of the job.
-  @param time the current time of the simulator.
-  @return job_number of the job that should be scheduled to run on core core_id
-  @return -1 if core should remain idle.
- */
-int scheduler_job_finished(int core_id, int job_number, int time)
+//the treap priority of a job: a hash of its number, so runs are reproducible
+static unsigned int backfill_priority(job_t* job)
 {
-  int i = 0, j = 0;
-  // int removal_index = -1;
-  int return_job_id = -1;
-  job_t* temp;
+  unsigned int h = (unsigned int)job->job_id * 2654435761u;
+  return h ^ (h >> 15);
+}
 
-  avail_cores[core_id] = 0;
-  for(;i < priqueue_size(&queue);i++)
+static void backfill_update(job_t* node)
+{
+  node->backfill_min_cores = node->cores_required;
+  if(node->backfill_left != NULL && node->backfill_left->backfill_min_cores < node->backfill_min_cores)
   {
-    temp = priqueue_at(&queue,i);
-    if(temp->core_id == core_id)
-    {
-      m_turnaround_time = m_turnaround_time + time - temp->arrival_time;
-      m_response_time += temp->original_start_time - temp->arrival_time;
-      m_waiting_time += time - temp->original_run_time - temp->arrival_time;
-      priqueue_remove_at(&queue,i);
-      for(;j<priqueue_size(&queue);j++)
-      {
-        temp = priqueue_at(&queue,j);
+    node->backfill_min_cores = node->backfill_left->backfill_min_cores;
+  }
+  if(node->backfill_right != NULL && node->backfill_right->backfill_min_cores < node->backfill_min_cores)
+  {
+    node->backfill_min_cores = node->backfill_right->backfill_min_cores;
+  }
+}
+
+static job_t* backfill_merge(job_t* left, job_t* right)
+{
+  if(left == NULL)
+  {
+    return right;
+  }
+  if(right == NULL)
+  {
+    return left;
+  }
+  if(backfill_priority(left) > backfill_priority(right))
+  {
+    left->backfill_right = backfill_merge(left->backfill_right, right);
+    backfill_update(left);
+    return left;
+  }
+  right->backfill_left = backfill_merge(left, right->backfill_left);
+  backfill_update(right);
+  return right;
+}
+
+//splits node into the jobs ordered before key and the rest
+static void backfill_split(job_t* node, job_t* key, job_t** before, job_t** after)
+{
+  if(node == NULL)
+  {
+    *before = NULL;
+    *after = NULL;
+  }
+  else if(backfill_less(node, key))
+  {
+    backfill_split(node->backfill_right, key, &node->backfill_right, after);
+    backfill_update(node);
+    *before = node;
+  }
+  else
+  {
+    backfill_split(node->backfill_left, key, before, &node->backfill_left);
+    backfill_update(node);
+    *after = node;
+  }
+}
+
+static void backfill_insert(job_t* job)
+{
+  job_t *before, *after;
+  job->backfill_left = NULL;
+  job->backfill_right = NULL;
+  backfill_update(job);
+  backfill_split(state->backfill_root, job, &before, &after);
+  state->backfill_root = backfill_merge(backfill_merge(before, job), after);
+}
+
+static job_t* backfill_erase_from(job_t* node, job_t* job)
+{
+  if(node == job)
+  {
+    return backfill_merge(node->backfill_left, node->backfill_right);
+  }
+  if(backfill_less(job, node))
+  {
+    node->backfill_left = backfill_erase_from(node->backfill_left, job);
+  }
+  else
+  {
+    node->backfill_right = backfill_erase_from(node->backfill_right, job);
+  }
+  backfill_update(node);
+  return node;
+}
+
+static void backfill_erase(job_t* job)
+{
+  state->backfill_root = backfill_erase_from(state->backfill_root, job);
+}
+
+//shortest waiting job that runs for at most max_run_time and needs at most
+//max_cores cores, or NULL
+static job_t* backfill_find(int max_run_time, int max_cores)
+{
+  job_t* node = state->backfill_root;
+  while(node != NULL && node->backfill_min_cores <= max_cores)
+  {
+    if(node->backfill_left != NULL && node->backfill_left->backfill_min_cores <= max_cores)
+    {
+      node = node->backfill_left;
+    }
+    else if(node->run_time > max_run_time)
+    {
+      return NULL;
+    }
+    else if(node->cores_required <= max_cores)
+    {
+      return node;
+    }
+    else
+    {
+      node = node->backfill_right;
+    }
+  }
+  return NULL;
+}
+
+/*                                          **
+**----------------READY SET-----------------**
+**                                          */
+static int is_aging()
+{
+  return state->aging_interval > 0 && (state->scheduling_scheme == PRI || state->scheduling_scheme == PPRI);
+}
+
+//the priority a running job defends its core with: under aging the one it
+//had aged to when dispatched
+static int current_priority(job_t* job)
+{
+  return is_aging() ? job->aged_priority : job->priority;
+}
+
+static int uses_ready_set()
+{
+  return state->scheduling_scheme == PSJF || state->scheduling_scheme == STRIDE || state->scheduling_scheme == LOTTERY || is_aging() || state->multiqueue ||
+         state->switch_cost > 0 || state->migration_penalty > 0 || state->heterogeneous || state->gang || state->io_bursts || state->fair_share;
+}
+
+//orders the shared ready set by the scheme's own key once an option moves
+//a list scheme onto the ready-set path
+static void order_ready_set()
+{
+  if(uses_ready_set() && state->scheduling_scheme != STRIDE && state->scheduling_scheme != LOTTERY)
+  {
+    heap_init(&state->ready, LOCAL_comp);
+  }
+}
+
+//picks an idle core for a job whose affinity hint is last_core: the fastest
+//idle core, preferring last_core and then the lowest id among equally fast
+//ones, or -1 if every core is busy
+static int pick_idle_core(int last_core)
+{
+  if(!state->heterogeneous)
+  {
+    //all cores equally fast: last_core if it is idle, else the lowest idle one
+    return last_core != -1 && state->avail_cores[last_core] == 0 ? last_core : corescan_first_zero(state->avail_cores, state->num_cores);
+  }
+  int best = -1;
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    if(state->avail_cores[i] == 0 &&
+       (best == -1 || state->core_speed[i] > state->core_speed[best] ||
+        (state->core_speed[i] == state->core_speed[best] && i == last_core)))
+    {
+      best = i;
+    }
+  }
+  return best;
+}
+
+//samples the spread between the longest and shortest local run queue
+static void record_imbalance()
+{
+  int longest = heap_size(&state->local_queues[0]);
+  int shortest = longest;
+  for(int i = 1; i < state->num_cores; i++)
+  {
+    int length = heap_size(&state->local_queues[i]);
+    if(length > longest)
+    {
+      longest = length;
+    }
+    if(length < shortest)
+    {
+      shortest = length;
+    }
+  }
+  if(longest - shortest > state->max_imbalance)
+  {
+    state->max_imbalance = longest - shortest;
+  }
+  state->imbalance_total += longest - shortest;
+  state->imbalance_samples++;
+}
+
+//picks the local queue an arriving job is placed on when no core is idle
+static int place_core()
+{
+  if(state->placement_policy == PLACE_ROUND_ROBIN)
+  {
+    int core = state->next_placement;
+    state->next_placement = (state->next_placement + 1) % state->num_cores;
+    return core;
+  }
+  int core = 0;
+  for(int i = 1; i < state->num_cores; i++)
+  {
+    if(heap_size(&state->local_queues[i]) < heap_size(&state->local_queues[core]))
+    {
+      core = i;
+    }
+  }
+  return core;
+}
+
+/*                                          **
+**----------------FAIR SHARE----------------**
+**                                          */
+/*
+  Usage decays by half every fair_half_life time units, so usage u charged at
+  time t is worth u * 2^((t - now) / half_life) at time now. Every group
+  decays at the same rate, so comparing u * 2^(t / half_life) orders groups
+  just as well at any time, and no key changes as the clock moves (the trick
+  AGING_comp plays with priorities). That factor outgrows any number in a
+  long run, so usage_key holds its log2 and charges are summed in log space.
+*/
+static group_t* group_of(job_t* job)
+{
+  int group = job->job_id >= 0 && job->job_id < state->fair_jobs ? state->fair_group[job->job_id] : 0;
+  return &state->groups[group];
+}
+
+//whether group a should run before group b
+static int group_before(int a, int b)
+{
+  if(state->groups[a].usage_key != state->groups[b].usage_key)
+  {
+    return state->groups[a].usage_key < state->groups[b].usage_key;
+  }
+  return a < b;
+}
+
+static void fair_heap_place(int slot, int group)
+{
+  state->fair_heap[slot] = group;
+  state->groups[group].heap_slot = slot;
+}
+
+//moves group up or down from slot until the heap is in order again
+static void fair_heap_fix(int slot, int group)
+{
+  while(slot > 0 && group_before(group, state->fair_heap[(slot - 1) / 2]))
+  {
+    fair_heap_place(slot, state->fair_heap[(slot - 1) / 2]);
+    slot = (slot - 1) / 2;
+  }
+  for(;;)
+  {
+    int child = 2 * slot + 1;
+    if(child >= state->fair_heap_size)
+    {
+      break;
+    }
+    if(child + 1 < state->fair_heap_size && group_before(state->fair_heap[child + 1], state->fair_heap[child]))
+    {
+      child++;
+    }
+    if(!group_before(state->fair_heap[child], group))
+    {
+      break;
+    }
+    fair_heap_place(slot, state->fair_heap[child]);
+    slot = child;
+  }
+  fair_heap_place(slot, group);
+}
+
+static void fair_heap_remove(int group)
+{
+  int slot = state->groups[group].heap_slot;
+  state->groups[group].heap_slot = -1;
+  int last = state->fair_heap[--state->fair_heap_size];
+  if(last != group)
+  {
+    fair_heap_fix(slot, last);
+  }
+}
+
+//charges the group of job for elapsed time units of service ending at time
+static void fair_charge(job_t* job, int elapsed, int time)
+{
+  group_t* group = group_of(job);
+  double decayed = state->fair_half_life > 0 ? time / state->fair_half_life : 0;
+  double charge = log2((double)elapsed / group->weight) + decayed;
+  if(group->usage_key == -HUGE_VAL)
+  {
+    group->usage_key = charge;
+  }
+  else
+  {
+    //log2(2^a + 2^b) without leaving log space
+    double high = group->usage_key > charge ? group->usage_key : charge;
+    double low = group->usage_key > charge ? charge : group->usage_key;
+    group->usage_key = high + log1p(exp2(low - high)) / M_LN2;
+  }
+  if(group->heap_slot != -1)
+  {
+    fair_heap_fix(group->heap_slot, group - state->groups);
+  }
+}
+
+static void fair_add(job_t* job)
+{
+  group_t* group = group_of(job);
+  heap_offer(&group->ready, job);
+  if(group->heap_slot == -1)
+  {
+    fair_heap_fix(state->fair_heap_size++, group - state->groups);
+  }
+}
+
+static job_t* fair_take()
+{
+  if(state->fair_heap_size == 0)
+  {
+    return NULL;
+  }
+  int group = state->fair_heap[0];
+  job_t* job = (job_t*)heap_poll(&state->groups[group].ready);
+  if(heap_size(&state->groups[group].ready) == 0)
+  {
+    fair_heap_remove(group);
+  }
+  return job;
+}
+
+//frees the groups, leaving fair share off
+static void fair_destroy()
+{
+  for(int g = 0; g < state->group_count; g++)
+  {
+    heap_destroy(&state->groups[g].ready);
+  }
+  free(state->groups);
+  free(state->fair_group);
+  free(state->fair_heap);
+  state->groups = NULL;
+  state->fair_group = NULL;
+  state->fair_heap = NULL;
+  state->group_count = 0;
+  state->fair_heap_size = 0;
+  state->fair_share = 0;
+}
+
+//queues a job that is not running. In multi-queue mode it goes on the
+//local queue of core_id, or of the placement choice when core_id is -1
+static void ready_add(job_t* job, int core_id, int time)
+{
+  job->core_id = -1;
+  job_stats(job)->last_queue_time = time;
+  job->queue_seq = state->next_queue_seq++;
+  if(is_aging())
+  {
+    job->aging_key = (long long)job->aged_priority * state->aging_interval + time;
+  }
+  if(state->multiqueue)
+  {
+    heap_offer(&state->local_queues[core_id != -1 ? core_id : place_core()], job);
+    record_imbalance();
+  }
+  else if(state->fair_share)
+  {
+    fair_add(job);
+  }
+  else if(state->scheduling_scheme == LOTTERY)
+  {
+    lottery_insert(job);
+  }
+  else
+  {
+    heap_offer(&state->ready, job);
+  }
+}
+
+//takes the next job for core_id, stealing from another core's queue in
+//multi-queue mode when the local one is empty
+static job_t* ready_take(int core_id)
+{
+  if(state->multiqueue)
+  {
+    job_t* job = (job_t*)heap_poll(&state->local_queues[core_id]);
+    if(job != NULL)
+    {
+      return job;
+    }
+    int victim = -1;
+    if(state->steal_policy == STEAL_RANDOM)
+    {
+      //probe from a random core onwards so work is never left stranded
+      int start = (int)(lottery_random() % (unsigned long long)state->num_cores);
+      for(int i = 0; i < state->num_cores && victim == -1; i++)
+      {
+        if(heap_size(&state->local_queues[(start + i) % state->num_cores]) > 0)
+        {
+          victim = (start + i) % state->num_cores;
+        }
+      }
+    }
+    else
+    {
+      for(int i = 0; i < state->num_cores; i++)
+      {
+        if(heap_size(&state->local_queues[i]) > 0 && (victim == -1 || heap_size(&state->local_queues[i]) > heap_size(&state->local_queues[victim])))
+        {
+          victim = i;
+        }
+      }
+    }
+    if(victim == -1)
+    {
+      return NULL;
+    }
+    job = (job_t*)heap_poll(&state->local_queues[victim]);
+    state->steal_count++;
+    state->pending_penalty[core_id] += state->migration_cost;
+    record_imbalance();
+    return job;
+  }
+  if(state->fair_share)
+  {
+    return fair_take();
+  }
+  if(state->scheduling_scheme == LOTTERY)
+  {
+    job_t* job = lottery_draw();
+    if(job != NULL)
+    {
+      lottery_erase(job);
+    }
+    return job;
+  }
+  job_t* job = (job_t*)heap_poll(&state->ready);
+  if(job != NULL && state->scheduling_scheme == STRIDE)
+  {
+    state->global_pass = job->pass;
+  }
+  return job;
+}
+
+//records that job was forced off its core before finishing
+static void count_preemption(job_t* job)
+{
+  job_stats(job)->preemptions++;
+  state->preemption_count++;
+}
+
+//records that core_id starts running job, counting a context switch when
+//the core last ran a different job and a migration when the job last ran on
+//a different core; returns the overhead those cost
+static int note_dispatch(job_t* job, int core_id)
+{
+  job_stats_t* stats = job_stats(job);
+  int cost = 0;
+  if(state->last_job_on_core[core_id] != -1 && state->last_job_on_core[core_id] != job->job_id)
+  {
+    state->context_switch_count++;
+    cost += state->switch_cost;
+  }
+  if(stats->last_core != -1 && stats->last_core != core_id)
+  {
+    state->migration_count++;
+    cost += state->migration_penalty;
+  }
+  state->last_job_on_core[core_id] = job->job_id;
+  stats->last_core = core_id;
+  return cost;
+}
+
+/*                                          **
+**-------------ADAPTIVE QUANTUM-------------**
+**                                          */
+//weight of the newest burst in burst_average
+#define BURST_WEIGHT 0.125
+
+//folds the CPU burst a job just completed, by finishing or blocking, into
+//the moving average
+static void note_burst(job_t* job)
+{
+  int burst = job_stats(job)->burst_time;
+  if(state->burst_average == 0)
+  {
+    state->burst_average = burst;
+  }
+  else
+  {
+    state->burst_average += BURST_WEIGHT * (burst - state->burst_average);
+  }
+}
+
+//the slice for a job dispatched on core_id now: the target latency divided
+//between the jobs taking turns on the core, but no less than the
+//granularity. When the recent bursts run a little past that slice it is
+//stretched to fit them, at most to twice its length and never past the
+//target latency, so a typical job finishes rather than being switched out
+//for the last few time units of its burst
+static int adaptive_quantum(int core_id)
+{
+  int sharing;
+  if(state->multiqueue)
+  {
+    sharing = heap_size(&state->local_queues[core_id]) + 1;
+  }
+  else
+  {
+    int runnable = state->num_jobs - state->finished_count - state->blocked_count - state->held_count;
+    sharing = (runnable + state->num_cores - 1) / state->num_cores;
+  }
+  int slice = state->quantum / (sharing > 1 ? sharing : 1);
+  if(slice < state->quantum_granularity)
+  {
+    slice = state->quantum_granularity;
+  }
+  int burst = (int)ceil(state->burst_average);
+  if(burst > slice && burst <= 2 * slice && burst <= state->quantum)
+  {
+    slice = burst;
+  }
+  return slice;
+}
+
+/*                                          **
+**---------------FINISH HEAP----------------**
+**                                          */
+//whether the job on core a finishes after the job on core b
+static int finishes_later(int a, int b)
+{
+  if(state->run_finish[a] != state->run_finish[b])
+  {
+    return state->run_finish[a] > state->run_finish[b];
+  }
+  return a < b;
+}
+
+static void finish_heap_place(int slot, int core_id)
+{
+  state->finish_heap[slot] = core_id;
+  state->finish_heap_slot[core_id] = slot;
+}
+
+//moves core_id up or down from slot until the heap is in order again
+static void finish_heap_fix(int slot, int core_id)
+{
+  while(slot > 0 && finishes_later(core_id, state->finish_heap[(slot - 1) / 2]))
+  {
+    finish_heap_place(slot, state->finish_heap[(slot - 1) / 2]);
+    slot = (slot - 1) / 2;
+  }
+  for(;;)
+  {
+    int child = 2 * slot + 1;
+    if(child >= state->finish_heap_size)
+    {
+      break;
+    }
+    if(child + 1 < state->finish_heap_size && finishes_later(state->finish_heap[child + 1], state->finish_heap[child]))
+    {
+      child++;
+    }
+    if(!finishes_later(state->finish_heap[child], core_id))
+    {
+      break;
+    }
+    finish_heap_place(slot, state->finish_heap[child]);
+    slot = child;
+  }
+  finish_heap_place(slot, core_id);
+}
+
+//adds core_id, or moves it after its run_finish changed
+static void finish_heap_update(int core_id)
+{
+  int slot = state->finish_heap_slot[core_id];
+  if(slot == -1)
+  {
+    slot = state->finish_heap_size++;
+  }
+  finish_heap_fix(slot, core_id);
+}
+
+//drops core_id, if it is there
+static void finish_heap_remove(int core_id)
+{
+  int slot = state->finish_heap_slot[core_id];
+  if(slot == -1)
+  {
+    return;
+  }
+  state->finish_heap_slot[core_id] = -1;
+  int last = state->finish_heap[--state->finish_heap_size];
+  if(last != core_id)
+  {
+    finish_heap_fix(slot, last);
+  }
+}
+
+//whether a running job may still be paying dispatch overhead, in which case
+//it finishing last does not make it the one with the most time left
+static int dispatch_overhead()
+{
+  return state->switch_cost > 0 || state->migration_penalty > 0 || state->migration_cost > 0;
+}
+
+//copies what the victim search needs of the job on core_id into the per-core
+//arrays. Its remaining time, scaled by CORE_SPEED_UNIT, is the banked time
+//until last_checked_time and then counts down, so at any time it is
+//min(run_finish - time * CORE_SPEED_UNIT, run_banked); see corescan_longest()
+static void note_running(int core_id)
+{
+  job_t* job = state->running[core_id];
+  state->run_banked[core_id] = job->work * CORE_SPEED_UNIT / state->core_speed[core_id];
+  state->run_finish[core_id] = state->run_banked[core_id] + (long long)job->last_checked_time * CORE_SPEED_UNIT;
+  state->run_priority[core_id] = current_priority(job);
+  if(state->scheduling_scheme == PSJF)
+  {
+    finish_heap_update(core_id);
+  }
+}
+
+//places job on core_id and returns its id
+static int dispatch(job_t* job, int core_id, int time)
+{
+  job_stats_t* stats = job_stats(job);
+  if(is_aging() && stats->last_queue_time != -1)
+  {
+    //lock in the levels gained while waiting (floor division)
+    long long scaled = job->aging_key - time;
+    long long levels = scaled >= 0 ? scaled / state->aging_interval : -((-scaled + state->aging_interval - 1) / state->aging_interval);
+    job->aged_priority = (int)levels;
+  }
+  state->running[core_id] = job;
+  state->avail_cores[core_id] = 1;
+  job->core_id = core_id;
+  state->pending_penalty[core_id] += note_dispatch(job, core_id);
+  if(stats->original_start_time == -1)
+  {
+    stats->original_start_time = time;
+  }
+  stats->last_start_time = time;
+  //no progress is made while the dispatch overhead is paid
+  state->dispatch_penalty[core_id] = state->pending_penalty[core_id];
+  state->pending_penalty[core_id] = 0;
+  job->last_checked_time = time + state->dispatch_penalty[core_id];
+  state->overhead_time += state->dispatch_penalty[core_id];
+  note_running(core_id);
+  return job->job_id;
+}
+
+//fills core_id from the ready set, or marks it idle
+static int dispatch_next(int core_id, int time)
+{
+  job_t* next = ready_take(core_id);
+  if(next == NULL)
+  {
+    state->running[core_id] = NULL;
+    state->avail_cores[core_id] = 0;
+    finish_heap_remove(core_id);
+    return -1;
+  }
+  return dispatch(next, core_id, time);
+}
+
+//remaining work of a running job, as of time
+static long long remaining_work(job_t* job, int time)
+{
+  int elapsed = time - job->last_checked_time;
+  return elapsed > 0 ? job->work - (long long)elapsed * state->core_speed[job->core_id] : job->work;
+}
+
+//banks the progress a running job made since it was last checked
+static void bank_progress(job_t* job, int time)
+{
+  int elapsed = time - job->last_checked_time;
+  if(elapsed > 0)
+  {
+    job->work -= (long long)elapsed * state->core_speed[job->core_id];
+    job_stats(job)->service_time += elapsed;
+    if(state->fair_share)
+    {
+      fair_charge(job, elapsed, time);
+    }
+  }
+  job->run_time = (int)((job->work + CORE_SPEED_UNIT - 1) / CORE_SPEED_UNIT);
+}
+
+//takes a running job off its core and returns it to the ready set
+static void preempt(int core_id, int time)
+{
+  job_t* job = state->running[core_id];
+  bank_progress(job, time);
+  job->last_checked_time = time;
+  count_preemption(job);
+  if(job_stats(job)->original_start_time == time)
+  {
+    job_stats(job)->original_start_time = -1;
+  }
+  state->running[core_id] = NULL;
+  ready_add(job, core_id, time);
+}
+
+//whether an arriving job should preempt the job running on core_id
+static int should_preempt(job_t* job, int core_id, int time)
+{
+  if(state->scheduling_scheme == PSJF)
+  {
+    return job->work < remaining_work(state->running[core_id], time);
+  }
+  if(state->scheduling_scheme == PPRI)
+  {
+    //running jobs keep the priority they had aged to when dispatched
+    return job->priority < current_priority(state->running[core_id]);
+  }
+  return 0;
+}
+
+//adds a finished job's times to the running totals and the job log
+static void account_finished(job_t* job, int time)
+{
+  job_stats_t* stats = job_stats(job);
+  int turnaround = time - stats->arrival_time;
+  int response = stats->original_start_time - stats->arrival_time;
+  //on cores of different speeds the work a job needs no longer says how long
+  //it ran, so use the time it actually spent making progress; time blocked
+  //on I/O is not waiting either
+  int waiting = (state->heterogeneous ? turnaround - stats->service_time : time - stats->original_run_time - stats->arrival_time) - stats->io_time;
+  state->m_turnaround_time += turnaround;
+  state->m_response_time += response;
+  state->m_waiting_time += waiting;
+  histogram_record(&state->turnaround_histogram, turnaround);
+  histogram_record(&state->response_histogram, response);
+  histogram_record(&state->waiting_histogram, waiting);
+  state->finished_count++;
+  note_burst(job);
+  if(state->fair_share)
+  {
+    group_of(job)->waiting_time += waiting;
+    group_of(job)->finished_count++;
+  }
+
+  if(state->job_log != NULL)
+  {
+    scheduler_job_record_t record;
+    record.job_number = job->job_id;
+    record.arrival_time = stats->arrival_time;
+    record.start_time = stats->original_start_time;
+    record.finish_time = time;
+    record.preemptions = stats->preemptions;
+    record.core_id = job->core_id;
+    if(state->job_log_binary)
+    {
+      fwrite(&record, sizeof(record), 1, state->job_log);
+    }
+    else
+    {
+      fprintf(state->job_log, "%d,%d,%d,%d,%d,%d\n", record.job_number, record.arrival_time,
+              record.start_time, record.finish_time, record.preemptions, record.core_id);
+    }
+  }
+}
+
+//peeks at the gang queue head, first dropping the entries of jobs that
+//already left the queue by backfilling (and freeing those that finished)
+static job_t* gang_head()
+{
+  job_t* head;
+  while((head = (job_t*)heap_peek(&state->ready)) != NULL && job_stats(head)->backfilled)
+  {
+    job_stats_t* stats = job_stats(head);
+    heap_poll(&state->ready);
+    stats->backfilled = 0;
+    if(stats->finished)
+    {
+      job_release(head);
+    }
+  }
+  return head;
+}
+
+static int compare_gang_end(const void* left, const void* right)
+{
+  return ((const gang_end_t*)left)->end - ((const gang_end_t*)right)->end;
+}
+
+//starts a waiting job on the lowest free cores; the first of them is the
+//core the job is reported to finish on
+static void gang_start(job_t* job, int time)
+{
+  int taken = 0;
+  job->core_id = -1;
+  for(int i = 0; i < state->num_cores && taken < job->cores_required; i++)
+  {
+    if(state->avail_cores[i] == 0)
+    {
+      if(job->core_id == -1)
+      {
+        job->core_id = i;
+      }
+      state->running[i] = job;
+      state->avail_cores[i] = 1;
+      taken++;
+      if(state->last_job_on_core[i] != -1 && state->last_job_on_core[i] != job->job_id)
+      {
+        state->context_switch_count++;
+      }
+      state->last_job_on_core[i] = job->job_id;
+    }
+  }
+  state->free_cores -= job->cores_required;
+  state->gang_waiting--;
+  backfill_erase(job);
+  job_stats_t* stats = job_stats(job);
+  stats->last_core = job->core_id;
+  stats->original_start_time = time;
+  stats->last_start_time = time;
+  job->last_checked_time = time;
+}
+
+//starts the queue head for as long as it fits, then backfills the cores
+//that are still free
+static void gang_schedule(int time)
+{
+  job_t* head;
+  while((head = gang_head()) != NULL && head->cores_required <= state->free_cores)
+  {
+    heap_poll(&state->ready);
+    gang_start(head, time);
+  }
+  if(head == NULL || !state->gang_backfill || state->free_cores == 0)
+  {
+    return;
+  }
+
+  //the head is guaranteed to start by shadow, when enough running jobs have
+  //ended; extra is how many of the cores free then it does not need
+  int ends = 0;
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    if(state->running[i] != NULL && state->running[i]->core_id == i)
+    {
+      state->gang_ends[ends].end = job_stats(state->running[i])->last_start_time + state->running[i]->run_time;
+      state->gang_ends[ends].cores = state->running[i]->cores_required;
+      ends++;
+    }
+  }
+  qsort(state->gang_ends, ends, sizeof(gang_end_t), compare_gang_end);
+  int shadow = time;
+  int extra = state->free_cores;
+  for(int i = 0; i < ends && extra < head->cores_required; i++)
+  {
+    shadow = state->gang_ends[i].end;
+    extra += state->gang_ends[i].cores;
+  }
+  extra -= head->cores_required;
+
+  //a job may jump the queue if it is done by shadow, or if it only uses
+  //cores the head will not need; the head itself never fits, so it is
+  //never picked
+  while(state->free_cores > 0)
+  {
+    job_t* job = backfill_find(shadow - time, state->free_cores);
+    if(job == NULL)
+    {
+      job = backfill_find(INT_MAX, state->free_cores < extra ? state->free_cores : extra);
+      if(job == NULL)
+      {
+        break;
+      }
+      extra -= job->cores_required;
+    }
+    //its queue entry stays behind and is skipped by gang_head()
+    job_stats(job)->backfilled = 1;
+    state->backfill_count++;
+    gang_start(job, time);
+  }
+}
+
+//queues an arriving gang job and starts whatever can run now; returns the
+//first core of the arrival, or -1 if it waits
+static int gang_admit(job_t* job, int time)
+{
+  job_stats(job)->last_queue_time = time;
+  job->queue_seq = state->next_queue_seq++;
+  heap_offer(&state->ready, job);
+  backfill_insert(job);
+  state->gang_waiting++;
+  gang_schedule(time);
+  return job->core_id;
+}
+
+/*                                          **
+**---------------DEPENDENCIES---------------**
+**                                          */
+//holds an arriving job whose predecessors have not all finished; returns 1
+//if it was held
+static int dag_hold(job_t* job)
+{
+  if(job->job_id < 0 || job->job_id >= state->dag_jobs || state->dag_pending[job->job_id] == 0)
+  {
+    return 0;
+  }
+  state->dag_held[job->job_id] = job;
+  state->held_count++;
+  return 1;
+}
+
+//counts a finished job off each successor; those that have arrived and have
+//nothing left to wait for go to the release queue
+static void dag_finish(int job_number)
+{
+  if(job_number < 0 || job_number >= state->dag_jobs)
+  {
+    return;
+  }
+  for(int e = state->dag_first[job_number]; e < state->dag_first[job_number + 1]; e++)
+  {
+    int successor = state->dag_successors[e];
+    if(--state->dag_pending[successor] == 0 && state->dag_held[successor] != NULL)
+    {
+      state->dag_released[state->dag_released_tail++] = successor;
+    }
+  }
+}
+
+static void dag_destroy()
+{
+  free(state->dag_first);
+  free(state->dag_successors);
+  free(state->dag_pending);
+  free(state->dag_held);
+  free(state->dag_released);
+  state->dag_jobs = 0;
+}
+/**
+  Allocates a scheduler instance. Make it current with scheduler_use(), then
+  set it up with scheduler_start_up() as usual.
+
+  @return the new instance
+  @return NULL if memory could not be allocated
+*/
+scheduler_t* scheduler_create()
+{
+  return calloc(1, sizeof(scheduler_t));
+}
+
+
+/**
+  Makes the calling thread's scheduler_* calls act on an instance. Every
+  thread starts out on a default instance, so a program with one scheduler
+  never needs this. A thread may switch between instances at any time, but
+  an instance must only be used by one thread at a time.
+
+  @param scheduler the instance to use, or NULL for the default instance
+*/
+void scheduler_use(scheduler_t* scheduler)
+{
+  state = scheduler != NULL ? scheduler : &default_scheduler;
+}
+
+
+/**
+  Frees an instance allocated by scheduler_create(), after
+  scheduler_clean_up() has been called on it. If the calling thread was
+  using it, the thread goes back to the default instance.
+
+  @param scheduler the instance to free
+*/
+void scheduler_destroy(scheduler_t* scheduler)
+{
+  if(state == scheduler)
+  {
+    state = &default_scheduler;
+  }
+  free(scheduler);
+}
+
+
+/**
+  Initalizes the scheduler.
+
+  Assumptions:
+    - You may assume this will be the first scheduler function called.
+    - You may assume this function will be called once once.
+    - You may assume that cores is a positive, non-zero number.
+    - You may assume that scheme is a valid scheduling scheme.
+
+  @param cores the number of cores that is available by the scheduler. These cores will be known as core(id=0), core(id=1), ..., core(id=cores-1).
+  @param scheme  the scheduling scheme that should be used. This value will be one of the six enum values of scheme_t
+*/
+void scheduler_start_up(int cores, scheme_t scheme)
+{
+  /*                               **
+  *---INITIALIZE GLOBAL VARIABLES---*
+  **                               */
+  state->m_waiting_time = 0;
+  state->m_turnaround_time = 0;
+  state->m_response_time = 0;
+  state->num_jobs = 0;
+  histogram_init(&state->waiting_histogram);
+  histogram_init(&state->turnaround_histogram);
+  histogram_init(&state->response_histogram);
+  state->job_log = NULL;
+  state->job_log_binary = 0;
+  state->preemption_count = 0;
+  state->context_switch_count = 0;
+  state->finished_count = 0;
+
+  state->num_cores = cores;
+  //this array will be filled with 0 for a free core, 1 for a busy core
+  state->avail_cores = malloc((sizeof(int)) * cores);
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    state->avail_cores[i] = 0;
+  }
+  //set comparison scheme
+  state->scheduling_scheme = scheme;
+
+  state->running = malloc(sizeof(job_t*) * cores);
+  state->run_finish = malloc(sizeof(long long) * cores);
+  state->run_banked = malloc(sizeof(long long) * cores);
+  state->run_priority = malloc(sizeof(int) * cores);
+  state->finish_heap = malloc(sizeof(int) * cores);
+  state->finish_heap_slot = malloc(sizeof(int) * cores);
+  state->finish_heap_size = 0;
+  state->last_job_on_core = malloc(sizeof(int) * cores);
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    state->running[i] = NULL;
+    state->finish_heap_slot[i] = -1;
+    state->last_job_on_core[i] = -1;
+  }
+  state->global_pass = 0;
+  state->next_queue_seq = 0;
+  state->aging_interval = 0;
+  heap_init(&state->ready,AGING_comp);
+  state->lottery_tree = NULL;
+  state->lottery_jobs = NULL;
+  state->lottery_free_slots = NULL;
+  state->lottery_capacity = 0;
+  state->lottery_used = 0;
+  state->lottery_free_count = 0;
+  state->lottery_total = 0;
+  state->lottery_rng = 0x9E3779B97F4A7C15ULL;
+
+  state->multiqueue = 0;
+  state->placement_policy = PLACE_LEAST_LOADED;
+  state->steal_policy = STEAL_BUSIEST;
+  state->migration_cost = 0;
+  state->local_queues = NULL;
+  state->next_placement = 0;
+  state->pending_penalty = malloc(sizeof(int) * cores);
+  state->dispatch_penalty = malloc(sizeof(int) * cores);
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    state->pending_penalty[i] = 0;
+    state->dispatch_penalty[i] = 0;
+  }
+  state->overhead_time = 0;
+  state->switch_cost = 0;
+  state->migration_penalty = 0;
+  state->migration_count = 0;
+  state->core_speed = malloc(sizeof(int) * cores);
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    state->core_speed[i] = CORE_SPEED_UNIT;
+  }
+  state->heterogeneous = 0;
+  state->gang = 0;
+  state->gang_backfill = 0;
+  state->free_cores = cores;
+  state->gang_waiting = 0;
+  state->backfill_count = 0;
+  state->backfill_root = NULL;
+  state->gang_ends = NULL;
+  state->io_bursts = 0;
+  heap_init(&state->wake_heap, WAKE_comp);
+  state->blocked_count = 0;
+  state->block_count = 0;
+  state->dag_jobs = 0;
+  state->dag_first = NULL;
+  state->dag_successors = NULL;
+  state->dag_pending = NULL;
+  state->dag_held = NULL;
+  state->dag_released = NULL;
+  state->dag_released_head = 0;
+  state->dag_released_tail = 0;
+  state->held_count = 0;
+  state->fair_share = 0;
+  state->fair_jobs = 0;
+  state->fair_group = NULL;
+  state->groups = NULL;
+  state->group_count = 0;
+  state->fair_heap = NULL;
+  state->fair_heap_size = 0;
+  state->fair_half_life = 0;
+  state->quantum = 0;
+  state->quantum_granularity = 0;
+  state->burst_average = 0;
+  state->last_quantum = 0;
+  state->quantum_total = 0;
+  state->quantum_count = 0;
+  state->steal_count = 0;
+  state->max_imbalance = 0;
+  state->imbalance_samples = 0;
+  state->imbalance_total = 0;
+  state->job_chunks = NULL;
+  state->job_chunk_count = 0;
+  state->free_jobs = NULL;
+  state->job_stats = NULL;
+
+  switch(state->scheduling_scheme)
+  {
+    case FCFS:
+    {
+      priqueue_init(&state->queue,&FCFS_comp);
+
+      break;
+    }
+    case SJF:
+    {
+      priqueue_init(&state->queue,SJF_comp);
+      break;
+    }
+    case PSJF:
+    {
+      //queue stays empty, running jobs keep their remaining work as of their
+      //last dispatch and only ready jobs are ordered
+      priqueue_init(&state->queue,SJF_comp);
+      heap_init(&state->ready,LOCAL_comp);
+      break;
+    }
+    case PRI:
+    {
+      priqueue_init(&state->queue,PRI_comp);
+      break;
+    }
+    case PPRI:
+    {
+      priqueue_init(&state->queue,PRI_comp);
+      break;
+    }
+    case RR:
+    {
+      priqueue_init(&state->queue,FCFS_comp);
+      break;
+    }
+    case STRIDE:
+    case LOTTERY:
+    {
+      //queue stays empty, jobs are tracked through running[] and the ready set
+      priqueue_init(&state->queue,FCFS_comp);
+      heap_init(&state->ready,STRIDE_comp);
+      break;
+    }
+    default:
+    {
+      printf("something happened\n");
+      break;
+    }
+  }
+}
+
+
+/**
+  Enables starvation-free aging for the PRI and PPRI schemes.
+
+  While a job waits in the ready queue its effective priority improves by one
+  level every interval time units; the clock restarts whenever the job is
+  queued again (e.g. after being preempted). Aging is applied lazily through
+  the ordering key, so it adds no per-tick work.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+
+  @param interval number of time units per priority level gained, or 0 to disable aging
+*/
+void scheduler_set_aging(int interval)
+{
+  state->aging_interval = interval > 0 ? interval : 0;
+}
+
+
+/**
+  Switches the scheduler from one shared ready queue to a run queue per core.
+
+  Arriving jobs that cannot start right away are placed on a core's local
+  queue according to placement; preemptive schemes only compare an arrival
+  against the job on that core. A core whose local queue is empty steals
+  the best job from another core's queue, chosen by steal, and pays
+  migration cost time units of overhead before the stolen job makes
+  progress (see scheduler_dispatch_penalty()). Preempted jobs and jobs whose
+  quantum expired go back on the queue of the core they ran on.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+    - The scheme is not STRIDE or LOTTERY, which always use a shared ready set.
+
+  @param placement how arriving jobs are assigned to local queues
+  @param steal how an idle core picks the queue to steal from
+  @param cost overhead, in time units, charged when a job is stolen
+*/
+void scheduler_set_multiqueue(placement_t placement, steal_t steal, int cost)
+{
+  if(state->scheduling_scheme == STRIDE || state->scheduling_scheme == LOTTERY)
+  {
+    return;
+  }
+  state->multiqueue = 1;
+  state->placement_policy = placement;
+  state->steal_policy = steal;
+  state->migration_cost = cost > 0 ? cost : 0;
+  state->local_queues = malloc(sizeof(heap_t) * state->num_cores);
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    heap_init(&state->local_queues[i], LOCAL_comp);
+  }
+}
+
+
+/**
+  Charges overhead for context switches and migrations. Every dispatch that
+  puts a different job on a core than the one it ran last costs
+  context_switch time units, and a job resuming on a different core than it
+  last ran on costs migration more (on top of any multi-queue steal cost).
+  The job makes no progress while the overhead is paid; see
+  scheduler_dispatch_penalty(). When an arriving job can choose among idle
+  cores it prefers the one it last ran on.
+
+  With either cost enabled every scheme runs on the ready-set path, where
+  dispatches go through one place that can charge them.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+
+  @param context_switch overhead, in time units, of switching a core to another job
+  @param migration overhead, in time units, of resuming a job on another core
+*/
+void scheduler_set_switch_costs(int context_switch, int migration)
+{
+  state->switch_cost = context_switch > 0 ? context_switch : 0;
+  state->migration_penalty = migration > 0 ? migration : 0;
+  order_ready_set();
+}
+
+
+/**
+  Gives each core its own speed. A core with speed CORE_SPEED_UNIT finishes
+  one unit of a job's running time per time unit; a core at twice that
+  speed finishes two. Remaining work drains at the speed of whichever core
+  the job is on, PSJF compares remaining work and displaces the job with
+  the longest remaining time on its core, and an arriving job takes the
+  fastest idle core. Waiting time becomes turnaround minus the time the job
+  actually spent running.
+
+  With speeds that differ from CORE_SPEED_UNIT every scheme runs on the
+  ready-set path.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+    - Every speed is positive.
+
+  @param speeds speed of each core, CORE_SPEED_UNIT being 1.0
+*/
+void scheduler_set_core_speeds(int* speeds)
+{
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    state->core_speed[i] = speeds[i] > 0 ? speeds[i] : CORE_SPEED_UNIT;
+    if(state->core_speed[i] != CORE_SPEED_UNIT)
+    {
+      state->heterogeneous = 1;
+    }
+  }
+  order_ready_set();
+}
+
+
+/**
+  Lets jobs hold several cores at once, see scheduler_new_gang_job(). A job
+  starts only when every core it needs is free, taking the lowest free
+  cores, and waiting jobs are queued in the scheme's order: arrival for
+  FCFS, run time for SJF, priority for PRI.
+
+  With backfill set the queue head has a reservation at the earliest time
+  enough running jobs will have finished, and later jobs may start on idle
+  cores first as long as they either finish by then or only use cores the
+  head will not need (EASY backfilling). Among the jobs that qualify the
+  shortest goes first. Without backfill jobs start strictly in queue order.
+
+  Assumptions:
+    - This function is called after scheduler_start_up(), after any other
+      scheduler_set_*() function, and before the first job arrives.
+
+  A job's backfill fields share its storage with the aging, stride and I/O
+  ones, so gang scheduling is refused for any scheme but FCFS, SJF and PRI,
+  and once aging, multi-queue mode, switch costs, core speeds or I/O bursts
+  are enabled.
+
+  @param backfill 1 for EASY backfilling, 0 for strict queue order
+  @return 0 on success
+  @return -1 if gang scheduling cannot be combined with the configuration, or memory could not be allocated
+*/
+int scheduler_set_gang(int backfill)
+{
+  if((state->scheduling_scheme != FCFS && state->scheduling_scheme != SJF && state->scheduling_scheme != PRI) ||
+     is_aging() || state->multiqueue || dispatch_overhead() || state->heterogeneous || state->io_bursts)
+  {
+    return -1;
+  }
+  gang_end_t* ends = malloc(sizeof(gang_end_t) * state->num_cores);
+  if(ends == NULL)
+  {
+    return -1;
+  }
+  free(state->gang_ends);
+  state->gang_ends = ends;
+  state->gang = 1;
+  state->gang_backfill = backfill != 0;
+  heap_init(&state->ready, LOCAL_comp);
+  return 0;
+}
+
+
+/**
+  Lets jobs alternate CPU bursts with I/O, see scheduler_job_blocked() and
+  scheduler_job_woke(). A blocked job holds no core and is not counted as
+  ready, and the time it spends on I/O is left out of its waiting time.
+
+  With I/O enabled every scheme runs on the ready-set path.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+    - Gang scheduling is not enabled.
+
+  @param enabled 1 to let jobs block on I/O, 0 otherwise
+*/
+void scheduler_set_io_bursts(int enabled)
+{
+  state->io_bursts = enabled != 0;
+  order_ready_set();
+}
+
+
+/**
+  Makes jobs wait for other jobs to finish before they can start. The graph
+  is given in compressed sparse row form: the jobs that depend on job j are
+  successors[first[j]] to successors[first[j + 1] - 1]. Both arrays are
+  copied.
+
+  A job that arrives before all of its predecessors have finished is held
+  off every queue; when the last of them finishes, scheduler_job_released()
+  admits it like an arrival. Its statistics still count from its arrival,
+  so time spent waiting on predecessors is waiting time.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+    - Gang scheduling is not enabled.
+    - The graph has no cycles, and every job number below jobs arrives once.
+
+  @param jobs the number of jobs the graph covers, numbered from 0
+  @param first jobs + 1 offsets into successors, starting at 0
+  @param successors the job numbers of the successors, grouped by predecessor
+  @return 0 on success
+  @return -1 if memory could not be allocated or a successor is out of range
+*/
+int scheduler_set_dependencies(int jobs, const int* first, const int* successors)
+{
+  int edges = first[jobs];
+  dag_destroy();
+  state->dag_first = malloc(sizeof(int) * (jobs + 1));
+  state->dag_successors = malloc(sizeof(int) * (edges + 1));
+  state->dag_pending = calloc(jobs + 1, sizeof(int));
+  state->dag_held = calloc(jobs + 1, sizeof(job_t*));
+  state->dag_released = malloc(sizeof(int) * (jobs + 1));
+  if(state->dag_first == NULL || state->dag_successors == NULL || state->dag_pending == NULL ||
+     state->dag_held == NULL || state->dag_released == NULL)
+  {
+    dag_destroy();
+    return -1;
+  }
+  memcpy(state->dag_first, first, sizeof(int) * (jobs + 1));
+  memcpy(state->dag_successors, successors, sizeof(int) * edges);
+  for(int e = 0; e < edges; e++)
+  {
+    if(successors[e] < 0 || successors[e] >= jobs)
+    {
+      dag_destroy();
+      return -1;
+    }
+    state->dag_pending[successors[e]]++;
+  }
+  state->dag_jobs = jobs;
+  state->dag_released_head = 0;
+  state->dag_released_tail = 0;
+  state->held_count = 0;
+  return 0;
+}
+
+
+/**
+  Shares the cores fairly between groups of jobs, such as the users or
+  tenants that submitted them. Each group queues its waiting jobs apart, in
+  the order the scheme would; a free core takes the next job of the group
+  that has used the least CPU time for its weight (see
+  scheduler_set_group_weight()). Usage halves every half_life time units,
+  and is charged whenever a job leaves a core, so choosing a job costs
+  O(log groups + log jobs in the group). Preemption still compares jobs by
+  the scheme's own key.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+    - The scheme is FCFS, SJF, PSJF, PRI, PPRI or RR.
+    - Neither per-core run queues nor gang scheduling are enabled.
+
+  @param jobs the number of jobs groups covers, numbered from 0; later job numbers belong to group 0
+  @param groups the group of each job, from 0
+  @param half_life time units for usage to decay by half, or 0 to never decay it
+  @return 0 on success
+  @return -1 if memory could not be allocated or a group is negative
+*/
+int scheduler_set_fair_share(int jobs, const int* groups, int half_life)
+{
+  int count = 1;
+  for(int i = 0; i < jobs; i++)
+  {
+    if(groups[i] < 0)
+    {
+      return -1;
+    }
+    if(groups[i] >= count)
+    {
+      count = groups[i] + 1;
+    }
+  }
+  fair_destroy();
+  state->fair_group = malloc(sizeof(int) * (jobs + 1));
+  state->groups = malloc(sizeof(group_t) * count);
+  state->fair_heap = malloc(sizeof(int) * count);
+  if(state->fair_group == NULL || state->groups == NULL || state->fair_heap == NULL)
+  {
+    fair_destroy();
+    return -1;
+  }
+  memcpy(state->fair_group, groups, sizeof(int) * jobs);
+  for(int g = 0; g < count; g++)
+  {
+    heap_init(&state->groups[g].ready, LOCAL_comp);
+    state->groups[g].usage_key = -HUGE_VAL;
+    state->groups[g].waiting_time = 0;
+    state->groups[g].finished_count = 0;
+    state->groups[g].weight = 1;
+    state->groups[g].heap_slot = -1;
+  }
+  state->fair_jobs = jobs;
+  state->group_count = count;
+  state->fair_heap_size = 0;
+  state->fair_half_life = half_life;
+  state->fair_share = 1;
+  return 0;
+}
+
+
+/**
+  Sets how large a share of the cores a group is entitled to, relative to
+  the others; every group starts with weight 1.
+
+  Assumptions:
+    - This function is called after scheduler_set_fair_share() and before the first job arrives.
+
+  @param group the group, as given to scheduler_set_fair_share()
+  @param weight a positive weight
+*/
+void scheduler_set_group_weight(int group, int weight)
+{
+  if(group >= 0 && group < state->group_count && weight > 0)
+  {
+    state->groups[group].weight = weight;
+  }
+}
+
+
+/**
+  Sets the time slice a job gets each time it is dispatched under RR,
+  STRIDE or LOTTERY, see scheduler_quantum(). With a granularity of 0 every
+  slice is quantum time units. Otherwise quantum is a target latency: the
+  time in which every job sharing a core should get a turn. The slice is
+  then quantum divided by the jobs sharing the core, so a short queue gets
+  long slices and a long queue short ones, but never below granularity, so
+  that the time lost to context switches stays bounded under load.
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+
+  @param quantum the fixed slice, or the target latency, in time units
+  @param granularity the smallest slice, no larger than quantum, or 0 for a fixed slice
+*/
+void scheduler_set_quantum(int quantum, int granularity)
+{
+  state->quantum = quantum;
+  state->quantum_granularity = granularity;
+}
+
+
+/**
+  Streams a completion record (see scheduler_job_record_t) for every job to
+  log as it finishes. A CSV log starts with a header line; a binary log is
+  a plain sequence of records. The caller keeps ownership of log and closes
+  it after scheduler_clean_up().
+
+  Assumptions:
+    - This function is called after scheduler_start_up() and before the first job arrives.
+
+  @param log the stream to write to, or NULL to stop logging
+  @param binary 1 to write raw records, 0 to write CSV
+*/
+void scheduler_set_job_log(FILE* log, int binary)
+{
+  state->job_log = log;
+  state->job_log_binary = binary;
+  if(state->job_log != NULL && !state->job_log_binary)
+  {
+    fprintf(state->job_log, "job,arrival,start,finish,preemptions,core\n");
+  }
+}
+
+
+/**
+  Returns the overhead charged to the job most recently dispatched on a core.
+
+  The job makes no progress for this many time units after being placed on
+  the core. Call this after a scheduler function assigns a job to core_id.
+
+  @param core_id the zero-based index of the core
+  @return overhead in time units, 0 if the dispatch was free
+*/
+int scheduler_dispatch_penalty(int core_id)
+{
+  return state->dispatch_penalty[core_id];
+}
+
+
+/**
+  Returns the time slice of the job most recently dispatched on a core, as
+  set by scheduler_set_quantum(). Call this once after a scheduler function
+  assigns a job to core_id; the slice is counted in
+  scheduler_average_quantum().
+
+  @param core_id the zero-based index of the core
+  @return the slice in time units, counted from when the job starts making progress
+*/
+int scheduler_quantum(int core_id)
+{
+  int slice = state->quantum_granularity > 0 ? adaptive_quantum(core_id) : state->quantum;
+  state->last_quantum = slice;
+  state->quantum_total += slice;
+  state->quantum_count++;
+  return slice;
+}
+
+
+//allocates the scheduler's record of an arriving job, or returns NULL if
+//memory could not be allocated
+static job_t* create_job(int job_number, int time, int running_time, int priority)
+{
+  job_t* to_add = job_alloc(state);
+  if(to_add == NULL)
+  {
+    return NULL;
+  }
+  job_stats_t* stats = job_stats(to_add);
+  to_add->job_id = job_number;
+  stats->original_run_time = running_time;
+  stats->burst_time = running_time;
+  to_add->run_time = running_time;
+  stats->arrival_time = time;
+  to_add->priority = priority;
+  stats->original_start_time = -1;
+  stats->last_start_time = -1;
+  stats->last_queue_time = -1;
+  to_add->core_id = -1;
+  to_add->last_checked_time = -1;
+  //only the members of the union the scheme uses
+  if(state->gang)
+  {
+    to_add->cores_required = 1;
+    to_add->backfill_left = NULL;
+    to_add->backfill_right = NULL;
+  }
+  else if(state->scheduling_scheme == STRIDE)
+  {
+    to_add->pass = state->global_pass + job_stride(to_add);
+  }
+  else if(state->scheduling_scheme == LOTTERY)
+  {
+    to_add->lottery_slot = -1;
+  }
+  else if(is_aging())
+  {
+    to_add->aged_priority = priority;
+  }
+  to_add->queue_seq = -1;
+  stats->preemptions = 0;
+  stats->last_core = -1;
+  to_add->work = (long long)running_time * CORE_SPEED_UNIT;
+  stats->service_time = 0;
+  stats->backfilled = 0;
+  stats->finished = 0;
+  to_add->wake_time = -1;
+  stats->io_time = 0;
+  state->num_jobs++;
+  return to_add;
+}
+
+/*
+  Admits an arriving job. idle_core is the lowest idle core, or -1 if every
+  core is busy. On the shared-queue path offer is 0 when the caller inserts
+  the job into queue itself.
+*/
+static int admit_job(job_t* to_add, int idle_core, int time, int offer)
+{
+  int to_return = idle_core;
+  if(uses_ready_set())
+  {
+    if(to_return == -1 && state->multiqueue)
+    {
+      //only the job on the placement core competes with the arrival
+      int core = place_core();
+      if(should_preempt(to_add, core, time))
+      {
+        preempt(core, time);
+        to_return = core;
+      }
+      else
+      {
+        ready_add(to_add, core, time);
+        return -1;
+      }
+    }
+    else if(to_return == -1 && (state->scheduling_scheme == PSJF || state->scheduling_scheme == PPRI))
+    {
+      //the arrival can only displace the job furthest from the front
+      int victim;
+      if(state->scheduling_scheme == PSJF && !dispatch_overhead())
+      {
+        victim = state->finish_heap[0];
+      }
+      else if(state->scheduling_scheme == PSJF)
+      {
+        victim = corescan_longest(state->run_finish, state->run_banked, state->num_cores, (long long)time * CORE_SPEED_UNIT);
+      }
+      else
+      {
+        victim = corescan_highest(state->run_priority, state->num_cores);
+      }
+      if(should_preempt(to_add, victim, time))
+      {
+        preempt(victim, time);
+        to_return = victim;
+      }
+    }
+    if(to_return != -1)
+    {
+      dispatch(to_add, to_return, time);
+      return to_return;
+    }
+    ready_add(to_add, -1, time);
+    return -1;
+  }
+  //mark the chosen core as in use
+  if(to_return != -1)
+  {
+    state->avail_cores[to_return] = 1;
+  }else
+  //i == num_cores => there is no free core, we need to check for preemption
+  {
+    switch(state->scheduling_scheme)
+    {
+      case PPRI:
+      {
+        int j;
+        job_t* curr_check = (job_t*)priqueue_peek(&state->queue);
+        int lowest_priority = curr_check->priority;
+        int core_of_lowest_priority = curr_check->core_id;
+        for(j = 0; j < state->num_cores; j++)
+        {
+          curr_check = (job_t*) priqueue_at(&state->queue,j);
+          if (curr_check->priority > lowest_priority)
+          {
+            lowest_priority = curr_check->priority;
+            core_of_lowest_priority = curr_check->core_id;
+          }
+        }
+        if(to_add->priority < lowest_priority)
+        {
+          core_of_lowest_priority = curr_check->core_id;
+          to_return = core_of_lowest_priority;
+          curr_check->core_id = -1;
+          count_preemption(curr_check);
+          if(job_stats(curr_check)->original_start_time == time)
+          {
+            job_stats(curr_check)->original_start_time = -1;
+            job_stats(curr_check)->last_start_time = -1;
+          }
+          else if(job_stats(curr_check)->last_start_time == time)
+          {
+
+          }
+          else
+          {
+            job_stats(curr_check)->last_queue_time = time;
+          }
+        }
+        break;
+      }
+      default:
+      {
+        break;
+      }
+    }
+  }
+  //update the core id of the new job
+  to_add->core_id = to_return;
+  //if the job is assigned to a core, set its start time to be current time
+  if(to_return != -1)
+  {
+    job_stats(to_add)->original_start_time = time;
+    job_stats(to_add)->last_start_time = time;
+    note_dispatch(to_add, to_return);
+  }
+  //add to queue
+  if(offer)
+  {
+    priqueue_offer(&state->queue,to_add);
+  }
+	return to_return;
+}
+
+/**
+  Called when a new job arrives.
+
+  If multiple cores are idle, the job should be assigned to the core with the
+  lowest id.
+  If the job arriving should be scheduled to run during the next
+  time cycle, return the zero-based index of the core the job should be
+  scheduled on. If another job is already running on the core specified,
+  this will preempt the currently running job.
+  Assumptions:
+    - You may assume that every job wil have a unique arrival time.
+
+  @param job_number a globally unique identification number of the job arriving.
+  @param time the current time of the simulator.
+  @param running_time the total number of time units this job will run before it will be finished.
+  @param priority the priority of the job. (The lower the value, the higher the priority.)
+  @return index of core job should be scheduled on
+  @return -1 if no scheduling changes should be made.
+  @return -1 if memory for the job could not be allocated, in which case it is dropped.
+
+ */
+int scheduler_new_job(int job_number, int time, int running_time, int priority)
+{
+  job_t* to_add = create_job(job_number, time, running_time, priority);
+  if(to_add == NULL)
+  {
+    return -1;
+  }
+  if(state->gang)
+  {
+    return gang_admit(to_add, time);
+  }
+  if(dag_hold(to_add))
+  {
+    return -1;
+  }
+  return admit_job(to_add, pick_idle_core(job_stats(to_add)->last_core), time, 1);
+}
+
+
+/**
+  Called when a new job that needs several cores at the same time arrives,
+  with gang scheduling enabled (see scheduler_set_gang()).
+
+  The arrival can start any number of waiting jobs, itself included, so the
+  caller should afterwards ask scheduler_core_job() about every idle core.
+  A job running on several cores is reported on each of them; the lowest of
+  those is the core it finishes on.
+
+  @param job_number a globally unique identification number of the job arriving.
+  @param time the current time of the simulator.
+  @param running_time the total number of time units this job will run before it will be finished.
+  @param priority the priority of the job. (The lower the value, the higher the priority.)
+  @param cores_required the number of cores the job holds while it runs, at most the number of cores
+  @return the lowest core the arriving job started on
+  @return -1 if the job has to wait
+  @return -1 if memory for the job could not be allocated, in which case it is dropped
+ */
+int scheduler_new_gang_job(int job_number, int time, int running_time, int priority, int cores_required)
+{
+  job_t* to_add = create_job(job_number, time, running_time, priority);
+  if(to_add == NULL)
+  {
+    return -1;
+  }
+  to_add->cores_required = cores_required < 1 ? 1 : cores_required > state->num_cores ? state->num_cores : cores_required;
+  return gang_admit(to_add, time);
+}
+
+
+//scheduler_new_jobs_batch() for jobs that can all start
+static void admit_batch(scheduler_job_spec_t* jobs, int count, int time, int* out_core_ids)
+{
+  job_t** created = malloc(sizeof(job_t*) * count);
+  int core = 0;
+  int k = 0;
+  //a job that could not be allocated is dropped, and the jobs in created
+  //are the first created_count that were
+  int created_count = 0;
+  if(created == NULL)
+  {
+    for(; k < count; k++)
+    {
+      out_core_ids[k] = scheduler_new_job(jobs[k].job_number, time, jobs[k].running_time, jobs[k].priority);
+    }
+    return;
+  }
+  //idle cores go to the earliest arrivals, lowest id first (fastest first
+  //when core speeds differ)
+  for(; k < count; k++)
+  {
+    if(state->heterogeneous)
+    {
+      core = pick_idle_core(-1);
+    }
+    while(core != -1 && core < state->num_cores && state->avail_cores[core] != 0)
+    {
+      core++;
+    }
+    if(core == -1 || core == state->num_cores)
+    {
+      break;
+    }
+    out_core_ids[k] = -1;
+    if((created[created_count] = create_job(jobs[k].job_number, time, jobs[k].running_time, jobs[k].priority)) == NULL)
+    {
+      continue;
+    }
+    out_core_ids[k] = admit_job(created[created_count++], core, time, 0);
+    core++;
+  }
+  int started = created_count;
+
+  if(!uses_ready_set() && state->scheduling_scheme != PSJF && state->scheduling_scheme != PPRI)
+  {
+    //nothing can be preempted, the rest simply wait
+    for(; k < count; k++)
+    {
+      out_core_ids[k] = -1;
+      if((created[created_count] = create_job(jobs[k].job_number, time, jobs[k].running_time, jobs[k].priority)) != NULL)
+      {
+        out_core_ids[k] = admit_job(created[created_count++], -1, time, 0);
+      }
+    }
+    priqueue_offer_all(&state->queue, (void**)created, created_count);
+  }
+  else
+  {
+    //every preemption decision depends on the previous one, so the rest are
+    //admitted one at a time (the ready-set paths are already O(log n) each)
+    if(!uses_ready_set())
+    {
+      priqueue_offer_all(&state->queue, (void**)created, started);
+    }
+    for(; k < count; k++)
+    {
+      job_t* job = create_job(jobs[k].job_number, time, jobs[k].running_time, jobs[k].priority);
+      out_core_ids[k] = job != NULL ? admit_job(job, -1, time, 1) : -1;
+    }
+  }
+  free(created);
+}
+
+
+/**
+  Called when several jobs arrive in the same time unit.
+
+  The outcome is identical to calling scheduler_new_job() for jobs[0],
+  jobs[1], ..., jobs[count-1] in that order at the same time, but idle cores
+  are handed out in a single pass over the core map and, for the
+  non-preemptive schemes, the jobs that have to wait are merged into the
+  queue in one step.
+
+  @param jobs the arriving jobs, in the order they would have been passed to scheduler_new_job()
+  @param count the number of jobs
+  @param time the current time of the simulator.
+  @param out_core_ids receives, for each job, what scheduler_new_job() would have returned
+ */
+void scheduler_new_jobs_batch(scheduler_job_spec_t* jobs, int count, int time, int* out_core_ids)
+{
+  if(state->gang)
+  {
+    for(int k = 0; k < count; k++)
+    {
+      out_core_ids[k] = scheduler_new_job(jobs[k].job_number, time, jobs[k].running_time, jobs[k].priority);
+    }
+    return;
+  }
+  if(state->dag_jobs == 0)
+  {
+    admit_batch(jobs, count, time, out_core_ids);
+    return;
+  }
+  //held jobs touch nothing else, so the rest form a batch of their own
+  scheduler_job_spec_t* admitted = malloc(sizeof(scheduler_job_spec_t) * count);
+  int* admitted_index = malloc(sizeof(int) * count);
+  int* admitted_cores = malloc(sizeof(int) * count);
+  int admitted_count = 0;
+  for(int k = 0; k < count; k++)
+  {
+    int number = jobs[k].job_number;
+    out_core_ids[k] = -1;
+    if(number >= 0 && number < state->dag_jobs && state->dag_pending[number] > 0)
+    {
+      job_t* held = create_job(number, time, jobs[k].running_time, jobs[k].priority);
+      if(held != NULL)
+      {
+        dag_hold(held);
+      }
+      continue;
+    }
+    admitted[admitted_count] = jobs[k];
+    admitted_index[admitted_count++] = k;
+  }
+  admit_batch(admitted, admitted_count, time, admitted_cores);
+  for(int k = 0; k < admitted_count; k++)
+  {
+    out_core_ids[admitted_index[k]] = admitted_cores[k];
+  }
+  free(admitted);
+  free(admitted_index);
+  free(admitted_cores);
+}
+
+
+/**
+  Called when a job has completed execution.
+
+  The core_id, job_number and time parameters are provided for convenience. You may be able to calculate the values with your own data structure.
+  If any job should be scheduled to run on the core free'd up by the
+  finished job, return the job_number of the job that should be scheduled to
+  run on core core_id.
+
+  With gang scheduling core_id is the lowest core the job held. Every core
+  it held is freed and any number of waiting jobs may start, so the caller
+  should ask scheduler_core_job() about every idle core.
+
+  With dependencies (see scheduler_set_dependencies()) the jobs this was the
+  last predecessor of are released; scheduler_job_released() admits them.
+
+  @param core_id the zero-based index of the core where the job was located.
+  @param job_number a globally unique identification number of the job.
+  @param time the current time of the simulator.
+  @return job_number of the job that should be scheduled to run on core core_id
+  @return -1 if core should remain idle.
+ */
+int scheduler_job_finished(int core_id, int job_number, int time)
+{
+  int i = 0, j = 0;
+  // int removal_index = -1;
+  int return_job_id = -1;
+  job_t* temp;
+
+  dag_finish(job_number);
+  if(state->gang)
+  {
+    temp = state->running[core_id];
+    if(temp != NULL)
+    {
+      for(i = 0; i < state->num_cores; i++)
+      {
+        if(state->running[i] == temp)
+        {
+          state->running[i] = NULL;
+          state->avail_cores[i] = 0;
+        }
+      }
+      state->free_cores += temp->cores_required;
+      account_finished(temp, time);
+      //a backfilled job is freed once its queue entry is dropped
+      job_stats(temp)->finished = 1;
+      if(!job_stats(temp)->backfilled)
+      {
+        job_release(temp);
+      }
+    }
+    gang_schedule(time);
+    return state->running[core_id] != NULL ? state->running[core_id]->job_id : -1;
+  }
+
+  if(uses_ready_set())
+  {
+    temp = state->running[core_id];
+    if(temp != NULL)
+    {
+      bank_progress(temp, time);
+      account_finished(temp, time);
+      job_release(temp);
+    }
+    return dispatch_next(core_id, time);
+  }
+
+  state->avail_cores[core_id] = 0;
+  for(;i < priqueue_size(&state->queue);i++)
+  {
+    temp = priqueue_at(&state->queue,i);
+    if(temp->core_id == core_id)
+    {
+      account_finished(temp, time);
+      priqueue_remove_at(&state->queue,i);
+      job_release(temp);
+      for(;j<priqueue_size(&state->queue);j++)
+      {
+        temp = priqueue_at(&state->queue,j);
         if(temp->core_id == -1)
         {
-          avail_cores[core_id] = 1;
+          state->avail_cores[core_id] = 1;
           temp->core_id = core_id;
-          if(temp->original_start_time==-1)
+          if(job_stats(temp)->original_start_time==-1)
           {
             // m_waiting_time = m_waiting_time + time - temp->arrival_time;
-            temp->original_start_time=time;
+            job_stats(temp)->original_start_time=time;
           }
           else
           {
             // m_waiting_time = m_waiting_time + time - temp->last_queue_time;
           }
           //here, update waiting time somehow temp->
+          note_dispatch(temp, core_id);
           return_job_id = temp->job_id;
-          temp->last_start_time=time;
+          job_stats(temp)->last_start_time=time;
           temp->last_checked_time = time;
           return return_job_id;
         }
       }
     }
   }
-	return return_job_id;
+	return return_job_id;
+}
+
+
+/**
+  Called when the job on a core finishes a CPU burst and starts I/O, with
+  I/O enabled (see scheduler_set_io_bursts()).
+
+  The job leaves the core and waits in the wake-up heap until time +
+  io_time, when scheduler_job_woke() offers it again with a CPU burst of
+  next_running_time time units. Its statistics carry over, so its response
+  time stays that of its first burst.
+
+  @param core_id the zero-based index of the core where the job was located.
+  @param job_number a globally unique identification number of the job.
+  @param time the current time of the simulator.
+  @param io_time how long the job's I/O takes
+  @param next_running_time the length of the CPU burst that follows the I/O
+  @return job_number of the job that should be scheduled to run on core core_id
+  @return -1 if core should remain idle.
+ */
+int scheduler_job_blocked(int core_id, int job_number, int time, int io_time, int next_running_time)
+{
+  job_t* job = state->running[core_id];
+  if(job != NULL)
+  {
+    bank_progress(job, time);
+    state->running[core_id] = NULL;
+    job->core_id = -1;
+    job->wake_time = time + io_time;
+    job_stats(job)->io_time += io_time;
+    note_burst(job);
+    job_stats(job)->original_run_time += next_running_time;
+    job_stats(job)->burst_time = next_running_time;
+    job->run_time = next_running_time;
+    job->work = (long long)next_running_time * CORE_SPEED_UNIT;
+    heap_offer(&state->wake_heap, job);
+    state->blocked_count++;
+    state->block_count++;
+  }
+  return dispatch_next(core_id, time);
+}
+
+
+/**
+  Returns when the earliest pending I/O completes.
+
+  @return the time the next blocked job wakes
+  @return -1 if no job is blocked
+ */
+int scheduler_next_wake_time()
+{
+  job_t* job = (job_t*)heap_peek(&state->wake_heap);
+  return job != NULL ? job->wake_time : -1;
+}
+
+
+/**
+  Offers again the blocked job whose I/O completes first, if it has
+  completed by time. Call this until it returns -1 to wake every job that
+  is due.
+
+  The job is admitted like an arriving job and may preempt, except that it
+  prefers the core it last ran on when several cores are idle.
+
+  @param time the current time of the simulator.
+  @param core_id receives the core the job should run on, as scheduler_new_job() would return it
+  @return job_number of the job that woke
+  @return -1 if no blocked job is due
+ */
+int scheduler_job_woke(int time, int* core_id)
+{
+  job_t* job = (job_t*)heap_peek(&state->wake_heap);
+  *core_id = -1;
+  if(job == NULL || job->wake_time > time)
+  {
+    return -1;
+  }
+  heap_poll(&state->wake_heap);
+  state->blocked_count--;
+  //a stride job does not bank the passes it missed while blocked
+  if(state->scheduling_scheme == STRIDE && job->pass < state->global_pass)
+  {
+    job->pass = state->global_pass;
+  }
+  *core_id = admit_job(job, pick_idle_core(job_stats(job)->last_core), time, 1);
+  return job->job_id;
+}
+
+
+/**
+  Admits the next job whose last predecessor has finished, see
+  scheduler_set_dependencies(). Call this after every finish until it
+  returns -1; jobs come out in the order they were released.
+
+  The job is admitted like an arriving job and may preempt.
+
+  @param time the current time of the simulator.
+  @param core_id receives the core the job should run on, as scheduler_new_job() would return it
+  @return job_number of the released job
+  @return -1 if no job is due
+ */
+int scheduler_job_released(int time, int* core_id)
+{
+  *core_id = -1;
+  if(state->dag_released_head == state->dag_released_tail)
+  {
+    return -1;
+  }
+  int number = state->dag_released[state->dag_released_head++];
+  job_t* job = state->dag_held[number];
+  state->dag_held[number] = NULL;
+  state->held_count--;
+  *core_id = admit_job(job, pick_idle_core(job_stats(job)->last_core), time, 1);
+  return job->job_id;
+}
+
+
+/**
+  When the scheme is set to RR, called when the quantum timer has expired
+  on a core.
+
+  If any job should be scheduled to run on the core free'd up by
+  the quantum expiration, return the job_number of the job that should be
+  scheduled to run on core core_id.
+
+  @param core_id the zero-based index of the core where the quantum has expired.
+  @param time the current time of the simulator.
+  @return job_number of the job that should be scheduled on core cord_id
+  @return -1 if core should remain idle
+ */
+int scheduler_quantum_expired(int core_id, int time)
+{
+  job_t* temp;
+  if(uses_ready_set())
+  {
+    temp = state->running[core_id];
+    if(temp != NULL)
+    {
+      //charge the expired quantum before the job competes again
+      if(state->scheduling_scheme == STRIDE)
+      {
+        temp->pass += job_stride(temp);
+      }
+      bank_progress(temp, time);
+      state->running[core_id] = NULL;
+      ready_add(temp, core_id, time);
+    }
+    int next_id = dispatch_next(core_id, time);
+    if(temp != NULL && state->running[core_id] != temp)
+    {
+      count_preemption(temp);
+    }
+    return next_id;
+  }
+  for(int i = 0; i<priqueue_size(&state->queue); i++)
+  {
+    temp = priqueue_at(&state->queue, i);
+    if(temp->core_id == core_id)
+    {
+      job_t* expired = temp;
+      priqueue_remove_at(&state->queue, i);
+      temp->core_id=-1;
+      job_stats(temp)->last_queue_time = time;
+      priqueue_offer(&state->queue, temp);
+      for(int j = 0; j<priqueue_size(&state->queue); j++)
+      {
+        temp = priqueue_at(&state->queue, j);
+        if(temp->core_id==-1)
+        {
+          if(job_stats(temp)->original_start_time==-1)
+          {
+            // m_waiting_time = m_waiting_time + time - temp->arrival_time;
+            job_stats(temp)->original_start_time=time;
+          }
+          else
+          {
+            // m_waiting_time = m_waiting_time + time - temp->last_queue_time;
+          }
+          job_stats(temp)->last_start_time=time;
+          temp->core_id=core_id;
+          note_dispatch(temp, core_id);
+          if(temp != expired)
+          {
+            count_preemption(expired);
+          }
+          return temp->job_id;
+        }
+      }
+    }
+  }
+  state->avail_cores[core_id]=0;
+  return -1;
+
+}
+
+/**
+  Returns the average waiting time of all jobs scheduled by your scheduler.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @return the average waiting time of all jobs scheduled.
+ */
+float scheduler_average_waiting_time()
+{
+  //total waiting
+  return (double)state->m_waiting_time/state->num_jobs;
+}
+
+
+/**
+  Returns the average turnaround time of all jobs scheduled by your scheduler.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @return the average turnaround time of all jobs scheduled.
+ */
+float scheduler_average_turnaround_time()
+{
+  //arrived to finished
+  return (double)state->m_turnaround_time/state->num_jobs;
+}
+
+
+/**
+  Returns the average response time of all jobs scheduled by your scheduler.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @return the average response time of all jobs scheduled.
+ */
+float scheduler_average_response_time()
+{
+  //arrived to started
+  return (double)state->m_response_time/state->num_jobs;
+}
+
+
+/**
+  Returns a percentile of a per-job statistic over all finished jobs.
+
+  Percentiles are read from fixed-size log-linear histograms: exact below
+  128 time units and within 1% above that.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @param metric which statistic to summarize
+  @param quantile the fraction of jobs at or below the result, e.g. 0.99 for p99
+  @return the estimated percentile, 0 if no job has finished
+ */
+int scheduler_percentile(metric_t metric, double quantile)
+{
+  switch(metric)
+  {
+    case METRIC_TURNAROUND:
+      return histogram_quantile(&state->turnaround_histogram, quantile);
+    case METRIC_RESPONSE:
+      return histogram_quantile(&state->response_histogram, quantile);
+    default:
+      return histogram_quantile(&state->waiting_histogram, quantile);
+  }
+}
+
+
+/**
+  Returns the number of jobs an idle core took from another core's queue.
+
+  @return the number of steals, always 0 outside multi-queue mode
+ */
+int scheduler_steal_count()
+{
+  return state->steal_count;
+}
+
+
+/**
+  Returns the average spread between the longest and the shortest local run
+  queue, sampled every time a job is placed on or stolen from a queue.
+
+  @return the average queue-length imbalance, 0 outside multi-queue mode
+ */
+float scheduler_average_imbalance()
+{
+  return state->imbalance_samples > 0 ? (float)state->imbalance_total / state->imbalance_samples : 0.0;
+}
+
+
+/**
+  Returns the largest spread between the longest and the shortest local run
+  queue seen during the run.
+
+  @return the maximum queue-length imbalance, 0 outside multi-queue mode
+ */
+int scheduler_max_imbalance()
+{
+  return state->max_imbalance;
+}
+
+
+/**
+  Returns the number of jobs that have arrived but are neither running nor
+  finished, blocked on I/O or held by their dependencies.
+
+  @return the current ready-queue length
+ */
+int scheduler_ready_count()
+{
+  if(state->gang)
+  {
+    return state->gang_waiting;
+  }
+  return state->num_jobs - state->finished_count - state->blocked_count - state->held_count - scheduler_running_count();
+}
+
+
+/**
+  Returns the job running on a core.
+
+  @param core_id the zero-based index of the core
+  @return job_number of the job on core core_id
+  @return -1 if the core is idle
+ */
+int scheduler_core_job(int core_id)
+{
+  if(uses_ready_set())
+  {
+    return state->running[core_id] != NULL ? state->running[core_id]->job_id : -1;
+  }
+  for(int i = 0; i < priqueue_size(&state->queue); i++)
+  {
+    job_t* temp = (job_t*)priqueue_at(&state->queue, i);
+    if(temp->core_id == core_id)
+    {
+      return temp->job_id;
+    }
+  }
+  return -1;
+}
+
+
+/**
+  Returns the number of cores currently running a job.
+
+  @return the number of busy cores
+ */
+int scheduler_running_count()
+{
+  int busy = 0;
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    busy += state->avail_cores[i] != 0;
+  }
+  return busy;
+}
+
+
+/**
+  Returns how many times a job has been forced off its core before
+  finishing, by a preempting arrival or by a quantum expiry that gave the
+  core to another job.
+
+  @return the number of preemptions so far
+ */
+int scheduler_preemption_count()
+{
+  return state->preemption_count;
+}
+
+
+/**
+  Returns how many times a core started a job other than the one it ran
+  last. A core's first job is not a switch.
+
+  @return the number of context switches so far
+ */
+int scheduler_context_switch_count()
+{
+  return state->context_switch_count;
+}
+
+
+/**
+  Returns how many times a job resumed on a different core than it last
+  ran on.
+
+  @return the number of migrations so far
+ */
+int scheduler_migration_count()
+{
+  return state->migration_count;
+}
+
+
+/**
+  Returns how many times a job blocked on I/O.
+
+  @return the number of I/O bursts started so far
+ */
+int scheduler_block_count()
+{
+  return state->block_count;
+}
+
+
+/**
+  Returns how many jobs have arrived but still wait on predecessors, see
+  scheduler_set_dependencies().
+
+  @return the number of held jobs
+ */
+int scheduler_held_count()
+{
+  return state->held_count;
+}
+
+
+/**
+  Returns the number of groups under fair share, see
+  scheduler_set_fair_share().
+
+  @return one more than the highest group, 0 without fair share
+ */
+int scheduler_group_count()
+{
+  return state->group_count;
+}
+
+
+/**
+  Returns the average waiting time of the finished jobs of a group.
+
+  @param group the group, as given to scheduler_set_fair_share()
+  @return the average waiting time
+  @return -1 if no job of the group has finished
+ */
+float scheduler_group_waiting_time(int group)
+{
+  if(group < 0 || group >= state->group_count || state->groups[group].finished_count == 0)
+  {
+    return -1;
+  }
+  return (float)state->groups[group].waiting_time / state->groups[group].finished_count;
 }
 
 
 /**
-  When the scheme is set to RR, called when the quantum timer has expired
-  on a core.
+  Returns how many gang jobs started ahead of the queue head.
 
-  If any job should be scheduled to run on the core free'd up by
-  the quantum expiration, return the job_number of the job that should be
-  scheduled to run on core core_id.
+  @return the number of backfilled jobs, always 0 without backfilling
+ */
+int scheduler_backfill_count()
+{
+  return state->backfill_count;
+}
 
-  @param core_id the zero-based index of the core where the quantum has expired.
-  @param time the current time of the simulator.
-  @return job_number of the job that should be scheduled on core cord_id
-  @return -1 if core should remain idle
+
+/**
+  Returns the total overhead charged to dispatches over the run.
+
+  @return overhead in time units
  */
-int scheduler_quantum_expired(int core_id, int time)
+int scheduler_overhead_time()
 {
-  job_t* temp;
-  for(int i = 0; i<priqueue_size(&queue); i++)
+  return (int)state->overhead_time;
+}
+
+
+/**
+  Returns the slice scheduler_quantum() handed out last.
+
+  @return the slice in time units
+  @return 0 if none was handed out yet
+ */
+int scheduler_last_quantum()
+{
+  return state->last_quantum;
+}
+
+
+/**
+  Returns the average slice scheduler_quantum() handed out over the run.
+
+  @return the average slice in time units
+  @return 0 if none was handed out
+ */
+float scheduler_average_quantum()
+{
+  return state->quantum_count > 0 ? (float)((double)state->quantum_total / state->quantum_count) : 0;
+}
+
+
+/*                                          **
+**-------------SAVE AND RESTORE-------------**
+**                                          */
+//a snapshot is the instance and its jobs copied as they are, with every
+//job pointer replaced by the job's index in the snapshot and every
+//comparer by its position in comparers[]
+#define SNAPSHOT_VERSION 3
+
+static int (*const comparers[])(const void*, const void*) = { FCFS_comp, SJF_comp, PRI_comp, STRIDE_comp, AGING_comp, WAKE_comp, LOCAL_comp };
+#define COMPARERS ((int)(sizeof(comparers) / sizeof(comparers[0])))
+
+static int comparer_id(int (*comp)(const void*, const void*))
+{
+  for(int i = 0; i < COMPARERS; i++)
   {
-    temp = priqueue_at(&queue, i);
-    if(temp->core_id == core_id)
+    if(comparers[i] == comp)
     {
-      priqueue_remove_at(&queue, i);
-      temp->core_id=-1;
-      temp->last_queue_time = time;
-      priqueue_offer(&queue, temp);
-      for(int j = 0; j<priqueue_size(&queue); j++)
-      {
-        temp = priqueue_at(&queue, j);
-        if(temp->core_id==-1)
-        {
-          if(temp->original_start_time==-1)
-          {
-            // m_waiting_time = m_waiting_time + time - temp->arrival_time;
-            temp->original_start_time=time;
-          }
-          else
-          {
-            // m_waiting_time = m_waiting_time + time - temp->last_queue_time;
-          }
-          temp->last_start_time=time;
-          temp->core_id=core_id;
-          return temp->job_id;
-        }
-      }
+      return i;
     }
   }
-  avail_cores[core_id]=0;
   return -1;
+}
+
+//the distinct jobs an instance holds, sorted by address so that a job's
+//index in the snapshot can be found by binary search
+typedef struct _job_index_t
+{
+  job_t** jobs;
+  int count, capacity;
+} job_index_t;
 
+static int compare_job_address(const void* left, const void* right)
+{
+  job_t* l = *(job_t* const*)left;
+  job_t* r = *(job_t* const*)right;
+  return l < r ? -1 : l > r;
 }
 
-/**
-  Returns the average waiting time of all jobs scheduled by your scheduler.
+static void index_add(job_index_t* index, job_t* job)
+{
+  if(job == NULL)
+  {
+    return;
+  }
+  if(index->count == index->capacity)
+  {
+    index->capacity = index->capacity == 0 ? 64 : index->capacity * 2;
+    index->jobs = realloc(index->jobs, sizeof(job_t*) * index->capacity);
+  }
+  index->jobs[index->count++] = job;
+}
 
-  Assumptions:
-    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
-  @return the average waiting time of all jobs scheduled.
- */
-float scheduler_average_waiting_time()
+static void index_add_tree(job_index_t* index, job_t* node)
 {
-  //total waiting
-  return m_waiting_time/num_jobs;
+  if(node != NULL)
+  {
+    index_add(index, node);
+    index_add_tree(index, node->backfill_left);
+    index_add_tree(index, node->backfill_right);
+  }
+}
+
+//-1 for NULL, and for the stale backfill links of a job outside the backfill index
+static int index_of(job_index_t* index, job_t* job)
+{
+  job_t** found = job == NULL ? NULL : bsearch(&job, index->jobs, index->count, sizeof(job_t*), compare_job_address);
+  return found == NULL ? -1 : (int)(found - index->jobs);
+}
+
+static int save_block(FILE* out, const void* data, size_t size, size_t count)
+{
+  return count == 0 || fwrite(data, size, count, out) == count;
+}
+
+//writes a job list as its length followed by the jobs' indices
+static int save_jobs(FILE* out, job_index_t* index, job_t** jobs, int count)
+{
+  int ok = save_block(out, &count, sizeof(int), 1);
+  for(int i = 0; i < count && ok; i++)
+  {
+    int id = index_of(index, jobs[i]);
+    ok = save_block(out, &id, sizeof(int), 1);
+  }
+  return ok;
+}
+
+static int save_heap(FILE* out, job_index_t* index, heap_t* heap)
+{
+  int comp = comparer_id(heap->comp);
+  return save_block(out, &comp, sizeof(int), 1) && save_jobs(out, index, (job_t**)heap->m_entries, heap->m_size);
+}
+
+static int restore_block(FILE* in, void* data, size_t size, size_t count)
+{
+  return count == 0 || fread(data, size, count, in) == count;
+}
+
+//reads a job list written by save_jobs() into a new array; *count is its length
+static job_t** restore_jobs(FILE* in, job_t** jobs, int job_count, int* count)
+{
+  if(!restore_block(in, count, sizeof(int), 1) || *count < 0)
+  {
+    return NULL;
+  }
+  job_t** list = malloc(sizeof(job_t*) * (*count + 1));
+  for(int i = 0; i < *count; i++)
+  {
+    int id;
+    if(!restore_block(in, &id, sizeof(int), 1) || id < -1 || id >= job_count)
+    {
+      free(list);
+      return NULL;
+    }
+    list[i] = id == -1 ? NULL : jobs[id];
+  }
+  return list;
+}
+
+static int restore_heap(FILE* in, job_t** jobs, int job_count, heap_t* heap)
+{
+  int comp, count;
+  if(!restore_block(in, &comp, sizeof(int), 1) || comp < 0 || comp >= COMPARERS)
+  {
+    return 0;
+  }
+  heap_init(heap, comparers[comp]);
+  job_t** list = restore_jobs(in, jobs, job_count, &count);
+  if(list == NULL)
+  {
+    return 0;
+  }
+  heap_append_all(heap, (void**)list, count);
+  free(list);
+  return 1;
+}
+
+static int* restore_ints(FILE* in, int count)
+{
+  int* values = malloc(sizeof(int) * (count > 0 ? count : 1));
+  if(!restore_block(in, values, sizeof(int), count))
+  {
+    free(values);
+    return NULL;
+  }
+  return values;
 }
 
 
 /**
-  Returns the average turnaround time of all jobs scheduled by your scheduler.
+  Writes everything the current instance knows to out: its configuration,
+  every job it holds with the order of each queue, the cores, and the
+  statistics gathered so far. scheduler_restore() turns the snapshot back
+  into an instance that makes exactly the decisions this one would have.
 
-  Assumptions:
-    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
-  @return the average turnaround time of all jobs scheduled.
- */
-float scheduler_average_turnaround_time()
+  The snapshot is in native byte order and only meant for the same build of
+  the library; the job log set by scheduler_set_job_log() is not part of it.
+  An instance with dependencies (see scheduler_set_dependencies()) or fair
+  share (see scheduler_set_fair_share()) cannot be saved.
+
+  @param out the stream to write to, opened in binary mode
+  @return 0 on success
+  @return -1 if writing failed, or the instance has dependencies or fair share
+*/
+int scheduler_save(FILE* out)
 {
-  //arrived to finished
-  return m_turnaround_time/num_jobs;
+  if(state->dag_jobs > 0 || state->fair_share)
+  {
+    return -1;
+  }
+  job_index_t index = { NULL, 0, 0 };
+  int queue_size = priqueue_size(&state->queue);
+  job_t** queue = malloc(sizeof(job_t*) * (queue_size + 1));
+  priqueue_to_array(&state->queue, (void**)queue);
+
+  for(int i = 0; i < queue_size; i++)
+  {
+    index_add(&index, queue[i]);
+  }
+  for(int i = 0; i < state->num_cores; i++)
+  {
+    index_add(&index, state->running[i]);
+  }
+  for(int i = 0; i < heap_size(&state->ready); i++)
+  {
+    index_add(&index, heap_at(&state->ready, i));
+  }
+  for(int i = 1; i <= state->lottery_capacity; i++)
+  {
+    index_add(&index, state->lottery_jobs[i]);
+  }
+  for(int c = 0; state->multiqueue && c < state->num_cores; c++)
+  {
+    for(int i = 0; i < heap_size(&state->local_queues[c]); i++)
+    {
+      index_add(&index, heap_at(&state->local_queues[c], i));
+    }
+  }
+  for(int i = 0; i < heap_size(&state->wake_heap); i++)
+  {
+    index_add(&index, heap_at(&state->wake_heap, i));
+  }
+  index_add_tree(&index, state->backfill_root);
+
+  //a job held in several places is stored once
+  qsort(index.jobs, index.count, sizeof(job_t*), compare_job_address);
+  int count = 0;
+  for(int i = 0; i < index.count; i++)
+  {
+    if(count == 0 || index.jobs[count - 1] != index.jobs[i])
+    {
+      index.jobs[count++] = index.jobs[i];
+    }
+  }
+  index.count = count;
+
+  int header[3] = { SNAPSHOT_VERSION, (int)sizeof(scheduler_t), (int)sizeof(job_t) };
+  int queue_comp = comparer_id(state->queue.comp);
+  int ok = save_block(out, header, sizeof(int), 3) && save_block(out, state, sizeof(scheduler_t), 1) &&
+           save_block(out, &index.count, sizeof(int), 1);
+  for(int i = 0; i < index.count && ok; i++)
+  {
+    //the backfill links share a union with keys of the other schemes
+    int links[2] = { -1, -1 };
+    if(state->gang)
+    {
+      links[0] = index_of(&index, index.jobs[i]->backfill_left);
+      links[1] = index_of(&index, index.jobs[i]->backfill_right);
+    }
+    ok = save_block(out, index.jobs[i], sizeof(job_t), 1) && save_block(out, job_stats(index.jobs[i]), sizeof(job_stats_t), 1) &&
+         save_block(out, links, sizeof(int), 2);
+  }
+
+  ok = ok && save_block(out, state->avail_cores, sizeof(int), state->num_cores) &&
+       save_block(out, state->last_job_on_core, sizeof(int), state->num_cores) &&
+       save_block(out, state->pending_penalty, sizeof(int), state->num_cores) &&
+       save_block(out, state->dispatch_penalty, sizeof(int), state->num_cores) &&
+       save_block(out, state->core_speed, sizeof(int), state->num_cores) &&
+       save_jobs(out, &index, state->running, state->num_cores) &&
+       save_block(out, &queue_comp, sizeof(int), 1) && save_jobs(out, &index, queue, queue_size) &&
+       save_heap(out, &index, &state->ready) && save_heap(out, &index, &state->wake_heap);
+  for(int c = 0; state->multiqueue && c < state->num_cores && ok; c++)
+  {
+    ok = save_heap(out, &index, &state->local_queues[c]);
+  }
+  if(ok && state->lottery_capacity > 0)
+  {
+    ok = save_block(out, state->lottery_tree, sizeof(long long), state->lottery_capacity + 1) &&
+         save_jobs(out, &index, state->lottery_jobs + 1, state->lottery_capacity) &&
+         save_block(out, state->lottery_free_slots, sizeof(int), state->lottery_free_count);
+  }
+  int root = index_of(&index, state->backfill_root);
+  ok = ok && save_block(out, &root, sizeof(int), 1);
+
+  free(queue);
+  free(index.jobs);
+  return ok ? 0 : -1;
 }
 
 
 /**
-  Returns the average response time of all jobs scheduled by your scheduler.
+  Sets up the current instance from a snapshot written by scheduler_save(),
+  in place of scheduler_start_up() and the scheduler_set_* calls. The
+  instance continues exactly where the saved one stopped. No job log is
+  set; call scheduler_set_job_log() afterwards to add one.
 
   Assumptions:
-    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
-  @return the average response time of all jobs scheduled.
- */
-float scheduler_average_response_time()
+    - The instance is new, or was cleaned up with scheduler_clean_up().
+
+  @param in the stream to read from, opened in binary mode
+  @return 0 on success
+  @return -1 if in does not hold a snapshot from this build, in which case the instance is left as it was
+*/
+int scheduler_restore(FILE* in)
 {
-  //arrived to started
-  return m_response_time/num_jobs;
+  int header[3], job_count = 0, count, comp, root;
+  scheduler_t restored;
+  if(!restore_block(in, header, sizeof(int), 3) || header[0] != SNAPSHOT_VERSION ||
+     header[1] != (int)sizeof(scheduler_t) || header[2] != (int)sizeof(job_t) ||
+     !restore_block(in, &restored, sizeof(scheduler_t), 1) || restored.num_cores <= 0 ||
+     restored.lottery_capacity < 0 || restored.lottery_free_count < 0 ||
+     restored.lottery_free_count > restored.lottery_capacity ||
+     !restore_block(in, &job_count, sizeof(int), 1) || job_count < 0)
+  {
+    return -1;
+  }
+
+  //the saved pointers mean nothing here; every container is rebuilt before
+  //anything is read into it, so a bad snapshot can be unwound in one place
+  int cores = restored.num_cores;
+  job_t** jobs = malloc(sizeof(job_t*) * (job_count + 1));
+  job_t** list = NULL;
+  restored.avail_cores = NULL;
+  restored.last_job_on_core = NULL;
+  restored.pending_penalty = NULL;
+  restored.dispatch_penalty = NULL;
+  restored.core_speed = NULL;
+  restored.running = NULL;
+  restored.dag_jobs = 0;
+  restored.dag_first = NULL;
+  restored.dag_successors = NULL;
+  restored.dag_pending = NULL;
+  restored.dag_held = NULL;
+  restored.dag_released = NULL;
+  restored.fair_share = 0;
+  restored.fair_jobs = 0;
+  restored.fair_group = NULL;
+  restored.groups = NULL;
+  restored.group_count = 0;
+  restored.fair_heap = NULL;
+  priqueue_init(&restored.queue, FCFS_comp);
+  heap_init(&restored.ready, LOCAL_comp);
+  heap_init(&restored.wake_heap, WAKE_comp);
+  restored.local_queues = NULL;
+  if(restored.multiqueue)
+  {
+    restored.local_queues = malloc(sizeof(heap_t) * cores);
+    for(int c = 0; c < cores; c++)
+    {
+      heap_init(&restored.local_queues[c], LOCAL_comp);
+    }
+  }
+  restored.lottery_tree = NULL;
+  restored.lottery_jobs = NULL;
+  restored.lottery_free_slots = NULL;
+  restored.backfill_root = NULL;
+  restored.gang_ends = restored.gang ? malloc(sizeof(gang_end_t) * cores) : NULL;
+  restored.job_log = NULL;
+  restored.job_log_binary = 0;
+  restored.job_chunks = NULL;
+  restored.job_chunk_count = 0;
+  restored.free_jobs = NULL;
+  restored.job_stats = NULL;
+
+  int ok = 1;
+  int* links = malloc(sizeof(int) * 2 * (job_count + 1));
+  for(int i = 0; i < job_count && ok; i++)
+  {
+    //the job keeps the pool slot it is given here
+    jobs[i] = job_alloc(&restored);
+    if(jobs[i] == NULL)
+    {
+      ok = 0;
+      break;
+    }
+    int slot = jobs[i]->slot;
+    ok = restore_block(in, jobs[i], sizeof(job_t), 1) && restore_block(in, &restored.job_stats[slot], sizeof(job_stats_t), 1) &&
+         restore_block(in, &links[2 * i], sizeof(int), 2) &&
+         links[2 * i] >= -1 && links[2 * i] < job_count && links[2 * i + 1] >= -1 && links[2 * i + 1] < job_count;
+    jobs[i]->slot = slot;
+  }
+  for(int i = 0; i < job_count && ok && restored.gang; i++)
+  {
+    jobs[i]->backfill_left = links[2 * i] == -1 ? NULL : jobs[links[2 * i]];
+    jobs[i]->backfill_right = links[2 * i + 1] == -1 ? NULL : jobs[links[2 * i + 1]];
+  }
+  free(links);
+
+  ok = ok && (!restored.gang || restored.gang_ends != NULL) &&
+       (restored.avail_cores = restore_ints(in, cores)) != NULL &&
+       (restored.last_job_on_core = restore_ints(in, cores)) != NULL &&
+       (restored.pending_penalty = restore_ints(in, cores)) != NULL &&
+       (restored.dispatch_penalty = restore_ints(in, cores)) != NULL &&
+       (restored.core_speed = restore_ints(in, cores)) != NULL &&
+       (restored.running = restore_jobs(in, jobs, job_count, &count)) != NULL && count == cores;
+
+  ok = ok && restore_block(in, &comp, sizeof(int), 1) && comp >= 0 && comp < COMPARERS &&
+       (list = restore_jobs(in, jobs, job_count, &count)) != NULL;
+  if(ok)
+  {
+    priqueue_init(&restored.queue, comparers[comp]);
+    priqueue_append_all(&restored.queue, (void**)list, count);
+    free(list);
+  }
+
+  ok = ok && restore_heap(in, jobs, job_count, &restored.ready) && restore_heap(in, jobs, job_count, &restored.wake_heap);
+  for(int c = 0; restored.multiqueue && c < cores && ok; c++)
+  {
+    ok = restore_heap(in, jobs, job_count, &restored.local_queues[c]);
+  }
+
+  if(ok && restored.lottery_capacity > 0)
+  {
+    restored.lottery_tree = malloc(sizeof(long long) * (restored.lottery_capacity + 1));
+    restored.lottery_free_slots = malloc(sizeof(int) * restored.lottery_capacity);
+    ok = restore_block(in, restored.lottery_tree, sizeof(long long), restored.lottery_capacity + 1) &&
+         (list = restore_jobs(in, jobs, job_count, &count)) != NULL;
+    if(ok)
+    {
+      //slot 0 is unused, see lottery_tree_add()
+      restored.lottery_jobs = realloc(list, sizeof(job_t*) * (count + 1));
+      memmove(restored.lottery_jobs + 1, restored.lottery_jobs, sizeof(job_t*) * count);
+      restored.lottery_jobs[0] = NULL;
+      ok = count == restored.lottery_capacity &&
+           restore_block(in, restored.lottery_free_slots, sizeof(int), restored.lottery_free_count);
+    }
+  }
+
+  ok = ok && restore_block(in, &root, sizeof(int), 1) && root >= -1 && root < job_count;
+  if(!ok)
+  {
+    priqueue_destroy(&restored.queue);
+    heap_destroy(&restored.ready);
+    heap_destroy(&restored.wake_heap);
+    for(int c = 0; restored.multiqueue && c < cores; c++)
+    {
+      heap_destroy(&restored.local_queues[c]);
+    }
+    free(restored.local_queues);
+    free(restored.lottery_tree);
+    free(restored.lottery_jobs);
+    free(restored.lottery_free_slots);
+    free(restored.gang_ends);
+    free(restored.avail_cores);
+    free(restored.last_job_on_core);
+    free(restored.pending_penalty);
+    free(restored.dispatch_penalty);
+    free(restored.core_speed);
+    free(restored.running);
+    job_pool_destroy(&restored);
+    free(jobs);
+    return -1;
+  }
+
+  restored.backfill_root = root == -1 ? NULL : jobs[root];
+  free(jobs);
+  restored.run_finish = malloc(sizeof(long long) * cores);
+  restored.run_banked = malloc(sizeof(long long) * cores);
+  restored.run_priority = malloc(sizeof(int) * cores);
+  restored.finish_heap = malloc(sizeof(int) * cores);
+  restored.finish_heap_slot = malloc(sizeof(int) * cores);
+  restored.finish_heap_size = 0;
+  for(int c = 0; c < cores; c++)
+  {
+    restored.finish_heap_slot[c] = -1;
+  }
+  *state = restored;
+  for(int c = 0; c < cores; c++)
+  {
+    if(state->running[c] != NULL)
+    {
+      note_running(c);
+    }
+  }
+  return 0;
 }
 
 
@@ -455,7 +3562,41 @@ float scheduler_average_response_time()
 */
 void scheduler_clean_up()
 {
-  priqueue_destroy(&queue);
+  if(state->gang)
+  {
+    //drops the stale entries left by backfilled jobs
+    gang_head();
+    free(state->gang_ends);
+  }
+  priqueue_destroy(&state->queue);
+  heap_destroy(&state->ready);
+  heap_destroy(&state->wake_heap);
+  free(state->lottery_tree);
+  free(state->lottery_jobs);
+  free(state->lottery_free_slots);
+  if(state->multiqueue)
+  {
+    for(int i = 0; i < state->num_cores; i++)
+    {
+      heap_destroy(&state->local_queues[i]);
+    }
+    free(state->local_queues);
+  }
+  free(state->pending_penalty);
+  free(state->dispatch_penalty);
+  free(state->running);
+  free(state->run_finish);
+  free(state->run_banked);
+  free(state->run_priority);
+  free(state->finish_heap);
+  free(state->finish_heap_slot);
+  free(state->last_job_on_core);
+  free(state->core_speed);
+  free(state->avail_cores);
+  dag_destroy();
+  fair_destroy();
+  //frees every job, finished or not
+  job_pool_destroy(state);
 }
 
 
@@ -473,9 +3614,68 @@ void scheduler_clean_up()
 void scheduler_show_queue()
 {
   job_t* temp;
-  for(int i = 0; i < priqueue_size(&queue);i++)
+  if(uses_ready_set())
+  {
+    for(int i = 0; i < state->num_cores; i++)
+    {
+      //a gang job is listed once, on the first of its cores
+      if(state->running[i] != NULL && state->running[i]->core_id == i)
+      {
+        printf("%d(%d) ",state->running[i]->job_id,state->running[i]->priority);
+      }
+    }
+    if(state->multiqueue)
+    {
+      for(int i = 0; i < state->num_cores; i++)
+      {
+        printf("| ");
+        for(int j = 0; j < heap_size(&state->local_queues[i]); j++)
+        {
+          temp = (job_t*)heap_at(&state->local_queues[i],j);
+          printf("%d(%d) ",temp->job_id,temp->priority);
+        }
+      }
+    }
+    else if(state->fair_share)
+    {
+      //groups with waiting jobs, in heap order
+      for(int i = 0; i < state->fair_heap_size; i++)
+      {
+        heap_t* ready = &state->groups[state->fair_heap[i]].ready;
+        printf("| ");
+        for(int j = 0; j < heap_size(ready); j++)
+        {
+          temp = (job_t*)heap_at(ready,j);
+          printf("%d(%d) ",temp->job_id,temp->priority);
+        }
+      }
+    }
+    else if(state->scheduling_scheme != LOTTERY)
+    {
+      for(int i = 0; i < heap_size(&state->ready); i++)
+      {
+        temp = (job_t*)heap_at(&state->ready,i);
+        if(!job_stats(temp)->backfilled)
+        {
+          printf("%d(%d) ",temp->job_id,temp->priority);
+        }
+      }
+    }
+    else
+    {
+      for(int i = 1; i <= state->lottery_used; i++)
+      {
+        if(state->lottery_jobs[i] != NULL)
+        {
+          printf("%d(%d) ",state->lottery_jobs[i]->job_id,state->lottery_jobs[i]->priority);
+        }
+      }
+    }
+    return;
+  }
+  for(int i = 0; i < priqueue_size(&state->queue);i++)
   {
-    temp = (job_t*)priqueue_at(&queue,i);
+    temp = (job_t*)priqueue_at(&state->queue,i);
     printf("%d(%d) ",temp->job_id,temp->priority);
   }
 }
@@ -4,24 +4,107 @@
 #ifndef LIBSCHEDULER_H_
 #define LIBSCHEDULER_H_
 
+#include <stdio.h>
+
+/**
+  Core speed that finishes one unit of running time per time unit, see
+  scheduler_set_core_speeds()
+*/
+#define CORE_SPEED_UNIT 1000
+
 /**
   Constants which represent the different scheduling algorithms
 */
-typedef enum {FCFS = 0, SJF, PSJF, PRI, PPRI, RR} scheme_t;
+typedef enum {FCFS = 0, SJF, PSJF, PRI, PPRI, RR, STRIDE, LOTTERY} scheme_t;
+
+/**
+  Where multi-queue mode puts an arriving job when no core is idle
+*/
+typedef enum {PLACE_LEAST_LOADED = 0, PLACE_ROUND_ROBIN} placement_t;
+
+/**
+  Which queue an idle core steals from in multi-queue mode
+*/
+typedef enum {STEAL_BUSIEST = 0, STEAL_RANDOM} steal_t;
+
+/**
+  One arrival passed to scheduler_new_jobs_batch()
+*/
+typedef struct _scheduler_job_spec_t
+{
+  int job_number, running_time, priority;
+} scheduler_job_spec_t;
+
+/**
+  Per-job statistics that can be asked for by percentile
+*/
+typedef enum {METRIC_WAITING = 0, METRIC_TURNAROUND, METRIC_RESPONSE} metric_t;
+
+/**
+  Completion record of one job, written to the job log as the job finishes.
+  start_time is when the job first ran and core_id the core it finished on.
+  In a binary log each record is these six ints in native byte order.
+*/
+typedef struct _scheduler_job_record_t
+{
+  int job_number, arrival_time, start_time, finish_time, preemptions, core_id;
+} scheduler_job_record_t;
+
+/**
+  A scheduler instance, see scheduler_create() and scheduler_use()
+*/
+typedef struct _scheduler_t scheduler_t;
 
-float m_waiting_time, m_turnaround_time, m_response_time;
-int num_jobs;
-int* avail_cores;//will be an array with the status (0/1) of each core
-int num_cores;
-scheme_t scheduling_scheme;
+scheduler_t* scheduler_create          ();
+void  scheduler_use                    (scheduler_t *scheduler);
+void  scheduler_destroy                (scheduler_t *scheduler);
 
 void  scheduler_start_up               (int cores, scheme_t scheme);
+void  scheduler_set_aging              (int interval);
+void  scheduler_set_multiqueue         (placement_t placement, steal_t steal, int cost);
+void  scheduler_set_switch_costs       (int context_switch, int migration);
+void  scheduler_set_core_speeds        (int *speeds);
+int   scheduler_set_gang               (int backfill);
+void  scheduler_set_io_bursts          (int enabled);
+int   scheduler_set_dependencies       (int jobs, const int *first, const int *successors);
+int   scheduler_set_fair_share         (int jobs, const int *groups, int half_life);
+void  scheduler_set_group_weight       (int group, int weight);
+void  scheduler_set_quantum            (int quantum, int granularity);
+void  scheduler_set_job_log            (FILE *log, int binary);
+int   scheduler_dispatch_penalty       (int core_id);
+int   scheduler_quantum                (int core_id);
 int   scheduler_new_job                (int job_number, int time, int running_time, int priority);
+int   scheduler_new_gang_job           (int job_number, int time, int running_time, int priority, int cores_required);
+void  scheduler_new_jobs_batch         (scheduler_job_spec_t *jobs, int count, int time, int *out_core_ids);
 int   scheduler_job_finished           (int core_id, int job_number, int time);
 int   scheduler_quantum_expired        (int core_id, int time);
+int   scheduler_job_blocked            (int core_id, int job_number, int time, int io_time, int next_running_time);
+int   scheduler_next_wake_time         ();
+int   scheduler_job_woke               (int time, int *core_id);
+int   scheduler_job_released           (int time, int *core_id);
+int   scheduler_core_job               (int core_id);
 float scheduler_average_turnaround_time();
 float scheduler_average_waiting_time   ();
 float scheduler_average_response_time  ();
+int   scheduler_percentile             (metric_t metric, double quantile);
+int   scheduler_steal_count            ();
+float scheduler_average_imbalance      ();
+int   scheduler_max_imbalance          ();
+int   scheduler_overhead_time          ();
+int   scheduler_last_quantum           ();
+float scheduler_average_quantum        ();
+int   scheduler_ready_count            ();
+int   scheduler_running_count          ();
+int   scheduler_preemption_count       ();
+int   scheduler_context_switch_count   ();
+int   scheduler_migration_count        ();
+int   scheduler_backfill_count         ();
+int   scheduler_block_count            ();
+int   scheduler_held_count             ();
+int   scheduler_group_count            ();
+float scheduler_group_waiting_time     (int group);
+int   scheduler_save                   (FILE *out);
+int   scheduler_restore                (FILE *in);
 void  scheduler_clean_up               ();
 
 void  scheduler_show_queue             ();
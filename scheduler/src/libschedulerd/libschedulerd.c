@@ -0,0 +1,151 @@
+/** @file libschedulerd.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "libschedulerd.h"
+
+
+static int socket_address(const char *path, struct sockaddr_un *address)
+{
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if(strlen(path) >= sizeof(address->sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  strcpy(address->sun_path, path);
+  return 0;
+}
+
+
+/**
+  Creates the daemon's listening socket at path, replacing any socket left
+  there by an earlier run. The socket is non-blocking.
+
+  @param path file system path of the socket
+  @return the listening file descriptor
+  @return -1 on failure, with errno set
+ */
+int schedulerd_listen(const char *path)
+{
+  struct sockaddr_un address;
+  if(socket_address(path, &address) != 0)
+  {
+    return -1;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(fd == -1)
+  {
+    return -1;
+  }
+  unlink(path);
+  if(bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+  }
+  return fd;
+}
+
+
+/**
+  Connects to a daemon listening at path.
+
+  @param path file system path of the daemon's socket
+  @return the connected file descriptor
+  @return -1 on failure, with errno set
+ */
+int schedulerd_connect(const char *path)
+{
+  struct sockaddr_un address;
+  if(socket_address(path, &address) != 0)
+  {
+    return -1;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(fd == -1)
+  {
+    return -1;
+  }
+  if(connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0)
+  {
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return -1;
+  }
+  return fd;
+}
+
+
+/**
+  Sends a batch of requests and waits for all their replies.
+
+  The requests are pipelined: replies are read while later requests are
+  still being written, so a batch of any size goes through without either
+  side's socket buffer filling up and stalling the other.
+
+  @param fd a descriptor returned by schedulerd_connect()
+  @param requests the requests to send, in order
+  @param count the number of requests
+  @param replies receives one reply per request, in the same order
+  @return 0 on success
+  @return -1 if the connection failed or was closed, with errno set
+ */
+int schedulerd_call(int fd, schedulerd_request_t *requests, int count, schedulerd_reply_t *replies)
+{
+  size_t to_send = count * sizeof(schedulerd_request_t), sent = 0;
+  size_t to_receive = count * sizeof(schedulerd_reply_t), received = 0;
+
+  while(received < to_receive)
+  {
+    struct pollfd waiting = { fd, POLLIN | (sent < to_send ? POLLOUT : 0), 0 };
+    if(poll(&waiting, 1, -1) == -1)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+
+    if(sent < to_send && (waiting.revents & POLLOUT))
+    {
+      ssize_t n = send(fd, (char*)requests + sent, to_send - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+      if(n == -1 && errno != EAGAIN && errno != EINTR)
+      {
+        return -1;
+      }
+      sent += n > 0 ? n : 0;
+    }
+
+    if(waiting.revents & (POLLIN | POLLHUP | POLLERR))
+    {
+      ssize_t n = recv(fd, (char*)replies + received, to_receive - received, MSG_DONTWAIT);
+      if(n == 0)
+      {
+        errno = ECONNRESET;
+        return -1;
+      }
+      if(n == -1 && errno != EAGAIN && errno != EINTR)
+      {
+        return -1;
+      }
+      received += n > 0 ? n : 0;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+/** @file libschedulerd.h
+ */
+
+#ifndef LIBSCHEDULERD_H_
+#define LIBSCHEDULERD_H_
+
+#include "../libscheduler/libscheduler.h"
+
+/**
+  What a schedulerd request asks for. All but SCHEDULERD_START_UP map onto
+  the libscheduler function of the same name.
+*/
+typedef enum {SCHEDULERD_START_UP = 0, SCHEDULERD_NEW_JOB, SCHEDULERD_JOB_FINISHED, SCHEDULERD_QUANTUM_EXPIRED} schedulerd_op_t;
+
+/**
+  Result of a request the daemon refused to pass to the scheduler: an
+  unknown operation, a core out of range, a job that is not on the core it
+  is said to be on, or any decision asked for before the scheduler started.
+*/
+#define SCHEDULERD_INVALID -2
+
+/**
+  A request on the wire. Both ends share a machine, so messages are these
+  fixed-size structs in native byte order. args holds the parameters of the
+  library function, in order:
+    - START_UP: cores, scheme, aging interval (0 for none)
+    - NEW_JOB: job_number, time, running_time, priority
+    - JOB_FINISHED: core_id, job_number, time
+    - QUANTUM_EXPIRED: core_id, time
+
+  Requests may be pipelined: a client can send any number before reading a
+  reply. tag is not interpreted, only echoed back.
+*/
+typedef struct _schedulerd_request_t
+{
+  int op;
+  int tag;
+  int args[4];
+} schedulerd_request_t;
+
+/**
+  The answer to one request, sent in request order: what the library
+  function returned, 0 for a START_UP, or SCHEDULERD_INVALID.
+*/
+typedef struct _schedulerd_reply_t
+{
+  int tag;
+  int result;
+} schedulerd_reply_t;
+
+
+int   schedulerd_listen       (const char *path);
+int   schedulerd_connect      (const char *path);
+int   schedulerd_call         (int fd, schedulerd_request_t *requests, int count, schedulerd_reply_t *replies);
+
+#endif /* LIBSCHEDULERD_H_ */
@@ -0,0 +1,198 @@
+/** @file libswf.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libswf.h"
+
+// Bytes read from the file at a time; a longer line grows the buffer
+#define SWF_BUFFER 65536
+// Fields in every SWF job line
+#define SWF_FIELDS 18
+
+
+/*
+ * Moves the unparsed bytes to the front of the buffer and reads more after
+ * them, growing the buffer if a single line fills it. Returns the number of
+ * bytes added, 0 at the end of the file.
+ */
+static size_t swf_fill(swf_reader_t *reader)
+{
+	if(reader->m_start > 0)
+	{
+		memmove(reader->m_buffer, reader->m_buffer + reader->m_start, reader->m_end - reader->m_start);
+		reader->m_end -= reader->m_start;
+		reader->m_start = 0;
+	}
+	if(reader->m_end == reader->m_capacity)
+	{
+		char *grown = realloc(reader->m_buffer, reader->m_capacity * 2);
+		if(grown == NULL)
+		{
+			//the line is cut short and will not parse
+			reader->m_eof = 1;
+			return 0;
+		}
+		reader->m_buffer = grown;
+		reader->m_capacity *= 2;
+	}
+	size_t added = fread(reader->m_buffer + reader->m_end, 1, reader->m_capacity - reader->m_end, reader->m_file);
+	reader->m_end += added;
+	if(added == 0)
+	{
+		reader->m_eof = 1;
+	}
+	return added;
+}
+
+/*
+ * Parses the numeric fields of one line into fields. A fractional part, as
+ * some logs write for average CPU time, is dropped. Returns the number of
+ * fields, or -1 if the line holds anything else.
+ */
+static int swf_fields(const char *line, const char *end, long long *fields)
+{
+	int count = 0;
+	while(line < end)
+	{
+		if(*line == ' ' || *line == '\t' || *line == '\r')
+		{
+			line++;
+			continue;
+		}
+		int negative = *line == '-';
+		line += negative;
+		if(line == end || *line < '0' || *line > '9')
+		{
+			return -1;
+		}
+		long long value = 0;
+		while(line < end && *line >= '0' && *line <= '9')
+		{
+			value = value * 10 + (*line++ - '0');
+		}
+		if(line < end && *line == '.')
+		{
+			for(line++; line < end && *line >= '0' && *line <= '9'; line++);
+		}
+		if(line < end && *line != ' ' && *line != '\t' && *line != '\r')
+		{
+			return -1;
+		}
+		if(count < SWF_FIELDS)
+		{
+			fields[count] = negative ? -value : value;
+		}
+		count++;
+	}
+	return count;
+}
+
+
+/**
+  Initializes the swf_reader_t data structure.
+
+  @param reader a pointer to an instance of the swf_reader_t data structure
+  @param in the stream to read the log from
+  @return 0 on success
+  @return -1 if memory could not be allocated
+ */
+int swf_open(swf_reader_t *reader, FILE *in)
+{
+	reader->m_file = in;
+	reader->m_capacity = SWF_BUFFER;
+	reader->m_buffer = malloc(reader->m_capacity);
+	reader->m_start = 0;
+	reader->m_end = 0;
+	reader->m_line = 0;
+	reader->m_eof = 0;
+	return reader->m_buffer == NULL ? -1 : 0;
+}
+
+
+/**
+  Reads the next job, skipping blank lines and the ';' comments that make up
+  the header.
+
+  @param reader a pointer to an instance of the swf_reader_t data structure
+  @param job where to store the job
+  @return 1 if a job was read
+  @return 0 at the end of the log
+  @return -1 if the line does not hold 18 numeric fields; swf_line() gives its number
+ */
+int swf_next(swf_reader_t *reader, swf_job_t *job)
+{
+	for(;;)
+	{
+		char *line = reader->m_buffer + reader->m_start;
+		char *end = memchr(line, '\n', reader->m_end - reader->m_start);
+		if(end == NULL && !reader->m_eof)
+		{
+			swf_fill(reader);
+			continue;
+		}
+		if(end == NULL)
+		{
+			//the last line may lack its newline
+			if(reader->m_start == reader->m_end)
+			{
+				return 0;
+			}
+			end = reader->m_buffer + reader->m_end;
+		}
+		reader->m_start = end - reader->m_buffer + (end < reader->m_buffer + reader->m_end);
+		reader->m_line++;
+
+		while(line < end && (*line == ' ' || *line == '\t' || *line == '\r'))
+		{
+			line++;
+		}
+		if(line == end || *line == ';')
+		{
+			continue;
+		}
+
+		long long fields[SWF_FIELDS];
+		if(swf_fields(line, end, fields) < SWF_FIELDS)
+		{
+			return -1;
+		}
+		job->job_number = fields[0];
+		job->submit_time = fields[1];
+		job->run_time = fields[3];
+		job->allocated_processors = fields[4];
+		job->requested_processors = fields[7];
+		job->status = fields[10];
+		job->user_id = fields[11];
+		job->group_id = fields[12];
+		job->queue = fields[14];
+		job->partition = fields[15];
+		return 1;
+	}
+}
+
+
+/**
+  Returns the number of the line read last, counting from 1.
+
+  @param reader a pointer to an instance of the swf_reader_t data structure
+  @return the number of lines read so far
+ */
+long long swf_line(swf_reader_t *reader)
+{
+	return reader->m_line;
+}
+
+
+/**
+  Frees the buffer. The stream itself is left open.
+
+  @param reader a pointer to an instance of the swf_reader_t data structure
+ */
+void swf_close(swf_reader_t *reader)
+{
+	free(reader->m_buffer);
+	reader->m_buffer = NULL;
+}
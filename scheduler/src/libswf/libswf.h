@@ -0,0 +1,48 @@
+/** @file libswf.h
+ */
+
+#ifndef LIBSWF_H_
+#define LIBSWF_H_
+
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+  The fields of one Standard Workload Format job that a scheduler uses.
+  SWF writes -1 for anything a log does not record.
+*/
+typedef struct _swf_job_t
+{
+  long long job_number;
+  long long submit_time;        //seconds from the start of the log
+  long long run_time;           //seconds
+  long long allocated_processors;
+  long long requested_processors;
+  long long status;             //1 completed, 0 failed, 5 cancelled, ...
+  long long user_id;
+  long long group_id;
+  long long queue;
+  long long partition;
+} swf_job_t;
+
+/**
+  Streaming reader. The file is read through m_buffer a block at a time and
+  parsed in place, so a trace of any length costs one buffer of memory.
+*/
+typedef struct _swf_reader_t
+{
+  FILE* m_file;
+  char* m_buffer;
+  size_t m_capacity;
+  size_t m_start, m_end;        //the bytes of m_buffer not parsed yet
+  long long m_line;             //lines read so far
+  int m_eof;
+} swf_reader_t;
+
+
+int       swf_open (swf_reader_t *reader, FILE *in);
+int       swf_next (swf_reader_t *reader, swf_job_t *job);
+long long swf_line (swf_reader_t *reader);
+void      swf_close(swf_reader_t *reader);
+
+#endif /* LIBSWF_H_ */
@@ -0,0 +1,272 @@
+/** @file libtelemetry.c
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "libtelemetry.h"
+
+
+static const char *telemetry_names[TELEMETRY_COLUMNS] = { "time", "ready", "running", "preemptions", "switches", "quantum" };
+
+
+static void write_csv_header(FILE *out)
+{
+	int c;
+	for(c = 0; c < TELEMETRY_COLUMNS; c++)
+	{
+		fprintf(out, c == 0 ? "%s" : ",%s", telemetry_names[c]);
+	}
+	fprintf(out, "\n");
+}
+
+/*
+ * Writes the retained samples, oldest first, as CSV rows.
+ */
+static void write_csv_rows(telemetry_t *t, FILE *out)
+{
+	int i, c;
+	for(i = 0; i < t->m_size; i++)
+	{
+		int slot = (t->m_start + i) % t->m_capacity;
+		for(c = 0; c < TELEMETRY_COLUMNS; c++)
+		{
+			fprintf(out, c == 0 ? "%d" : ",%d", t->m_columns[c][slot]);
+		}
+		fprintf(out, "\n");
+	}
+}
+
+
+/**
+  Initializes the telemetry_t data structure.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @param capacity the number of samples retained
+  @return 0 on success
+  @return -1 if memory could not be allocated
+ */
+int telemetry_init(telemetry_t *t, int capacity)
+{
+	int i;
+	t->m_capacity = capacity > 0 ? capacity : 1;
+	t->m_start = 0;
+	t->m_size = 0;
+	t->m_dropped = 0;
+	t->m_out = NULL;
+	t->m_binary = 0;
+	t->m_written = 0;
+	for(i = 0; i < TELEMETRY_COLUMNS; i++)
+	{
+		t->m_columns[i] = malloc(t->m_capacity * sizeof(int));
+	}
+	for(i = 0; i < TELEMETRY_COLUMNS; i++)
+	{
+		if(t->m_columns[i] == NULL)
+		{
+			telemetry_destroy(t);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+/**
+  Appends a sample. If the ring is full its samples are first written out
+  to the stream given to telemetry_stream(), or without one the oldest
+  sample is overwritten.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @param time the simulator time of the sample
+  @param ready jobs waiting for a core
+  @param running cores running a job
+  @param preemptions preemptions so far
+  @param switches context switches so far
+  @param quantum the time slice handed out last
+ */
+void telemetry_sample(telemetry_t *t, int time, int ready, int running, int preemptions, int switches, int quantum)
+{
+	int slot;
+	if(t->m_size == t->m_capacity && t->m_out != NULL)
+	{
+		telemetry_flush(t);
+	}
+	if(t->m_size == t->m_capacity)
+	{
+		slot = t->m_start;
+		t->m_start = (t->m_start + 1) % t->m_capacity;
+		t->m_dropped++;
+	}
+	else
+	{
+		slot = (t->m_start + t->m_size) % t->m_capacity;
+		t->m_size++;
+	}
+	t->m_columns[TELEMETRY_TIME][slot] = time;
+	t->m_columns[TELEMETRY_READY][slot] = ready;
+	t->m_columns[TELEMETRY_RUNNING][slot] = running;
+	t->m_columns[TELEMETRY_PREEMPTIONS][slot] = preemptions;
+	t->m_columns[TELEMETRY_SWITCHES][slot] = switches;
+	t->m_columns[TELEMETRY_QUANTUM][slot] = quantum;
+}
+
+
+/**
+  Returns one value of a retained sample.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @param column the column to read
+  @param index the sample, 0 being the oldest retained
+  @return the value
+  @return 0 if index is out of range
+ */
+int telemetry_at(telemetry_t *t, telemetry_column_t column, int index)
+{
+	if(index < 0 || index >= t->m_size)
+	{
+		return 0;
+	}
+	return t->m_columns[column][(t->m_start + index) % t->m_capacity];
+}
+
+
+/**
+  Returns the number of retained samples.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @return the number of retained samples
+ */
+int telemetry_size(telemetry_t *t)
+{
+	return t->m_size;
+}
+
+
+/**
+  Returns the number of samples overwritten because the ring was full.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @return the number of samples lost
+ */
+long long telemetry_dropped(telemetry_t *t)
+{
+	return t->m_dropped;
+}
+
+
+/**
+  Writes the retained samples, oldest first, as CSV with a header line.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @param out the stream to write to
+  @return 0 on success, -1 on a write error
+ */
+int telemetry_write_csv(telemetry_t *t, FILE *out)
+{
+	write_csv_header(out);
+	write_csv_rows(t, out);
+	return ferror(out) ? -1 : 0;
+}
+
+
+/**
+  Writes the retained samples in columnar binary form: two ints (column
+  count, sample count) followed by each column as a contiguous int array,
+  oldest sample first, in native byte order. A streamed ring writes one
+  such block each time it fills, so a reader takes blocks until the end of
+  the file.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @param out the stream to write to
+  @return 0 on success, -1 on a write error
+ */
+int telemetry_write_binary(telemetry_t *t, FILE *out)
+{
+	int header[2] = { TELEMETRY_COLUMNS, t->m_size };
+	int c;
+	fwrite(header, sizeof(int), 2, out);
+
+	// The ring is at most two runs per column: start..end, then 0..wrap
+	int first = t->m_capacity - t->m_start;
+	if(first > t->m_size)
+	{
+		first = t->m_size;
+	}
+	for(c = 0; c < TELEMETRY_COLUMNS; c++)
+	{
+		fwrite(t->m_columns[c] + t->m_start, sizeof(int), first, out);
+		fwrite(t->m_columns[c], sizeof(int), t->m_size - first, out);
+	}
+	return ferror(out) ? -1 : 0;
+}
+
+
+/**
+  Makes t write its samples to out, in the format of telemetry_write_csv()
+  or telemetry_write_binary(), each time the ring fills instead of
+  overwriting the oldest. Call telemetry_flush() after the last sample to
+  write the rest. A CSV header is written straight away.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @param out the stream to write to
+  @param binary 1 for the binary form, 0 for CSV
+  @return 0 on success, -1 on a write error
+ */
+int telemetry_stream(telemetry_t *t, FILE *out, int binary)
+{
+	t->m_out = out;
+	t->m_binary = binary != 0;
+	t->m_written = 0;
+	if(!binary)
+	{
+		write_csv_header(out);
+	}
+	return ferror(out) ? -1 : 0;
+}
+
+
+/**
+  Writes the samples retained since the last write to the stream given to
+  telemetry_stream() and empties the ring. A binary stream that has written
+  nothing yet still gets an empty block, so the file is never empty.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+  @return 0 on success, -1 on a write error or if t has no stream
+ */
+int telemetry_flush(telemetry_t *t)
+{
+	if(t->m_out == NULL)
+	{
+		return -1;
+	}
+	if(!t->m_binary)
+	{
+		write_csv_rows(t, t->m_out);
+	}
+	else if(t->m_size > 0 || t->m_written == 0)
+	{
+		telemetry_write_binary(t, t->m_out);
+	}
+	t->m_written += t->m_size;
+	t->m_start = 0;
+	t->m_size = 0;
+	return ferror(t->m_out) ? -1 : 0;
+}
+
+
+/**
+  Destroys and frees all the memory associated with t.
+
+  @param t a pointer to an instance of the telemetry_t data structure
+ */
+void telemetry_destroy(telemetry_t *t)
+{
+	int i;
+	for(i = 0; i < TELEMETRY_COLUMNS; i++)
+	{
+		free(t->m_columns[i]);
+		t->m_columns[i] = NULL;
+	}
+	t->m_size = 0;
+}
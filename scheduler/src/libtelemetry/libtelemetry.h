@@ -0,0 +1,54 @@
+/** @file libtelemetry.h
+ */
+
+#ifndef LIBTELEMETRY_H_
+#define LIBTELEMETRY_H_
+
+#include <stdio.h>
+
+/**
+  Columns of a telemetry sample. Preemptions and context switches are
+  running totals, so the rate over any stretch of retained samples is the
+  difference between its ends. Quantum is the time slice handed out last,
+  0 for schemes without one.
+*/
+typedef enum {TELEMETRY_TIME = 0, TELEMETRY_READY, TELEMETRY_RUNNING, TELEMETRY_PREEMPTIONS, TELEMETRY_SWITCHES, TELEMETRY_QUANTUM,
+              TELEMETRY_COLUMNS} telemetry_column_t;
+
+/**
+  Fixed-capacity ring of samples stored column by column.
+
+  Each column is its own int array, so a sample costs TELEMETRY_COLUMNS ints
+  and a column can be scanned or written out contiguously. Once the ring is
+  full the oldest sample is overwritten; m_dropped counts how many were lost.
+  A ring given a stream with telemetry_stream() instead writes its samples
+  out whenever it fills, and loses none.
+*/
+typedef struct _telemetry_t
+{
+  int* m_columns[TELEMETRY_COLUMNS];
+  int m_capacity;
+  int m_start;
+  int m_size;
+  long long m_dropped;
+  FILE* m_out;                  //stream full rings are written to, or NULL
+  int m_binary;
+  long long m_written;          //samples written to m_out so far
+} telemetry_t;
+
+
+int       telemetry_init        (telemetry_t *t, int capacity);
+
+void      telemetry_sample      (telemetry_t *t, int time, int ready, int running, int preemptions, int switches, int quantum);
+int       telemetry_at          (telemetry_t *t, telemetry_column_t column, int index);
+int       telemetry_size        (telemetry_t *t);
+long long telemetry_dropped     (telemetry_t *t);
+
+int       telemetry_write_csv   (telemetry_t *t, FILE *out);
+int       telemetry_write_binary(telemetry_t *t, FILE *out);
+int       telemetry_stream      (telemetry_t *t, FILE *out, int binary);
+int       telemetry_flush       (telemetry_t *t);
+
+void      telemetry_destroy     (telemetry_t *t);
+
+#endif /* LIBTELEMETRY_H_ */
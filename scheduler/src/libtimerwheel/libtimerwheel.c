@@ -0,0 +1,296 @@
+/** @file libtimerwheel.c
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+
+#include "libtimerwheel.h"
+
+
+static int timerwheel_span(int level)
+{
+	return 1 << (TIMERWHEEL_BITS * level);
+}
+
+static void timerwheel_link(timerwheel_entry_t *head, timerwheel_entry_t *e)
+{
+	e->m_prev = head->m_prev;
+	e->m_next = head;
+	head->m_prev->m_next = e;
+	head->m_prev = e;
+}
+
+static void timerwheel_unlink(timerwheel_entry_t *e)
+{
+	e->m_prev->m_next = e->m_next;
+	e->m_next->m_prev = e->m_prev;
+	e->m_next = NULL;
+	e->m_prev = NULL;
+}
+
+/*
+ * Files e under the lowest level whose span still reaches its deadline,
+ * measured from the next time unit the wheel will process.
+ */
+static void timerwheel_place(timerwheel_t *w, timerwheel_entry_t *e)
+{
+	int key = e->m_deadline;
+	int level;
+
+	if(key < w->m_now)
+	{
+		key = w->m_now;
+	}
+
+	for(level = 0; level < TIMERWHEEL_LEVELS - 1; level++)
+	{
+		if(key - w->m_now < timerwheel_span(level + 1))
+		{
+			break;
+		}
+	}
+
+	if(level == TIMERWHEEL_LEVELS - 1 && key - w->m_now >= timerwheel_span(TIMERWHEEL_LEVELS))
+	{
+		key = w->m_now + timerwheel_span(TIMERWHEEL_LEVELS) - 1;
+	}
+
+	int slot = (key >> (TIMERWHEEL_BITS * level)) & (TIMERWHEEL_SLOTS - 1);
+	timerwheel_link(&w->m_slots[level][slot], e);
+}
+
+/*
+ * Re-files everything in one slot of a higher level now that the wheel has
+ * reached the start of that slot's range.
+ */
+static void timerwheel_cascade(timerwheel_t *w, int level, int slot)
+{
+	timerwheel_entry_t *head = &w->m_slots[level][slot];
+
+	if(head->m_next == head)
+	{
+		return;
+	}
+
+	timerwheel_entry_t *first = head->m_next;
+	timerwheel_entry_t *last = head->m_prev;
+	head->m_next = head;
+	head->m_prev = head;
+	last->m_next = NULL;
+
+	while(first != NULL)
+	{
+		timerwheel_entry_t *next = first->m_next;
+		timerwheel_place(w, first);
+		first = next;
+	}
+}
+
+
+/**
+  Initializes the timerwheel_t data structure.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param now the first time unit timerwheel_advance() will process
+ */
+void timerwheel_init(timerwheel_t *w, int now)
+{
+	int level, slot;
+	for(level = 0; level < TIMERWHEEL_LEVELS; level++)
+	{
+		for(slot = 0; slot < TIMERWHEEL_SLOTS; slot++)
+		{
+			w->m_slots[level][slot].m_next = &w->m_slots[level][slot];
+			w->m_slots[level][slot].m_prev = &w->m_slots[level][slot];
+		}
+	}
+	w->m_now = now;
+	w->m_size = 0;
+}
+
+
+/**
+  Initializes a timer so it can be armed. Must be called once before the
+  first timerwheel_arm().
+
+  @param e a pointer to the timer
+  @param data caller data returned with the timer when it expires
+ */
+void timerwheel_entry_init(timerwheel_entry_t *e, void *data)
+{
+	e->m_next = NULL;
+	e->m_prev = NULL;
+	e->m_deadline = 0;
+	e->m_data = data;
+}
+
+
+/**
+  Arms e to expire at deadline, re-arming it if it is already pending. A
+  deadline that has already passed expires on the next timerwheel_advance().
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param e a pointer to the timer
+  @param deadline time unit at which e expires
+ */
+void timerwheel_arm(timerwheel_t *w, timerwheel_entry_t *e, int deadline)
+{
+	if(timerwheel_pending(e))
+	{
+		timerwheel_unlink(e);
+		w->m_size--;
+	}
+	e->m_deadline = deadline;
+	timerwheel_place(w, e);
+	w->m_size++;
+}
+
+
+/**
+  Disarms e.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param e a pointer to the timer
+  @return 1 if e was pending
+  @return 0 if e was not armed
+ */
+int timerwheel_cancel(timerwheel_t *w, timerwheel_entry_t *e)
+{
+	if(!timerwheel_pending(e))
+	{
+		return 0;
+	}
+	timerwheel_unlink(e);
+	w->m_size--;
+	return 1;
+}
+
+
+/**
+  Tests whether e is armed and has not yet expired.
+
+  @param e a pointer to the timer
+  @return 1 if e is pending, 0 otherwise
+ */
+int timerwheel_pending(timerwheel_entry_t *e)
+{
+	return e->m_prev != NULL;
+}
+
+
+/**
+  Turns the wheel through every time unit up to and including now and
+  returns the timers that expired, linked through m_next in deadline order
+  (timers sharing a deadline come back in the order they were armed, unless
+  they were cascaded from different levels). Expired timers are no longer
+  pending, so the caller may re-arm them while walking the list as long as
+  it reads m_next first.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @param now the last time unit to process
+  @return the first expired timer
+  @return NULL if no timer expired
+ */
+timerwheel_entry_t *timerwheel_advance(timerwheel_t *w, int now)
+{
+	timerwheel_entry_t *expired = NULL;
+	timerwheel_entry_t **tail = &expired;
+
+	while(w->m_now <= now)
+	{
+		int level;
+
+		if(w->m_size == 0)
+		{
+			// Nothing to cascade or expire, so jump straight to the end
+			w->m_now = now + 1;
+			break;
+		}
+
+		for(level = TIMERWHEEL_LEVELS - 1; level > 0; level--)
+		{
+			if((w->m_now & (timerwheel_span(level) - 1)) == 0)
+			{
+				timerwheel_cascade(w, level, (w->m_now >> (TIMERWHEEL_BITS * level)) & (TIMERWHEEL_SLOTS - 1));
+			}
+		}
+
+		timerwheel_entry_t *head = &w->m_slots[0][w->m_now & (TIMERWHEEL_SLOTS - 1)];
+		while(head->m_next != head)
+		{
+			timerwheel_entry_t *e = head->m_next;
+			timerwheel_unlink(e);
+			w->m_size--;
+			*tail = e;
+			tail = &e->m_next;
+		}
+
+		w->m_now++;
+	}
+
+	return expired;
+}
+
+
+/**
+  Returns the earliest deadline among the pending timers, letting an
+  event-driven caller jump straight to the next expiry instead of stepping
+  one time unit at a time. Costs at most one pass over each level's slots.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @return the earliest pending deadline (never earlier than the next time unit to be processed)
+  @return INT_MAX if no timer is pending
+ */
+int timerwheel_next_deadline(timerwheel_t *w)
+{
+	int best = INT_MAX;
+	int level, i;
+
+	for(level = 0; level < TIMERWHEEL_LEVELS; level++)
+	{
+		int shift = TIMERWHEEL_BITS * level;
+		int start = (w->m_now >> shift) & (TIMERWHEEL_SLOTS - 1);
+
+		// Slots are visited in the order the wheel will reach them, so the
+		// first occupied one holds this level's earliest deadline. The
+		// current slot is the exception: past its cascade point it can only
+		// hold timers a full turn away, so keep looking after it.
+		for(i = 0; i < TIMERWHEEL_SLOTS; i++)
+		{
+			timerwheel_entry_t *head = &w->m_slots[level][(start + i) & (TIMERWHEEL_SLOTS - 1)];
+			timerwheel_entry_t *e;
+
+			if(head->m_next == head)
+			{
+				continue;
+			}
+
+			for(e = head->m_next; e != head; e = e->m_next)
+			{
+				int deadline = e->m_deadline < w->m_now ? w->m_now : e->m_deadline;
+				if(deadline < best)
+				{
+					best = deadline;
+				}
+			}
+			if(i > 0)
+			{
+				break;
+			}
+		}
+	}
+
+	return best;
+}
+
+
+/**
+  Returns the number of pending timers.
+
+  @param w a pointer to an instance of the timerwheel_t data structure
+  @return the number of pending timers
+ */
+int timerwheel_size(timerwheel_t *w)
+{
+	return w->m_size;
+}
@@ -0,0 +1,54 @@
+/** @file libtimerwheel.h
+ */
+
+#ifndef LIBTIMERWHEEL_H_
+#define LIBTIMERWHEEL_H_
+
+#define TIMERWHEEL_BITS 6
+#define TIMERWHEEL_SLOTS (1 << TIMERWHEEL_BITS)
+#define TIMERWHEEL_LEVELS 4
+
+/**
+  A timer armed on a timerwheel_t. Entries are owned by the caller (usually
+  embedded in or indexed alongside the object they time) so arming and
+  cancelling never allocate.
+*/
+typedef struct _timerwheel_entry_t
+{
+  struct _timerwheel_entry_t *m_next;
+  struct _timerwheel_entry_t *m_prev;
+  int m_deadline;
+  void *m_data;
+} timerwheel_entry_t;
+
+/**
+  Hierarchical timing wheel keyed on integer time units.
+
+  Level 0 has one slot per time unit for the next TIMERWHEEL_SLOTS units;
+  each higher level covers TIMERWHEEL_SLOTS times the span of the level
+  below and is cascaded down as the wheel turns. Arming and cancelling are
+  O(1), and advancing by one unit touches only the timers that expire (plus
+  an occasional cascade), independent of how many timers are pending.
+  Deadlines beyond the top level's span are parked in its last slot and
+  re-filed as the wheel catches up.
+*/
+typedef struct _timerwheel_t
+{
+  timerwheel_entry_t m_slots[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+  int m_now;
+  int m_size;
+} timerwheel_t;
+
+
+void   timerwheel_init         (timerwheel_t *w, int now);
+void   timerwheel_entry_init   (timerwheel_entry_t *e, void *data);
+
+void   timerwheel_arm          (timerwheel_t *w, timerwheel_entry_t *e, int deadline);
+int    timerwheel_cancel       (timerwheel_t *w, timerwheel_entry_t *e);
+int    timerwheel_pending      (timerwheel_entry_t *e);
+
+timerwheel_entry_t * timerwheel_advance(timerwheel_t *w, int now);
+int    timerwheel_next_deadline(timerwheel_t *w);
+int    timerwheel_size         (timerwheel_t *w);
+
+#endif /* LIBTIMERWHEEL_H_ */
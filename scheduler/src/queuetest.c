@@ -16,6 +16,58 @@ int compare2(const void * a, const void * b)
 	return ( *(int*)b - *(int*)a );
 }
 
+/* An element whose key can tie with another's. */
+typedef struct
+{
+	int key, id;
+} keyed_t;
+
+int compare_keys(const void * a, const void * b)
+{
+	return ( ((keyed_t*)a)->key - ((keyed_t*)b)->key );
+}
+
+/* Like the scheduler's comparers: equal keys compare as less either way. */
+int compare_keys_fcfs(const void * a, const void * b)
+{
+	int diff = ((keyed_t*)a)->key - ((keyed_t*)b)->key;
+	return diff == 0 ? -1 : diff;
+}
+
+/* Queues queued, then offers batch one element at a time into one queue and
+   all at once into another; prints the ids of the batch-offered queue and
+   returns whether both queues hold the same elements in the same order. */
+int offer_all_matches(int (*comparer)(const void *, const void *), keyed_t *queued, int queued_count, keyed_t *batch, int batch_count)
+{
+	priqueue_t one, all;
+	void *ptrs[16];
+	int i, same;
+
+	priqueue_init(&one, comparer);
+	priqueue_init(&all, comparer);
+	for (i = 0; i < queued_count; i++)
+	{
+		priqueue_offer(&one, &queued[i]);
+		priqueue_offer(&all, &queued[i]);
+	}
+	for (i = 0; i < batch_count; i++)
+	{
+		priqueue_offer(&one, &batch[i]);
+		ptrs[i] = &batch[i];
+	}
+	priqueue_offer_all(&all, ptrs, batch_count);
+
+	same = priqueue_size(&one) == priqueue_size(&all);
+	for (i = 0; i < priqueue_size(&all); i++)
+	{
+		printf("%d ", ((keyed_t *)priqueue_at(&all, i))->id);
+		same = same && priqueue_at(&one, i) == priqueue_at(&all, i);
+	}
+	priqueue_destroy(&one);
+	priqueue_destroy(&all);
+	return same;
+}
+
 int main()
 {
 	priqueue_t q, q2;
@@ -65,10 +117,57 @@ int main()
 		printf("%d ", *((int *)priqueue_at(&q2, i)) );
 	printf("\n");
 
+	/* Offer several values in one pass. */
+	priqueue_t q3;
+	priqueue_init(&q3, compare1);
+	priqueue_offer(&q3, &values[15]);
+	void *batch[] = { &values[30], &values[10], &values[20], &values[10] };
+	priqueue_offer_all(&q3, batch, 4);
+
+	printf("Elements in batch-offered queue (expected 10 10 15 20 30): ");
+	for (i = 0; i < priqueue_size(&q3); i++)
+		printf("%d ", *((int *)priqueue_at(&q3, i)) );
+	printf("\n");
+
+	/* Equal keys keep their offer order, behind equal keys already queued. */
+	keyed_t queued[] = { {2, 0}, {5, 1}, {5, 2}, {9, 3} };
+	keyed_t keyed[] = { {5, 4}, {1, 5}, {5, 6}, {9, 7}, {2, 8}, {5, 9} };
+	int same, failed = 0;
+
+	printf("Ids in batch-offered queue (expected 5 0 8 1 2 4 6 9 3 7): ");
+	same = offer_all_matches(compare_keys, queued, 4, keyed, 6);
+	printf("\nSame as offering one at a time: %d (expected 1).\n", same);
+	failed = failed || !same;
+
+	printf("Ids in batch-offered queue, ties as less (expected 5 0 8 1 2 4 6 9 3 7): ");
+	same = offer_all_matches(compare_keys_fcfs, queued, 4, keyed, 6);
+	printf("\nSame as offering one at a time: %d (expected 1).\n", same);
+	failed = failed || !same;
+
+	printf("Ids in batch-offered empty queue (expected 5 8 4 6 9 7): ");
+	same = offer_all_matches(compare_keys, queued, 0, keyed, 6);
+	printf("\nSame as offering one at a time: %d (expected 1).\n", same);
+	failed = failed || !same;
+
+	/* Rebuild a queue in a saved order, whatever the comparer says. */
+	priqueue_t q4;
+	void *saved[5];
+	int saved_count = priqueue_to_array(&q3, saved);
+	priqueue_init(&q4, compare1);
+	priqueue_append_all(&q4, saved + 3, saved_count - 3);
+	priqueue_append_all(&q4, saved, 3);
+
+	printf("Elements in appended queue (expected 20 30 10 10 15): ");
+	for (i = 0; i < priqueue_size(&q4); i++)
+		printf("%d ", *((int *)priqueue_at(&q4, i)) );
+	printf("\n");
+
+	priqueue_destroy(&q4);
+	priqueue_destroy(&q3);
 	priqueue_destroy(&q2);
 	priqueue_destroy(&q);
 
 	free(values);
 
-	return 0;
+	return failed;
 }
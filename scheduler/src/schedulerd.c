@@ -0,0 +1,314 @@
+/** @file schedulerd.c
+ */
+
+#define _GNU_SOURCE  // accept4()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "libscheduler/libscheduler.h"
+#include "libschedulerd/libschedulerd.h"
+
+/*
+ * Scheduling daemon: one scheduler instance served over a Unix domain socket.
+ *
+ * A single thread multiplexes every client with epoll. All the complete
+ * requests one read brings in are decided back to back and their replies
+ * leave in one send, so a pipelining client pays a round of system calls per
+ * batch rather than per decision. Clients share the one scheduler; the
+ * daemon serializes their requests but does not keep their jobs apart.
+ */
+
+#define MAX_EVENTS 64
+#define READ_REQUESTS 4096  // requests taken per read
+#define OUTPUT_LIMIT (1 << 20)  // bytes of unsent replies at which a client stops being read
+
+typedef struct _client_t
+{
+	int fd, events;
+	schedulerd_request_t input[READ_REQUESTS];
+	size_t input_length;  // bytes in input, the tail possibly a partial request
+	char *output;
+	size_t output_length, output_sent, output_capacity;
+} client_t;
+
+static int epoll_fd;
+static int cores;  // of the current scheduler, 0 until one is started
+static scheduler_t *scheduler;
+static volatile sig_atomic_t stopping;
+static long long served, connections;
+
+static void stop(int signal_number)
+{
+	stopping = 1;
+}
+
+static int parse_scheme(const char *name)
+{
+	if (strcasecmp(name, "FCFS") == 0) return FCFS;
+	if (strcasecmp(name, "SJF") == 0) return SJF;
+	if (strcasecmp(name, "PSJF") == 0) return PSJF;
+	if (strcasecmp(name, "PRI") == 0) return PRI;
+	if (strcasecmp(name, "PPRI") == 0) return PPRI;
+	if (strncasecmp(name, "RR", 2) == 0) return RR;
+	if (strncasecmp(name, "STRIDE", 6) == 0) return STRIDE;
+	if (strncasecmp(name, "LOTTERY", 7) == 0) return LOTTERY;
+	return -1;
+}
+
+/*
+ * Replaces the scheduler with a fresh instance, so nothing a previous
+ * START_UP configured carries over.
+ */
+static void start_up(int core_count, int scheme, int aging)
+{
+	if (scheduler != NULL)
+	{
+		scheduler_clean_up();
+		scheduler_destroy(scheduler);
+	}
+	scheduler = scheduler_create();
+	scheduler_use(scheduler);
+	scheduler_start_up(core_count, scheme);
+	scheduler_set_aging(aging);
+	cores = core_count;
+}
+
+/*
+ * Passes one request to the scheduler. Anything that would leave it in an
+ * inconsistent state is refused rather than decided.
+ */
+static int decide(schedulerd_request_t *request)
+{
+	int *args = request->args;
+	switch (request->op)
+	{
+		case SCHEDULERD_START_UP:
+			if (args[0] <= 0 || args[1] < FCFS || args[1] > LOTTERY || args[2] < 0)
+				return SCHEDULERD_INVALID;
+			start_up(args[0], args[1], args[2]);
+			return 0;
+
+		case SCHEDULERD_NEW_JOB:
+			if (cores == 0 || args[0] < 0 || args[2] <= 0)
+				return SCHEDULERD_INVALID;
+			return scheduler_new_job(args[0], args[1], args[2], args[3]);
+
+		case SCHEDULERD_JOB_FINISHED:
+			if (cores == 0 || args[0] < 0 || args[0] >= cores || scheduler_core_job(args[0]) != args[1])
+				return SCHEDULERD_INVALID;
+			return scheduler_job_finished(args[0], args[1], args[2]);
+
+		case SCHEDULERD_QUANTUM_EXPIRED:
+			if (cores == 0 || args[0] < 0 || args[0] >= cores || scheduler_core_job(args[0]) == -1)
+				return SCHEDULERD_INVALID;
+			return scheduler_quantum_expired(args[0], args[1]);
+	}
+	return SCHEDULERD_INVALID;
+}
+
+static void close_client(client_t *client)
+{
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, client->fd, NULL);
+	close(client->fd);
+	free(client->output);
+	free(client);
+}
+
+/*
+ * Sends as many pending replies as the socket takes, then asks epoll for
+ * whatever the client needs next: room to send the rest, and more requests
+ * only while the replies owed to it stay under OUTPUT_LIMIT.
+ */
+static int flush_client(client_t *client)
+{
+	while (client->output_sent < client->output_length)
+	{
+		ssize_t n = send(client->fd, client->output + client->output_sent,
+				client->output_length - client->output_sent, MSG_NOSIGNAL);
+		if (n == -1)
+		{
+			if (errno == EAGAIN)
+				break;
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		client->output_sent += n;
+	}
+	if (client->output_sent == client->output_length)
+		client->output_sent = client->output_length = 0;
+
+	size_t owed = client->output_length - client->output_sent;
+	int events = (owed < OUTPUT_LIMIT ? EPOLLIN : 0) | (owed > 0 ? EPOLLOUT : 0);
+	if (events != client->events)
+	{
+		struct epoll_event event = { .events = events, .data.ptr = client };
+		epoll_ctl(epoll_fd, EPOLL_CTL_MOD, client->fd, &event);
+		client->events = events;
+	}
+	return 0;
+}
+
+/*
+ * Reads requests until the socket runs dry, deciding each complete one, and
+ * then sends all their replies together.
+ */
+static int read_client(client_t *client)
+{
+	while (client->output_length - client->output_sent < OUTPUT_LIMIT)
+	{
+		char *input = (char *)client->input;
+		ssize_t n = recv(client->fd, input + client->input_length, sizeof(client->input) - client->input_length, 0);
+		if (n == 0)
+			return -1;
+		if (n == -1)
+		{
+			if (errno == EAGAIN)
+				break;
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		client->input_length += n;
+
+		size_t complete = client->input_length / sizeof(schedulerd_request_t);
+		size_t needed = client->output_length + complete * sizeof(schedulerd_reply_t);
+		if (needed > client->output_capacity)
+		{
+			client->output_capacity = needed * 2;
+			client->output = realloc(client->output, client->output_capacity);
+		}
+
+		schedulerd_reply_t *replies = (schedulerd_reply_t *)(client->output + client->output_length);
+		size_t i;
+		for (i = 0; i < complete; i++)
+		{
+			replies[i].tag = client->input[i].tag;
+			replies[i].result = decide(&client->input[i]);
+		}
+		client->output_length = needed;
+		served += complete;
+
+		// Keep the partial request, if any, for the next read
+		client->input_length -= complete * sizeof(schedulerd_request_t);
+		memmove(input, input + complete * sizeof(schedulerd_request_t), client->input_length);
+	}
+	return flush_client(client);
+}
+
+static void accept_clients(int listen_fd)
+{
+	for (;;)
+	{
+		int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd == -1)
+			return;
+
+		client_t *client = calloc(1, sizeof(client_t));
+		client->fd = fd;
+		client->events = EPOLLIN;
+		struct epoll_event event = { .events = EPOLLIN, .data.ptr = client };
+		epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+		connections++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int c, core_count = 0, scheme = -1, aging = 0;
+
+	while ((c = getopt(argc, argv, "c:s:a:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': core_count = atoi(optarg); break;
+			case 's': scheme = parse_scheme(optarg); break;
+			case 'a': aging = atoi(optarg); break;
+			default:
+				fprintf(stderr, "Usage: %s [-c <cores> -s <scheme> [-a <aging interval>]] <socket path>\n", argv[0]);
+				fprintf(stderr, "Without -c and -s, clients must send SCHEDULERD_START_UP before anything else.\n");
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || (core_count != 0) != (scheme != -1) || core_count < 0 || aging < 0)
+	{
+		fprintf(stderr, "Usage: %s [-c <cores> -s <scheme> [-a <aging interval>]] <socket path>\n", argv[0]);
+		return 1;
+	}
+	const char *path = argv[optind];
+
+	if (core_count > 0)
+		start_up(core_count, scheme, aging);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stop;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	int listen_fd = schedulerd_listen(path);
+	if (listen_fd == -1)
+	{
+		fprintf(stderr, "Unable to listen on \"%s\": %s\n", path, strerror(errno));
+		return 2;
+	}
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = NULL };
+	epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+
+	printf("Listening on %s\n", path);
+	fflush(stdout);
+
+	struct epoll_event events[MAX_EVENTS];
+	while (!stopping)
+	{
+		int ready = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+		if (ready == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("epoll_wait");
+			break;
+		}
+
+		int i;
+		for (i = 0; i < ready; i++)
+		{
+			client_t *client = events[i].data.ptr;
+			if (client == NULL)
+			{
+				accept_clients(listen_fd);
+				continue;
+			}
+
+			int status = 0;
+			if (events[i].events & EPOLLOUT)
+				status = flush_client(client);
+			if (status == 0 && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+				status = read_client(client);
+			if (status != 0)
+				close_client(client);
+		}
+	}
+
+	printf("Served %lld request(s) over %lld connection(s)\n", served, connections);
+
+	close(listen_fd);
+	close(epoll_fd);
+	unlink(path);
+	if (scheduler != NULL)
+	{
+		scheduler_clean_up();
+		scheduler_destroy(scheduler);
+	}
+	return 0;
+}
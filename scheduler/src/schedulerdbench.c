@@ -0,0 +1,291 @@
+/** @file schedulerdbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libscheduler/libscheduler.h"
+#include "libschedulerd/libschedulerd.h"
+#include "libhistogram/libhistogram.h"
+
+/*
+ * Load generator for schedulerd.
+ *
+ * Replays a synthetic workload the way the simulator would, but asks the
+ * daemon for every decision. All the requests of one time unit (finishes,
+ * then quantum expiries, then arrivals) go out as one pipelined batch, since
+ * none of them depends on another's reply, split into calls of at most
+ * <depth> requests. With -V every request is also put to an in-process
+ * scheduler and the two decisions are compared.
+ */
+
+typedef struct _bench_core_t
+{
+	int job;  // -1 when idle
+	int finish, quantum;  // times the job runs out of work and of its time slice
+} bench_core_t;
+
+static unsigned long long rng = 0x9E3779B97F4A7C15ULL;
+
+static unsigned int next_random()
+{
+	rng ^= rng >> 12;
+	rng ^= rng << 25;
+	rng ^= rng >> 27;
+	return (unsigned int)((rng * 2685821657736338717ULL) >> 32);
+}
+
+static long long now_ns()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * What the library itself decides for a request, for -V.
+ */
+static int decide_locally(schedulerd_request_t *request)
+{
+	int *args = request->args;
+	switch (request->op)
+	{
+		case SCHEDULERD_NEW_JOB: return scheduler_new_job(args[0], args[1], args[2], args[3]);
+		case SCHEDULERD_JOB_FINISHED: return scheduler_job_finished(args[0], args[1], args[2]);
+		case SCHEDULERD_QUANTUM_EXPIRED: return scheduler_quantum_expired(args[0], args[1]);
+	}
+	return 0;
+}
+
+static void start_job(bench_core_t *core, int job, int *remaining, int time, int quantum)
+{
+	core->job = job;
+	core->finish = time + remaining[job];
+	core->quantum = quantum > 0 ? time + quantum : -1;
+}
+
+static void stop_job(bench_core_t *core, int *remaining, int time)
+{
+	remaining[core->job] = core->finish - time;
+	core->job = -1;
+}
+
+static void usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> [-n <jobs>] [-r <arrivals per time unit>] [-p <depth>] [-V] <socket path>\n", program_name);
+	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#, stride#, lottery#\n");
+	fprintf(stderr, "-r <rate> submits <rate> jobs per time unit (default cores / 8), sized to keep the cores about 80%% busy\n");
+	fprintf(stderr, "-p <depth> caps the requests in flight per call (default 256; 1 disables pipelining)\n");
+	fprintf(stderr, "-V checks every decision against an in-process scheduler\n");
+}
+
+int main(int argc, char **argv)
+{
+	int c, cores = 0, scheme = -1, quantum = 0, jobs = 100000, rate = 0, depth = 256, verify = 0;
+
+	while ((c = getopt(argc, argv, "c:s:n:r:p:V")) != -1)
+	{
+		switch (c)
+		{
+			case 'c': cores = atoi(optarg); break;
+			case 's':
+				if (strcasecmp(optarg, "FCFS") == 0) { scheme = FCFS; }
+				else if (strcasecmp(optarg, "SJF") == 0) { scheme = SJF; }
+				else if (strcasecmp(optarg, "PSJF") == 0) { scheme = PSJF; }
+				else if (strcasecmp(optarg, "PRI") == 0) { scheme = PRI; }
+				else if (strcasecmp(optarg, "PPRI") == 0) { scheme = PPRI; }
+				else if (strncasecmp(optarg, "RR", 2) == 0) { scheme = RR; quantum = atoi(optarg + 2); }
+				else if (strncasecmp(optarg, "STRIDE", 6) == 0) { scheme = STRIDE; quantum = atoi(optarg + 6); }
+				else if (strncasecmp(optarg, "LOTTERY", 7) == 0) { scheme = LOTTERY; quantum = atoi(optarg + 7); }
+				break;
+			case 'n': jobs = atoi(optarg); break;
+			case 'r': rate = atoi(optarg); break;
+			case 'p': depth = atoi(optarg); break;
+			case 'V': verify = 1; break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || cores <= 0 || scheme == -1 || jobs <= 0 || rate < 0 || depth <= 0 ||
+			((scheme == RR || scheme == STRIDE || scheme == LOTTERY) && quantum <= 0))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+	if (rate == 0)
+		rate = cores > 8 ? cores / 8 : 1;
+
+	// Run times average about 0.8 * cores / rate, keeping the cores ~80% busy so the queue stays bounded
+	int longest = 8 * cores / (5 * rate);
+	if (longest < 1)
+		longest = 1;
+
+	int fd = schedulerd_connect(argv[optind]);
+	if (fd == -1)
+	{
+		fprintf(stderr, "Unable to connect to \"%s\": %s\n", argv[optind], strerror(errno));
+		return 2;
+	}
+
+	schedulerd_request_t *requests = malloc((cores * 2 + rate) * sizeof(schedulerd_request_t));
+	schedulerd_reply_t *replies = malloc((cores * 2 + rate) * sizeof(schedulerd_reply_t));
+	bench_core_t *core = malloc(cores * sizeof(bench_core_t));
+	int *remaining = malloc(jobs * sizeof(int));
+	int i;
+
+	requests[0].op = SCHEDULERD_START_UP;
+	requests[0].tag = 0;
+	requests[0].args[0] = cores;
+	requests[0].args[1] = scheme;
+	requests[0].args[2] = 0;
+	if (schedulerd_call(fd, requests, 1, replies) != 0 || replies[0].result != 0)
+	{
+		fprintf(stderr, "The daemon refused to start a scheduler with %d core(s).\n", cores);
+		return 2;
+	}
+	if (verify)
+		scheduler_start_up(cores, scheme);
+
+	for (i = 0; i < cores; i++)
+		core[i].job = -1;
+
+	histogram_t latency;
+	histogram_init(&latency);
+	long long decisions = 0, calls = 0, mismatches = 0, invalid = 0, local_ns = 0;
+	int next_job = 0, running = 0, time = 0;
+
+	long long start = now_ns();
+	while (next_job < jobs || running > 0)
+	{
+		// Build the time unit's batch in the order the simulator handles events
+		int count = 0;
+		for (i = 0; i < cores; i++)
+		{
+			if (core[i].job != -1 && core[i].finish == time)
+			{
+				schedulerd_request_t *request = &requests[count++];
+				request->op = SCHEDULERD_JOB_FINISHED;
+				request->tag = i;
+				request->args[0] = i;
+				request->args[1] = core[i].job;
+				request->args[2] = time;
+			}
+		}
+		for (i = 0; i < cores; i++)
+		{
+			if (core[i].job != -1 && core[i].finish != time && core[i].quantum == time)
+			{
+				schedulerd_request_t *request = &requests[count++];
+				request->op = SCHEDULERD_QUANTUM_EXPIRED;
+				request->tag = i;
+				request->args[0] = i;
+				request->args[1] = time;
+			}
+		}
+		for (i = 0; i < rate && next_job < jobs; i++, next_job++)
+		{
+			schedulerd_request_t *request = &requests[count++];
+			remaining[next_job] = 1 + next_random() % longest;
+			request->op = SCHEDULERD_NEW_JOB;
+			request->tag = next_job;
+			request->args[0] = next_job;
+			request->args[1] = time;
+			request->args[2] = remaining[next_job];
+			request->args[3] = 1 + next_random() % 8;
+		}
+
+		for (i = 0; i < count; i += depth)
+		{
+			int chunk = count - i < depth ? count - i : depth;
+			long long sent = now_ns();
+			if (schedulerd_call(fd, requests + i, chunk, replies + i) != 0)
+			{
+				fprintf(stderr, "Lost the connection to the daemon: %s\n", strerror(errno));
+				return 2;
+			}
+			long long elapsed = now_ns() - sent;
+			histogram_record(&latency, elapsed > 0x7fffffff ? 0x7fffffff : (int)elapsed);
+			calls++;
+		}
+		decisions += count;
+
+		if (verify)
+		{
+			long long local_start = now_ns();
+			for (i = 0; i < count; i++)
+			{
+				if (decide_locally(&requests[i]) != replies[i].result)
+					mismatches++;
+			}
+			local_ns += now_ns() - local_start;
+		}
+
+		// Apply the decisions, in order, to the cores
+		for (i = 0; i < count; i++)
+		{
+			schedulerd_request_t *request = &requests[i];
+			int result = replies[i].result;
+			if (result == SCHEDULERD_INVALID || replies[i].tag != request->tag)
+			{
+				invalid++;
+				continue;
+			}
+
+			if (request->op == SCHEDULERD_NEW_JOB)
+			{
+				running++;
+				if (result < 0 || result >= cores)
+					continue;
+				if (core[result].job != -1)
+					stop_job(&core[result], remaining, time);
+				start_job(&core[result], request->args[0], remaining, time, quantum);
+				continue;
+			}
+
+			bench_core_t *target = &core[request->args[0]];
+			if (request->op == SCHEDULERD_JOB_FINISHED)
+			{
+				target->job = -1;
+				running--;
+			}
+			else
+				stop_job(target, remaining, time);
+			if (result >= 0 && result < jobs)
+				start_job(target, result, remaining, time, quantum);
+		}
+
+		if (invalid > 0)
+		{
+			fprintf(stderr, "The daemon refused %lld request(s) at time %d.\n", invalid, time);
+			return 3;
+		}
+		time++;
+	}
+	double seconds = (now_ns() - start) / 1e9;
+
+	printf("Replayed %d job(s) on %d core(s), %d arrival(s) per time unit, up to %d request(s) per call\n\n", jobs, cores, rate, depth);
+	printf("Decisions: %lld in %.3f s (%.0f decisions/sec)\n", decisions, seconds, decisions / seconds);
+	printf("Calls: %lld (%.1f decisions per call)\n", calls, (double)decisions / calls);
+	printf("Call latency p50/p90/p99/p99.9 (us): %.1f / %.1f / %.1f / %.1f\n",
+			histogram_quantile(&latency, 0.5) / 1000.0, histogram_quantile(&latency, 0.9) / 1000.0,
+			histogram_quantile(&latency, 0.99) / 1000.0, histogram_quantile(&latency, 0.999) / 1000.0);
+	if (verify)
+	{
+		printf("In-process decisions/sec: %.0f\n", local_ns > 0 ? decisions / (local_ns / 1e9) : 0.0);
+		printf("Decisions differing from the library: %lld\n", mismatches);
+		scheduler_clean_up();
+	}
+
+	close(fd);
+	free(requests);
+	free(replies);
+	free(core);
+	free(remaining);
+	return mismatches > 0 ? 3 : 0;
+}
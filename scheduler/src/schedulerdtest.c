@@ -0,0 +1,82 @@
+/** @file schedulerdtest.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "libscheduler/libscheduler.h"
+#include "libschedulerd/libschedulerd.h"
+
+/*
+ * Checks which requests schedulerd refuses. It must be the daemon's first
+ * client, and the daemon must have been started without -c and -s, so that
+ * no scheduler exists until the START_UP below.
+ */
+
+typedef struct _request_case_t
+{
+	const char *name;
+	schedulerd_request_t request;
+	int expected;
+} request_case_t;
+
+static request_case_t cases[] =
+{
+	{ "New job before START_UP", { SCHEDULERD_NEW_JOB, 0, { 0, 0, 5, 1 } }, SCHEDULERD_INVALID },
+	{ "Finish before START_UP", { SCHEDULERD_JOB_FINISHED, 1, { 0, 0, 1 } }, SCHEDULERD_INVALID },
+	{ "Quantum expiry before START_UP", { SCHEDULERD_QUANTUM_EXPIRED, 2, { 0, 1 } }, SCHEDULERD_INVALID },
+	{ "START_UP with no cores", { SCHEDULERD_START_UP, 3, { 0, FCFS, 0 } }, SCHEDULERD_INVALID },
+	{ "START_UP with an unknown scheme", { SCHEDULERD_START_UP, 4, { 2, 99, 0 } }, SCHEDULERD_INVALID },
+	{ "New job after a refused START_UP", { SCHEDULERD_NEW_JOB, 5, { 0, 0, 5, 1 } }, SCHEDULERD_INVALID },
+	{ "START_UP with 2 cores", { SCHEDULERD_START_UP, 6, { 2, FCFS, 0 } }, 0 },
+	{ "New job 0", { SCHEDULERD_NEW_JOB, 7, { 0, 0, 5, 1 } }, 0 },
+	{ "New job with no running time", { SCHEDULERD_NEW_JOB, 8, { 1, 0, 0, 1 } }, SCHEDULERD_INVALID },
+	{ "Finish on core 2 of 2", { SCHEDULERD_JOB_FINISHED, 9, { 2, 0, 1 } }, SCHEDULERD_INVALID },
+	{ "Finish on core -1", { SCHEDULERD_JOB_FINISHED, 10, { -1, 0, 1 } }, SCHEDULERD_INVALID },
+	{ "Quantum expiry on core 2 of 2", { SCHEDULERD_QUANTUM_EXPIRED, 11, { 2, 1 } }, SCHEDULERD_INVALID },
+	{ "Finish of job 7, not on core 0", { SCHEDULERD_JOB_FINISHED, 12, { 0, 7, 1 } }, SCHEDULERD_INVALID },
+	{ "Finish of job 0 on idle core 1", { SCHEDULERD_JOB_FINISHED, 13, { 1, 0, 1 } }, SCHEDULERD_INVALID },
+	{ "Quantum expiry on idle core 1", { SCHEDULERD_QUANTUM_EXPIRED, 14, { 1, 1 } }, SCHEDULERD_INVALID },
+	{ "Unknown operation", { 42, 15, { 0 } }, SCHEDULERD_INVALID },
+	{ "Finish of job 0 on core 0", { SCHEDULERD_JOB_FINISHED, 16, { 0, 0, 5 } }, -1 },
+	{ "Finish of job 0 again", { SCHEDULERD_JOB_FINISHED, 17, { 0, 0, 6 } }, SCHEDULERD_INVALID },
+};
+
+int main(int argc, char **argv)
+{
+	int count = sizeof(cases) / sizeof(cases[0]);
+	schedulerd_request_t requests[sizeof(cases) / sizeof(cases[0])];
+	schedulerd_reply_t replies[sizeof(cases) / sizeof(cases[0])];
+	int failed = 0, i;
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "Usage: %s <socket path>\n", argv[0]);
+		return 1;
+	}
+	int fd = schedulerd_connect(argv[1]);
+	if (fd == -1)
+	{
+		fprintf(stderr, "Unable to connect to \"%s\": %s\n", argv[1], strerror(errno));
+		return 2;
+	}
+
+	/* All in one pipelined call: a refusal must not disturb later requests. */
+	for (i = 0; i < count; i++)
+		requests[i] = cases[i].request;
+	if (schedulerd_call(fd, requests, count, replies) != 0)
+	{
+		fprintf(stderr, "Lost the connection to the daemon: %s\n", strerror(errno));
+		return 2;
+	}
+	for (i = 0; i < count; i++)
+	{
+		printf("%s: %d (expected %d).\n", cases[i].name, replies[i].result, cases[i].expected);
+		failed |= replies[i].result != cases[i].expected || replies[i].tag != requests[i].tag;
+	}
+
+	close(fd);
+	return failed;
+}
@@ -0,0 +1,499 @@
+/** @file schedview.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include "libeventlog/libeventlog.h"
+#include "libhistogram/libhistogram.h"
+
+/*
+ * Offline viewer for the event logs the simulator writes with -e.
+ *
+ * The log only says what the scheduler decided, so the viewer replays it
+ * from the start, tracking which job holds each core and what every job is
+ * doing, and renders whatever was asked for over the window [from, to):
+ * the timing diagram, the cores and queue at one moment, statistics, or the
+ * raw records. Replaying up to the window touches only the records; time
+ * units are stepped through one by one only inside it.
+ */
+
+typedef enum {VIEW_PENDING = 0, VIEW_READY, VIEW_RUNNING, VIEW_BLOCKED, VIEW_DONE} view_state_t;
+
+typedef struct _view_job_t
+{
+	int state;
+	int arrival, first_start;  // first_start is -1 until the job first runs
+	int since;  // when the job entered its current state
+	int penalty;  // dispatch overhead paid since it last started running
+	int core, cores;  // the core it was last given and how many it holds
+	long long service, io;  // time units spent making progress and blocked on I/O
+} view_job_t;
+
+typedef struct _view_core_t
+{
+	int job;  // -1 when idle
+	int since, penalty_until;
+	long long busy;  // time units held inside the window
+} view_core_t;
+
+typedef struct _replay_t
+{
+	eventlog_view_t *log;
+	long long next;  // the next record to apply
+	view_job_t *jobs;
+	int job_count;
+	view_core_t *cores;
+	int core_count;
+	int from, to;  // the window
+
+	// Statistics over the window
+	long long events[EVENTLOG_TYPES];
+	long long finished, waiting, turnaround, response;
+	histogram_t waiting_histogram, turnaround_histogram, response_histogram;
+} replay_t;
+
+static const char *event_names[] = { "arrival", "finish", "expiry", "preempt", "block", "wake", "start", "penalty" };
+
+static int overlap(int start, int end, int from, int to)
+{
+	if (start < from)
+		start = from;
+	if (end > to)
+		end = to;
+	return end > start ? end - start : 0;
+}
+
+static void clear_core(replay_t *r, int core_id, int time)
+{
+	view_core_t *core = &r->cores[core_id];
+	core->busy += overlap(core->since, time, r->from, r->to);
+	core->job = -1;
+}
+
+/*
+ * Takes every core the job holds and moves it to a new state.
+ */
+static void release(replay_t *r, int job_id, int time, int state)
+{
+	view_job_t *job = &r->jobs[job_id];
+	int c;
+
+	if (job->cores == 1 && r->cores[job->core].job == job_id)
+		clear_core(r, job->core, time);
+	else if (job->cores > 0)
+	{
+		for (c = 0; c < r->core_count; c++)
+			if (r->cores[c].job == job_id)
+				clear_core(r, c, time);
+	}
+
+	if (job->state == VIEW_RUNNING && time - job->since > job->penalty)
+		job->service += time - job->since - job->penalty;
+	if (job->state == VIEW_BLOCKED)
+		job->io += time - job->since;
+	job->cores = 0;
+	job->state = state;
+	job->since = time;
+}
+
+/*
+ * Puts a job on a core, sending whatever job held it back to the queue.
+ */
+static void place(replay_t *r, int job_id, int core_id, int time)
+{
+	view_core_t *core = &r->cores[core_id];
+	view_job_t *job = &r->jobs[job_id];
+
+	if (core->job != -1 && core->job != job_id)
+	{
+		view_job_t *preempted = &r->jobs[core->job];
+		release(r, core->job, time, VIEW_READY);
+		// A job preempted the moment it started has not really responded yet
+		if (preempted->first_start == time)
+			preempted->first_start = -1;
+	}
+
+	if (job->state != VIEW_RUNNING)
+	{
+		if (job->state == VIEW_BLOCKED)
+			job->io += time - job->since;
+		job->state = VIEW_RUNNING;
+		job->since = time;
+		job->penalty = 0;
+		job->core = core_id;
+		if (job->first_start == -1)
+			job->first_start = time;
+	}
+	if (core->job != job_id)
+	{
+		job->cores++;
+		core->job = job_id;
+		core->since = time;
+	}
+	core->penalty_until = time;
+}
+
+static void finish(replay_t *r, int job_id, int time)
+{
+	view_job_t *job = &r->jobs[job_id];
+	release(r, job_id, time, VIEW_DONE);
+	if (time < r->from || time >= r->to)
+		return;
+
+	int turnaround = time - job->arrival;
+	int waiting = (int)(turnaround - job->service - job->io);
+	int response = job->first_start - job->arrival;
+	r->finished++;
+	r->turnaround += turnaround;
+	r->waiting += waiting;
+	r->response += response;
+	histogram_record(&r->turnaround_histogram, turnaround);
+	histogram_record(&r->waiting_histogram, waiting);
+	histogram_record(&r->response_histogram, response);
+}
+
+static int valid_record(replay_t *r, eventlog_record_t *record)
+{
+	int needs_core = record->type != EVENTLOG_ARRIVAL && record->type != EVENTLOG_WAKE;
+	int names_job = record->type == EVENTLOG_FINISH || record->type == EVENTLOG_EXPIRY ||
+			record->type == EVENTLOG_BLOCK || record->type == EVENTLOG_PREEMPT;
+
+	return record->type >= 0 && record->type < EVENTLOG_TYPES &&
+			record->job_id >= 0 && record->job_id < r->job_count &&
+			record->core_id >= (needs_core ? 0 : -1) && record->core_id < r->core_count &&
+			(!names_job || (record->result >= -1 && record->result < r->job_count));
+}
+
+/*
+ * Applies every record before time until. Returns -1 at a record that does
+ * not describe a possible run.
+ */
+static int replay_until(replay_t *r, int until)
+{
+	for (; r->next < r->log->m_count && r->log->m_records[r->next].time < until; r->next++)
+	{
+		eventlog_record_t *record = &r->log->m_records[r->next];
+		int time = record->time;
+		view_job_t *job;
+
+		if (!valid_record(r, record))
+			return -1;
+		job = &r->jobs[record->job_id];
+		if (time >= r->from && time < r->to)
+			r->events[record->type]++;
+
+		switch (record->type)
+		{
+			case EVENTLOG_ARRIVAL:
+				job->state = VIEW_READY;
+				job->arrival = job->since = time;
+				if (record->core_id != -1)
+					place(r, record->job_id, record->core_id, time);
+				break;
+
+			case EVENTLOG_WAKE:
+				release(r, record->job_id, time, VIEW_READY);
+				if (record->core_id != -1)
+					place(r, record->job_id, record->core_id, time);
+				break;
+
+			case EVENTLOG_FINISH:
+			case EVENTLOG_BLOCK:
+			case EVENTLOG_EXPIRY:
+				if (record->type == EVENTLOG_FINISH)
+					finish(r, record->job_id, time);
+				else
+					release(r, record->job_id, time, record->type == EVENTLOG_BLOCK ? VIEW_BLOCKED : VIEW_READY);
+				if (record->result != -1)
+					place(r, record->result, record->core_id, time);
+				break;
+
+			case EVENTLOG_START:
+				place(r, record->job_id, record->core_id, time);
+				break;
+
+			case EVENTLOG_PENALTY:
+				r->cores[record->core_id].penalty_until = time + record->result;
+				job->penalty = record->result;
+				break;
+
+			case EVENTLOG_PREEMPT:
+				// The arrival or wake-up that took the core already moved the job
+				break;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Prints the timing diagram of the window in the simulator's format, one
+ * row per core.
+ */
+static int show_diagram(replay_t *r, int end)
+{
+	int c, time, to = r->to < end ? r->to : end;
+	if (to < r->from)
+		to = r->from;
+	char **rows = malloc(r->core_count * sizeof(char *));
+	size_t *lengths = calloc(r->core_count, sizeof(size_t));
+	size_t capacity = 1024;
+
+	for (c = 0; c < r->core_count; c++)
+	{
+		rows[c] = malloc(capacity);
+		rows[c][0] = '\0';
+	}
+
+	int status = replay_until(r, r->from);
+	for (time = r->from; time < to && status == 0; time++)
+	{
+		if ((status = replay_until(r, time + 1)) != 0)
+			break;
+
+		for (c = 0; c < r->core_count; c++)
+		{
+			char cell[16];
+			view_core_t *core = &r->cores[c];
+
+			if (core->job == -1)
+				strcpy(cell, "-");
+			else if (time < core->penalty_until)
+				strcpy(cell, "*");
+			else if (core->job < 10)
+				sprintf(cell, "%d", core->job);
+			else if (core->job < 10 + 26)
+				sprintf(cell, "%c", core->job - 10 + 'a');
+			else if (core->job < 10 + 26 + 26)
+				sprintf(cell, "%c", core->job - 10 - 26 + 'A');
+			else
+				snprintf(cell, sizeof(cell), "(%d)", core->job);
+
+			size_t length = strlen(cell);
+			if (lengths[c] + length >= capacity)
+			{
+				int d;
+				capacity *= 2;
+				for (d = 0; d < r->core_count; d++)
+					rows[d] = realloc(rows[d], capacity);
+			}
+			memcpy(rows[c] + lengths[c], cell, length + 1);
+			lengths[c] += length;
+		}
+	}
+
+	if (status == 0)
+		printf("TIMING DIAGRAM (time units %d to %d):\n", r->from, to);
+	for (c = 0; c < r->core_count; c++)
+	{
+		if (status == 0)
+			printf("  Core %2d: %s\n", c, rows[c]);
+		free(rows[c]);
+	}
+	free(rows);
+	free(lengths);
+	return status;
+}
+
+/*
+ * Prints which job holds each core, and which jobs wait or are blocked,
+ * once every event of a time unit has been applied.
+ */
+static int show_snapshot(replay_t *r, int time)
+{
+	const char *titles[] = { "Waiting", "Blocked" };
+	int states[] = { VIEW_READY, VIEW_BLOCKED };
+	int c, i, k;
+
+	if (replay_until(r, time + 1) != 0)
+		return -1;
+
+	printf("At time unit %d...\n", time);
+	for (c = 0; c < r->core_count; c++)
+	{
+		view_core_t *core = &r->cores[c];
+		printf("  Core %2d: ", c);
+		if (core->job == -1)
+			printf("idle\n");
+		else
+		{
+			printf("job %d since %d", core->job, core->since);
+			if (time < core->penalty_until)
+				printf(", dispatching until %d", core->penalty_until);
+			printf("\n");
+		}
+	}
+
+	for (k = 0; k < 2; k++)
+	{
+		int first = 1;
+		printf("  %s: ", titles[k]);
+		for (i = 0; i < r->job_count; i++)
+		{
+			if (r->jobs[i].state != states[k])
+				continue;
+			printf(first ? "%d" : ", %d", i);
+			first = 0;
+		}
+		printf("%s\n", first ? "none" : "");
+	}
+	return 0;
+}
+
+static int show_statistics(replay_t *r, int end)
+{
+	const char *names[] = { "Waiting", "Turnaround", "Response" };
+	histogram_t *histograms[] = { &r->waiting_histogram, &r->turnaround_histogram, &r->response_histogram };
+	int c, i, to = r->to < end ? r->to : end;
+	if (to < r->from)
+		to = r->from;
+
+	if (replay_until(r, r->to) != 0)
+		return -1;
+
+	printf("Statistics for time units %d to %d:\n\n", r->from, to);
+	printf("Arrivals: %lld\n", r->events[EVENTLOG_ARRIVAL]);
+	printf("Finishes: %lld\n", r->events[EVENTLOG_FINISH]);
+	printf("Quantum Expiries: %lld\n", r->events[EVENTLOG_EXPIRY]);
+	printf("Preemptions: %lld\n", r->events[EVENTLOG_PREEMPT]);
+	if (r->events[EVENTLOG_BLOCK] > 0 || r->events[EVENTLOG_WAKE] > 0)
+		printf("I/O Blocks: %lld\n", r->events[EVENTLOG_BLOCK]);
+	printf("\n");
+
+	if (r->finished > 0)
+	{
+		printf("Average Waiting Time: %.2f\n", (float)((double)r->waiting / r->finished));
+		printf("Average Turnaround Time: %.2f\n", (float)((double)r->turnaround / r->finished));
+		printf("Average Response Time: %.2f\n", (float)((double)r->response / r->finished));
+		printf("\n");
+		for (i = 0; i < 3; i++)
+			printf("%s Time p50/p90/p99/p99.9: %d / %d / %d / %d\n", names[i],
+					histogram_quantile(histograms[i], 0.5), histogram_quantile(histograms[i], 0.9),
+					histogram_quantile(histograms[i], 0.99), histogram_quantile(histograms[i], 0.999));
+	}
+	else
+		printf("No job finished in the window.\n");
+
+	printf("\n");
+	printf("Core Utilization:\n");
+	for (c = 0; c < r->core_count; c++)
+	{
+		view_core_t *core = &r->cores[c];
+		long long busy = core->busy + (core->job != -1 ? overlap(core->since, to, r->from, to) : 0);
+		printf("  Core %2d: %.2f%%\n", c, to > r->from ? 100.0 * busy / (to - r->from) : 0.0);
+	}
+	return 0;
+}
+
+static void show_records(replay_t *r)
+{
+	long long i;
+	printf("%10s  %-8s %8s %5s %8s\n", "TIME", "EVENT", "JOB", "CORE", "RESULT");
+	for (i = eventlog_seek(r->log, r->from); i < r->log->m_count && r->log->m_records[i].time < r->to; i++)
+	{
+		eventlog_record_t *record = &r->log->m_records[i];
+		printf("%10d  %-8s %8d %5d %8d\n", record->time,
+				record->type >= 0 && record->type < EVENTLOG_TYPES ? event_names[record->type] : "?",
+				record->job_id, record->core_id, record->result);
+	}
+}
+
+static void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-f <from>] [-t <to>] [-d | -s | -r | -q <time>] <event log>\n", program_name);
+	fprintf(stderr, "-f <from> and -t <to> limit the view to time units from <from> up to, not including, <to>\n");
+	fprintf(stderr, "-d prints the timing diagram (the default)\n");
+	fprintf(stderr, "-s prints arrivals, preemptions, waiting, turnaround and response times and core utilization\n");
+	fprintf(stderr, "-r lists the records themselves\n");
+	fprintf(stderr, "-q <time> prints what each core runs and which jobs wait at time unit <time>\n");
+}
+
+int main(int argc, char **argv)
+{
+	int c, view = 'd', from = 0, to = INT_MAX, at = -1;
+	const char *scheme_names[] = { "fcfs", "sjf", "psjf", "pri", "ppri", "rr", "stride", "lottery" };
+
+	while ((c = getopt(argc, argv, "f:t:dsrq:")) != -1)
+	{
+		switch (c)
+		{
+			case 'f': from = atoi(optarg); break;
+			case 't': to = atoi(optarg); break;
+			case 'd':
+			case 's':
+			case 'r':
+				view = c;
+				break;
+			case 'q':
+				view = c;
+				at = atoi(optarg);
+				break;
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || from < 0 || to <= from || (view == 'q' && at < 0))
+	{
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	eventlog_view_t log;
+	if (eventlog_map(&log, argv[optind]) != 0)
+	{
+		fprintf(stderr, "Unable to read an event log from \"%s\".\n", argv[optind]);
+		return 2;
+	}
+
+	replay_t replay;
+	long long i;
+	memset(&replay, 0, sizeof(replay));
+	replay.log = &log;
+	replay.from = from;
+	replay.to = to;
+	replay.core_count = log.m_header->cores > 0 ? log.m_header->cores : 0;
+	for (i = 0; i < log.m_count; i++)
+		if (log.m_records[i].job_id >= replay.job_count)
+			replay.job_count = log.m_records[i].job_id + 1;
+	replay.jobs = calloc(replay.job_count > 0 ? replay.job_count : 1, sizeof(view_job_t));
+	replay.cores = calloc(replay.core_count > 0 ? replay.core_count : 1, sizeof(view_core_t));
+	for (i = 0; i < replay.job_count; i++)
+		replay.jobs[i].first_start = -1;
+	for (i = 0; i < replay.core_count; i++)
+		replay.cores[i].job = -1;
+	histogram_init(&replay.waiting_histogram);
+	histogram_init(&replay.turnaround_histogram);
+	histogram_init(&replay.response_histogram);
+
+	// The run ends at its last event, the final finish; that time unit never runs
+	int end = log.m_count > 0 ? log.m_records[log.m_count - 1].time : 0;
+	int scheme = log.m_header->scheme;
+
+	printf("%lld event(s) of %d job(s) on %d core(s) using %s", log.m_count, replay.job_count, replay.core_count,
+			scheme >= 0 && scheme < (int)(sizeof(scheme_names) / sizeof(scheme_names[0])) ? scheme_names[scheme] : "?");
+	if (log.m_header->quantum > 0)
+		printf(" with a quantum of %d", log.m_header->quantum);
+	printf(", ending at time %d\n\n", end);
+
+	int status = 0;
+	if (view == 'd')
+		status = show_diagram(&replay, end);
+	else if (view == 's')
+		status = show_statistics(&replay, end);
+	else if (view == 'q')
+		status = show_snapshot(&replay, at);
+	else
+		show_records(&replay);
+
+	if (status != 0)
+		fprintf(stderr, "Record %lld does not describe a possible run; the log is corrupt.\n", replay.next);
+
+	free(replay.jobs);
+	free(replay.cores);
+	eventlog_unmap(&log);
+	return status != 0 ? 2 : 0;
+}
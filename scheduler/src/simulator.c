@@ -8,36 +8,801 @@
 #include <unistd.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
 
 #include "libscheduler/libscheduler.h"
+#include "libtimerwheel/libtimerwheel.h"
+#include "libtelemetry/libtelemetry.h"
+#include "libeventlog/libeventlog.h"
+#include "libcluster/libcluster.h"
+#include "libswf/libswf.h"
+#include "libresultcache/libresultcache.h"
+
+// Every option, for simulate() and for main() picking out -C
+#define SIMULATOR_OPTIONS "c:s:a:q:v:M:x:m:g:j:e:PT:i:Qk:r:N:d:w:t:S:f:W:C:"
+
+// Samples -T buffers before writing them to its file
+#define TELEMETRY_SAMPLES 65536
 
 
 typedef struct _simulator_job_list_t
 {
 	int job_id, arrival_time, run_time, priority;
 	int core_id, arrived;
+	int cores;  // Cores the job holds at once, from the optional fourth column
+	long long work;  // Remaining work, in CORE_SPEED_UNITs
+	int *bursts;  // Alternating CPU and I/O bursts, or NULL for a single CPU burst
+	int burst_count, burst;  // Number of bursts, and the index of the current CPU burst
+	int blocked;  // Waiting on I/O
+	int group;  // Group the job is charged to under fair share, from the optional sixth column
 } simulator_job_list_t;
 
+typedef struct _simulator_core_t
+{
+	int job;  // Index into the job list of the job on this core, or -1 when idle
+	int speed;  // Work done per time unit, in CORE_SPEED_UNITs
+	long long busy;  // Time units spent holding a job
+	timerwheel_entry_t finish, quantum;
+} simulator_core_t;
+
+#define CHECKPOINT_MAGIC "SIMCKPT"
+#define CHECKPOINT_VERSION 3
+
+/*
+ * Start of a -k checkpoint: the run's configuration and where it stopped.
+ * It is followed by the job list (then the I/O bursts of the jobs that have
+ * them), job_slot, one simulator_checkpoint_core_t per core, each core's
+ * timing diagram as a length and its characters, and the scheduler's own
+ * snapshot from scheduler_save(). Everything is in native byte order.
+ */
+typedef struct _simulator_checkpoint_t
+{
+	char magic[8];
+	int version;
+	int cores, scheme, quantum, granularity, aging;
+	int multiqueue, placement, steal, migration_cost;
+	int switch_cost, migration_penalty, mixed_speeds;
+	int gang, backfill, io_jobs;
+	int time, active_jobs, jobs_alive, total_jobs;
+} simulator_checkpoint_t;
+
+typedef struct _simulator_checkpoint_core_t
+{
+	int job, speed, penalty;
+	int finish, quantum;  // Pending deadlines, -1 if the timer is not armed
+	long long busy;
+} simulator_checkpoint_core_t;
+
+// The -e event log, or NULL when none was asked for
+static eventlog_t *event_log;
+
+/*
+ * Records a scheduling event in the event log, if one is being written.
+ */
+void log_event(int time, eventlog_type_t type, int job_id, int core_id, int result)
+{
+	if (event_log != NULL)
+		eventlog_append(event_log, time, type, job_id, core_id, result);
+}
+
 void print_usage(char *program_name)
 {
-	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> <input file>\n", program_name);
+	fprintf(stderr, "Usage: %s -c <cores | count:speed,...> -s <scheme> [-a <aging interval>]\n", program_name);
+	fprintf(stderr, "       [-q <placement> [-v <victim>] [-M <migration cost>]] [-x <switch cost>] [-m <migration cost>]\n");
+	fprintf(stderr, "       [-g <backfill>] [-j <job log>] [-e <event log>] [-P]\n");
+	fprintf(stderr, "       [-T <telemetry file> [-i <interval>]] [-k <time>:<checkpoint>] [-Q] [-S <seconds>]\n");
+	fprintf(stderr, "       [-f <half-life> [-W <group>:<weight>,...]] [-C <cache directory>] <input file>\n");
+	fprintf(stderr, "       %s -r <checkpoint> [<scheduling options>] [-j <job log>] [-e <event log>] [-P] [-T <telemetry file>] [-k <time>:<checkpoint>] [-Q]\n", program_name);
+	fprintf(stderr, "       %s -N <nodes> -c <cores> -s <scheme> [-d <dispatch>] [-w <window>] [-t <threads>] [-a <aging interval>] [-P] <input file>\n", program_name);
 	fprintf(stderr, "       %s -c 2 -s fcfs examples/proc1.csv\n", program_name);
 	fprintf(stderr, "\n");
-	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#\n");
+	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#, rr#:#, stride#, lottery#\n");
+	fprintf(stderr, "(stride# and lottery# use the priority column as the job's ticket count)\n");
+	fprintf(stderr, "rr#:# is adaptive RR, eg rr12:2: each slice is the target latency (12) over the jobs sharing a core, at least the\n");
+	fprintf(stderr, "granularity (2), and stretched up to twice that to fit the recent average CPU burst\n");
+	fprintf(stderr, "An optional fourth column gives the number of cores a job needs at once (default 1)\n");
+	fprintf(stderr, "A run time of the form cpu;io;cpu;... makes the job alternate CPU bursts with I/O\n");
+	fprintf(stderr, "An optional fifth column lists the jobs (numbered by line from 0, separated by spaces) that must\n");
+	fprintf(stderr, "finish before the job can start\n");
+	fprintf(stderr, "An optional sixth column names the group a job is charged to under fair share (default 0);\n");
+	fprintf(stderr, "optional columns may be left empty to reach later ones\n");
+	fprintf(stderr, "An input file ending in .swf is read as a Standard Workload Format trace: submit time, run time,\n");
+	fprintf(stderr, "requested processors and queue (or partition) become arrival, run time, cores and priority\n");
+	fprintf(stderr, "-S <seconds> makes each time unit of an .swf trace <seconds> long (default 1)\n");
+	fprintf(stderr, "-f <half-life> shares the cores fairly between groups (fcfs, sjf, psjf, pri, ppri or rr): a free core\n");
+	fprintf(stderr, "   serves the group with the least usage for its weight; usage halves every <half-life> time units (0: never)\n");
+	fprintf(stderr, "-W <group>:<weight>,... gives groups a larger share under -f (default weight 1); .swf traces use group ids\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-c 4:2.0,4:1.0 runs four cores at twice the speed of the other four\n");
+	fprintf(stderr, "-a <interval> lets waiting pri/ppri jobs gain one priority level every <interval> time units\n");
+	fprintf(stderr, "-q <placement> gives every core its own run queue; placement is least (least loaded) or rr (round robin)\n");
+	fprintf(stderr, "-v <victim> picks the queue an idle core steals from: busiest (default) or random\n");
+	fprintf(stderr, "-M <cost> charges <cost> time units whenever a job is stolen by another core\n");
+	fprintf(stderr, "-x <cost> charges <cost> time units whenever a core switches to a different job\n");
+	fprintf(stderr, "-m <cost> charges <cost> time units whenever a job resumes on a different core than it last ran on\n");
+	fprintf(stderr, "-g <backfill> gang-schedules jobs that need several cores (fcfs, sjf or pri); backfill is easy or none\n");
+	fprintf(stderr, "-j <file> writes one record per finished job to <file> (binary if it ends in .bin, CSV otherwise)\n");
+	fprintf(stderr, "-e <file> writes every arrival, finish, quantum expiry and preemption to <file> as binary records for schedview\n");
+	fprintf(stderr, "-P prints p50/p90/p99/p99.9 of the waiting, turnaround and response times\n");
+	fprintf(stderr, "-T <file> samples ready jobs, busy cores, preemptions and context switches into <file> (binary if it ends in .bin);\n");
+	fprintf(stderr, "   every sample is kept, however long the run\n");
+	fprintf(stderr, "-i <interval> samples every <interval> time units (default 0: every time unit in which a job arrives, finishes or is switched out)\n");
+	fprintf(stderr, "-Q prints only the final statistics, without the per-time-unit trace or timing diagram\n");
+	fprintf(stderr, "-k <time>:<file> stops at the start of time unit <time> and saves the whole simulation to <file>\n");
+	fprintf(stderr, "   (not available for jobs with dependencies or with fair share, -f)\n");
+	fprintf(stderr, "-C <dir> keeps the output of each run in <dir> and prints it again, without simulating, when the same run is\n");
+	fprintf(stderr, "   repeated with the same input file and build of the simulator; runs with -j, -e, -T or -k are not cached,\n");
+	fprintf(stderr, "   and entries another build of the simulator left in <dir> are deleted\n");
+	fprintf(stderr, "-r <file> resumes a saved simulation exactly; with any of -c -s -a -q -v -M -x -m it instead forks it: the jobs that\n");
+	fprintf(stderr, "   had arrived start over on the new configuration with the work they had left, and statistics cover only the fork\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "-N <nodes> simulates a cluster of <nodes> nodes with -c cores each, and prints only the final statistics\n");
+	fprintf(stderr, "-d <dispatch> sends each arriving job to a node: random (default), rr, jsq (shortest queue) or p2c (power of two choices)\n");
+	fprintf(stderr, "-w <window> lets nodes run <window> time units between synchronizations (default 1); dispatch sees loads that old\n");
+	fprintf(stderr, "-t <threads> simulates the nodes on <threads> threads (default: one per CPU)\n");
+}
+
+int set_active_job(int job_id, int core_id, simulator_job_list_t *jobs, int *job_slot, int total_jobs)
+{
+	if (job_id < 0 || job_id >= total_jobs || job_slot[job_id] == -1 || !jobs[job_slot[job_id]].arrived || jobs[job_slot[job_id]].blocked)
+		return -1;
+
+	jobs[job_slot[job_id]].core_id = core_id;
+	return job_slot[job_id];
+}
+
+/*
+ * Puts the job at index on the core and arms the core's finish and quantum
+ * timers. The job starts making progress at start, after any dispatch penalty.
+ */
+void run_on_core(simulator_core_t *core, int index, simulator_job_list_t *jobs, timerwheel_t *wheel, int start, int quantum)
+{
+	core->job = index;
+	timerwheel_arm(wheel, &core->finish, start + (int)((jobs[index].work + core->speed - 1) / core->speed));
+
+	if (quantum > 0)
+		timerwheel_arm(wheel, &core->quantum, start + quantum);
+}
+
+/*
+ * Gives core_id to the job at index, as the scheduler decided, taking it
+ * from any job already there.
+ */
+void place_on_core(simulator_core_t *core_state, int core_id, int index, simulator_job_list_t *jobs, timerwheel_t *wheel,
+		int time, int quantum, int *penalty_clock)
+{
+	// Find if anyone is currently using the core.
+	if (core_state[core_id].job != -1)
+	{
+		jobs[core_state[core_id].job].core_id = -1;
+		log_event(time, EVENTLOG_PREEMPT, jobs[core_state[core_id].job].job_id, core_id, jobs[index].job_id);
+	}
+
+	// Assign the core to the new job
+	jobs[index].core_id = core_id;
+	penalty_clock[core_id] = scheduler_dispatch_penalty(core_id);
+	if (penalty_clock[core_id] > 0)
+		log_event(time, EVENTLOG_PENALTY, jobs[index].job_id, core_id, penalty_clock[core_id]);
+	run_on_core(&core_state[core_id], index, jobs, wheel, time + penalty_clock[core_id], quantum > 0 ? scheduler_quantum(core_id) : 0);
+}
+
+void idle_core(simulator_core_t *core, timerwheel_t *wheel)
+{
+	core->job = -1;
+	timerwheel_cancel(wheel, &core->finish);
+	timerwheel_cancel(wheel, &core->quantum);
+}
+
+/*
+ * Parses -c: either a core count, or comma-separated groups of count:speed
+ * such as 4:2.0,4:1.0. Returns the number of cores, or 0 if the spec is
+ * malformed, and stores each core's speed in CORE_SPEED_UNITs in *speeds.
+ */
+int parse_cores(const char *spec, int **speeds)
+{
+	int total = 0, i;
+	char *copy = strdup(spec), *save = NULL, *group;
+
+	*speeds = NULL;
+	for (group = strtok_r(copy, ",", &save); group != NULL; group = strtok_r(NULL, ",", &save))
+	{
+		char *colon = strchr(group, ':');
+		int count = atoi(group);
+		int speed = colon ? (int)(atof(colon + 1) * CORE_SPEED_UNIT + 0.5) : CORE_SPEED_UNIT;
+
+		if (count <= 0 || speed <= 0)
+		{
+			total = 0;
+			break;
+		}
+
+		*speeds = realloc(*speeds, (total + count) * sizeof(int));
+		for (i = 0; i < count; i++)
+			(*speeds)[total + i] = speed;
+		total += count;
+	}
+
+	free(copy);
+	if (total == 0)
+	{
+		free(*speeds);
+		*speeds = NULL;
+	}
+	return total;
+}
+
+/*
+ * Prints the cores, from core from onwards, that the scheduler has given
+ * the job, e.g. "0, 2, 3".
+ */
+void print_gang_cores(int job_id, int from, int cores)
+{
+	int c, first = 1;
+	for (c = from; c < cores; c++)
+	{
+		if (scheduler_core_job(c) == job_id)
+		{
+			printf(first ? "%d" : ", %d", c);
+			first = 0;
+		}
+	}
+}
+
+/*
+ * Gang scheduling: one scheduler call can start several jobs, each on
+ * several cores, so every idle core is checked with scheduler_core_job().
+ * The first core of a job carries its timers and drains its work; the others
+ * only hold it. Returns -1 if the scheduler started a job that is not waiting.
+ */
+int start_gang_jobs(simulator_core_t *core_state, int cores, simulator_job_list_t *jobs, int *job_slot, int total_jobs,
+		timerwheel_t *wheel, int time, int quiet)
+{
+	int c, job_id, index;
+	for (c = 0; c < cores; c++)
+	{
+		if (core_state[c].job != -1 || (job_id = scheduler_core_job(c)) == -1)
+			continue;
+
+		if (job_id >= total_jobs || job_slot[job_id] == -1 || !jobs[job_slot[job_id]].arrived)
+		{
+			printf("The scheduler started an invalid job (job_id == %d) on core %d.\n", job_id, c);
+			return -1;
+		}
+
+		index = job_slot[job_id];
+		log_event(time, EVENTLOG_START, job_id, c, 0);
+		if (jobs[index].core_id == -1)
+		{
+			jobs[index].core_id = c;
+			run_on_core(&core_state[c], index, jobs, wheel, time, 0);
+
+			if (!quiet)
+			{
+				printf("Job %d is now running on core(s) ", job_id);
+				print_gang_cores(job_id, c, cores);
+				printf(".\n");
+			}
+		}
+		else
+			core_state[c].job = index;
+	}
+	return 0;
+}
+
+/*
+ * Parses a run time that is either a single CPU burst or a list
+ * cpu;io;cpu;... that starts and ends with a CPU burst. Returns the number
+ * of bursts, or 0 if the list is malformed; a list is stored in *bursts.
+ */
+int parse_bursts(const char *spec, int **bursts)
+{
+	int count = 0;
+	char *copy = strdup(spec), *save = NULL, *burst;
+
+	*bursts = NULL;
+	if (strchr(spec, ';') == NULL)
+	{
+		free(copy);
+		return 1;
+	}
+
+	for (burst = strtok_r(copy, ";", &save); burst != NULL; burst = strtok_r(NULL, ";", &save))
+	{
+		*bursts = realloc(*bursts, (count + 1) * sizeof(int));
+		(*bursts)[count++] = atoi(burst);
+		if ((*bursts)[count - 1] <= 0)
+		{
+			count = 0;
+			break;
+		}
+	}
+
+	free(copy);
+	if (count % 2 == 0)
+	{
+		free(*bursts);
+		*bursts = NULL;
+		return 0;
+	}
+	return count;
+}
+
+/*
+ * Parses the dependency column of job job_id: the ids of the jobs that have
+ * to finish before it starts, separated by spaces. Each is appended to
+ * *edges as a (predecessor, job_id) pair. Returns -1 if the list is malformed.
+ */
+int parse_dependencies(const char *list, int job_id, int **edges, int *edge_count, int *edge_capacity)
+{
+	char *end;
+	while (*list != '\0')
+	{
+		if (*list == ' ' || *list == '\t')
+		{
+			list++;
+			continue;
+		}
+		long predecessor = strtol(list, &end, 10);
+		if (end == list || predecessor < 0 || predecessor > INT_MAX || predecessor == job_id)
+			return -1;
+		list = end;
+
+		if (*edge_count == *edge_capacity)
+		{
+			*edge_capacity = *edge_capacity > 0 ? *edge_capacity * 2 : 64;
+			*edges = realloc(*edges, *edge_capacity * 2 * sizeof(int));
+		}
+		(*edges)[2 * *edge_count] = (int)predecessor;
+		(*edges)[2 * *edge_count + 1] = job_id;
+		(*edge_count)++;
+	}
+	return 0;
+}
+
+/*
+ * Turns (predecessor, successor) pairs into compressed sparse rows: the jobs
+ * that depend on job j are (*successors)[(*first)[j]] up to
+ * (*successors)[(*first)[j + 1] - 1]. Returns -1 if a pair names a job that
+ * does not exist, or -2 if memory could not be allocated; either way both
+ * arrays are left NULL.
+ */
+int build_dependencies(const int *edges, int edge_count, int total_jobs, int **first, int **successors)
+{
+	int e, j;
+	*first = calloc(total_jobs + 1, sizeof(int));
+	*successors = malloc((edge_count + 1) * sizeof(int));
+	if (*first == NULL || *successors == NULL)
+	{
+		free(*first);
+		free(*successors);
+		*first = NULL;
+		*successors = NULL;
+		return -2;
+	}
+
+	// Count each row into the slot after it, then sum them into row starts
+	for (e = 0; e < edge_count; e++)
+	{
+		if (edges[2 * e] >= total_jobs)
+		{
+			free(*first);
+			free(*successors);
+			*first = NULL;
+			*successors = NULL;
+			return -1;
+		}
+		(*first)[edges[2 * e] + 1]++;
+	}
+	for (j = 0; j < total_jobs; j++)
+		(*first)[j + 1] += (*first)[j];
+
+	// Filling a row advances its start to the next row's, so shift them back
+	for (e = 0; e < edge_count; e++)
+		(*successors)[(*first)[edges[2 * e]]++] = edges[2 * e + 1];
+	for (j = total_jobs; j > 0; j--)
+		(*first)[j] = (*first)[j - 1];
+	(*first)[0] = 0;
+	return 0;
+}
+
+/*
+ * Returns the length of the longest chain of dependent jobs, each taking its
+ * whole run time on a core of speed 1.0 (I/O included), or -1 if the
+ * dependencies form a cycle. Jobs are visited in topological order, so this
+ * is O(jobs + dependencies).
+ */
+long long critical_path(simulator_job_list_t *jobs, int total_jobs, const int *first, const int *successors)
+{
+	int *pending = calloc(total_jobs, sizeof(int));
+	int *order = malloc(total_jobs * sizeof(int));
+	long long *start = calloc(total_jobs, sizeof(long long));  // The longest chain before each job
+	long long longest = 0;
+	int head = 0, tail = 0, j, e;
+
+	for (e = 0; e < first[total_jobs]; e++)
+		pending[successors[e]]++;
+	for (j = 0; j < total_jobs; j++)
+		if (pending[j] == 0)
+			order[tail++] = j;
+
+	while (head < tail)
+	{
+		j = order[head++];
+		long long end = start[j] + jobs[j].run_time;
+		for (int b = 1; jobs[j].bursts != NULL && b < jobs[j].burst_count; b++)
+			end += jobs[j].bursts[b];
+		if (end > longest)
+			longest = end;
+
+		for (e = first[j]; e < first[j + 1]; e++)
+		{
+			int successor = successors[e];
+			if (end > start[successor])
+				start[successor] = end;
+			if (--pending[successor] == 0)
+				order[tail++] = successor;
+		}
+	}
+
+	free(pending);
+	free(order);
+	free(start);
+	return tail == total_jobs ? longest : -1;
+}
+
+/*
+ * Frees what simulate() has read when it stops before simulating: the
+ * first job_count jobs and the buffers filled from the options and the input
+ * file. Returns status, for the caller to return in turn.
+ */
+int discard_input(int status, simulator_job_list_t *jobs, int job_count, int *core_speeds, int *group_weights, int *dependency_edges)
+{
+	for (int i = 0; i < job_count; i++)
+		free(jobs[i].bursts);
+	free(jobs);
+	free(core_speeds);
+	free(group_weights);
+	free(dependency_edges);
+	return status;
+}
+
+/*
+ * Parses -W: comma-separated group:weight pairs such as 0:3,7:1. Returns
+ * the number of pairs, stored group then weight in *pairs, or -1 if the
+ * spec is malformed.
+ */
+int parse_group_weights(const char *spec, int **pairs)
+{
+	int count = 0;
+	char *copy = strdup(spec), *save = NULL, *pair, *end;
+
+	*pairs = NULL;
+	for (pair = strtok_r(copy, ",", &save); pair != NULL; pair = strtok_r(NULL, ",", &save))
+	{
+		long group = strtol(pair, &end, 10), weight = -1;
+		if (end != pair && *end == ':')
+			weight = strtol(end + 1, &end, 10);
+		if (group < 0 || group > INT_MAX || weight <= 0 || weight > INT_MAX || *end != '\0')
+		{
+			count = -1;
+			break;
+		}
+		*pairs = realloc(*pairs, (count + 1) * 2 * sizeof(int));
+		(*pairs)[2 * count] = (int)group;
+		(*pairs)[2 * count + 1] = (int)weight;
+		count++;
+	}
+
+	free(copy);
+	return count;
+}
+
+/*
+ * Checks that the cores a job needs can be given to it. Prints why not and
+ * returns -1 if they cannot.
+ */
+int check_job_cores(simulator_job_list_t *job, int cores, int gang)
+{
+	if (job->cores > cores)
+	{
+		fprintf(stderr, "Job %d needs %d cores but only %d are available.\n", job->job_id, job->cores, cores);
+		return -1;
+	}
+	if (job->cores > 1 && !gang)
+	{
+		fprintf(stderr, "Job %d needs %d cores; jobs that need more than one core require -g <backfill>.\n", job->job_id, job->cores);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Reads a trace in Standard Workload Format into *jobs, growing it (and
+ * *jobs_ct) as needed. One time unit is scale seconds: arrivals round down
+ * and run times round up. A job's cores are the processors it requested,
+ * or failing that the ones it was given, its priority is its queue, or
+ * failing that its partition, and its group is its group, or failing that
+ * its user. Jobs that never ran (run time 0 or unknown)
+ * are skipped. Returns the number of jobs, or -1 after printing why the
+ * trace cannot be used.
+ */
+int read_swf(FILE *file, const char *file_name, int scale, int cores, int gang, simulator_job_list_t **jobs, int *jobs_ct)
+{
+	swf_reader_t reader;
+	swf_job_t swf_job;
+	int job_id = 0, status;
+	long long skipped = 0;
+
+	if (swf_open(&reader, file) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return -1;
+	}
+	while ((status = swf_next(&reader, &swf_job)) == 1)
+	{
+		if (swf_job.run_time <= 0 || swf_job.submit_time < 0)
+		{
+			skipped++;
+			continue;
+		}
+		long long arrival_time = swf_job.submit_time / scale;
+		long long run_time = (swf_job.run_time + scale - 1) / scale;
+		if (arrival_time > INT_MAX / 2 || run_time > INT_MAX / 2)
+		{
+			fprintf(stderr, "Line %lld of \"%s\" runs past the longest simulation; try a larger -S.\n", swf_line(&reader), file_name);
+			swf_close(&reader);
+			return -1;
+		}
+
+		if (job_id == *jobs_ct)
+		{
+			*jobs_ct *= 2;
+			*jobs = realloc(*jobs, *jobs_ct * sizeof(simulator_job_list_t));
+
+			if (!*jobs)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				swf_close(&reader);
+				return -1;
+			}
+		}
+
+		simulator_job_list_t *job = &(*jobs)[job_id];
+		long long processors = swf_job.requested_processors > 0 ? swf_job.requested_processors : swf_job.allocated_processors;
+		job->job_id = job_id;
+		job->arrival_time = (int)arrival_time;
+		job->run_time = (int)run_time;
+		job->work = run_time * CORE_SPEED_UNIT;
+		job->priority = (int)(swf_job.queue >= 0 ? swf_job.queue : swf_job.partition >= 0 ? swf_job.partition : 0);
+		job->cores = processors > 0 ? (processors > INT_MAX ? INT_MAX : (int)processors) : 1;
+		job->group = (int)(swf_job.group_id >= 0 && swf_job.group_id < INT_MAX ? swf_job.group_id :
+				swf_job.user_id >= 0 && swf_job.user_id < INT_MAX ? swf_job.user_id : 0);
+		job->bursts = NULL;
+		job->burst_count = 1;
+		job->burst = 0;
+		job->blocked = 0;
+		job->core_id = -1;
+		job->arrived = 0;
+
+		if (check_job_cores(job, cores, gang) != 0)
+		{
+			swf_close(&reader);
+			return -1;
+		}
+		job_id++;
+	}
+	if (status == -1)
+		fprintf(stderr, "Line %lld of \"%s\" is not an SWF job (18 numeric fields).\n", swf_line(&reader), file_name);
+	else if (skipped > 0)
+		fprintf(stderr, "Skipped %lld job(s) of \"%s\" that never ran.\n", skipped, file_name);
+	swf_close(&reader);
+	return status == -1 ? -1 : job_id;
+}
+
+int compare_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+int compare_long_long(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+void print_scheme(int scheme, int quantum, int granularity, int aging)
+{
+	if (scheme == FCFS) { printf("First Come First Served (FCFS)"); }
+	else if (scheme == SJF) { printf("Non-preemptive Shortest Job First (SJF)"); }
+	else if (scheme == PSJF) { printf("Preemptive Shortest Job First (PSJF)"); }
+	else if (scheme == PRI) { printf("Non-preemptive Priority (PRI)"); }
+	else if (scheme == PPRI) { printf("Preemptive Priority (PPRI)"); }
+	else if (scheme == RR && granularity > 0) { printf("Adaptive Round Robin (RR) with a target latency of %d and a granularity of %d", quantum, granularity); }
+	else if (scheme == RR) { printf("Round Robin (RR) with a quantum of %d", quantum); }
+	else if (scheme == STRIDE) { printf("Stride Scheduling (STRIDE) with a quantum of %d", quantum); }
+	else if (scheme == LOTTERY) { printf("Lottery Scheduling (LOTTERY) with a quantum of %d", quantum); }
+	if (aging > 0 && (scheme == PRI || scheme == PPRI)) { printf(" with aging every %d time unit(s)", aging); }
 }
 
-int set_active_job(int job_id, int core_id, simulator_job_list_t *jobs, int active_jobs)
+/*
+ * Runs the jobs on a cluster of nodes, each with its own scheduler, behind
+ * a dispatcher, and prints the final statistics. Returns the exit code.
+ */
+int run_cluster(simulator_job_list_t *jobs, int total_jobs, int nodes, int cores, int scheme, int quantum, int granularity, int aging,
+		int dispatch, int window, int threads, int percentiles)
 {
+	const char *dispatch_names[] = { "random", "round robin", "join-shortest-queue", "power-of-two-choices" };
+	cluster_config_t config = { .nodes = nodes, .cores = cores, .scheme = scheme, .quantum = quantum, .granularity = granularity,
+			.aging = aging, .dispatch = dispatch, .window = window, .threads = threads, .seed = 0 };
+	cluster_job_t *cluster_jobs = malloc(total_jobs * sizeof(cluster_job_t));
+	static cluster_stats_t stats;
 	int i;
-	for (i = 0; i < active_jobs; i++)
+
+	for (i = 0; i < total_jobs; i++)
+	{
+		cluster_jobs[i].arrival_time = jobs[i].arrival_time;
+		cluster_jobs[i].run_time = jobs[i].run_time;
+		cluster_jobs[i].priority = jobs[i].priority;
+		free(jobs[i].bursts);
+	}
+	free(jobs);
+
+	printf("Loaded %d node(s) of %d core(s) and %d job(s) using ", nodes, cores, total_jobs);
+	print_scheme(scheme, quantum, granularity, aging);
+	printf(" behind %s dispatch every %d time unit(s) scheduling...\n\n", dispatch_names[dispatch], window);
+
+	if (cluster_run(cluster_jobs, total_jobs, &config, &stats) != 0)
+	{
+		printf("All cores of a node are idle and at least one of its jobs remains unscheduled.\n");
+		free(cluster_jobs);
+		return 3;
+	}
+
+	printf("Average Waiting Time: %.2f\n", (float)((double)stats.waiting_time / stats.jobs));
+	printf("Average Turnaround Time: %.2f\n", (float)((double)stats.turnaround_time / stats.jobs));
+	printf("Average Response Time: %.2f\n", (float)((double)stats.response_time / stats.jobs));
+
+	if (percentiles)
+	{
+		const char *names[] = { "Waiting", "Turnaround", "Response" };
+		histogram_t *histograms[] = { &stats.waiting_histogram, &stats.turnaround_histogram, &stats.response_histogram };
+
+		printf("\n");
+		for (i = 0; i < 3; i++)
+			printf("%s Time p50/p90/p99/p99.9: %d / %d / %d / %d\n", names[i],
+					histogram_quantile(histograms[i], 0.5), histogram_quantile(histograms[i], 0.9),
+					histogram_quantile(histograms[i], 0.99), histogram_quantile(histograms[i], 0.999));
+	}
+
+	printf("\n");
+	printf("Jobs per Node (min/avg/max): %d / %.2f / %d\n", stats.min_node_jobs, (double)total_jobs / nodes, stats.max_node_jobs);
+	printf("Makespan: %d\n", stats.makespan);
+	printf("Synchronization Windows: %lld\n", stats.windows);
+
+	free(cluster_jobs);
+	return 0;
+}
+
+/*
+ * Writes a checkpoint of the run at the start of a time unit, before any of
+ * its events. Returns 0 on success, -1 if the file could not be written.
+ */
+int write_checkpoint(const char *path, simulator_checkpoint_t *header, simulator_job_list_t *jobs, int *job_slot,
+		simulator_core_t *core_state, int *penalty_clock, char **core_timing_diagram)
+{
+	FILE *out = fopen(path, "wb");
+	if (out == NULL)
+		return -1;
+
+	int i, ok = fwrite(header, sizeof(*header), 1, out) == 1 &&
+			fwrite(jobs, sizeof(simulator_job_list_t), header->active_jobs, out) == (size_t)header->active_jobs;
+	for (i = 0; i < header->active_jobs && ok; i++)
+	{
+		if (jobs[i].bursts != NULL)
+			ok = fwrite(jobs[i].bursts, sizeof(int), jobs[i].burst_count, out) == (size_t)jobs[i].burst_count;
+	}
+	ok = ok && fwrite(job_slot, sizeof(int), header->total_jobs, out) == (size_t)header->total_jobs;
+
+	for (i = 0; i < header->cores && ok; i++)
+	{
+		simulator_checkpoint_core_t saved;
+		memset(&saved, 0, sizeof(saved));
+		saved.job = core_state[i].job;
+		saved.speed = core_state[i].speed;
+		saved.penalty = penalty_clock[i];
+		saved.finish = timerwheel_pending(&core_state[i].finish) ? core_state[i].finish.m_deadline : -1;
+		saved.quantum = timerwheel_pending(&core_state[i].quantum) ? core_state[i].quantum.m_deadline : -1;
+		saved.busy = core_state[i].busy;
+		ok = fwrite(&saved, sizeof(saved), 1, out) == 1;
+	}
+
+	for (i = 0; i < header->cores && ok; i++)
+	{
+		int length = strlen(core_timing_diagram[i]);
+		ok = fwrite(&length, sizeof(int), 1, out) == 1 &&
+				fwrite(core_timing_diagram[i], 1, length, out) == (size_t)length;
+	}
+
+	ok = ok && scheduler_save(out) == 0;
+	return fclose(out) == 0 && ok ? 0 : -1;
+}
+
+/*
+ * Reads a checkpoint up to the scheduler's snapshot, which is left for
+ * scheduler_restore() to read from in. The job list, job_slot, the saved
+ * cores and their timing diagrams are allocated here. Returns 0 on success,
+ * -1 if in does not hold a checkpoint from this build.
+ */
+int read_checkpoint(FILE *in, simulator_checkpoint_t *header, simulator_job_list_t **jobs, int **job_slot,
+		simulator_checkpoint_core_t **saved_cores, char ***core_timing_diagram)
+{
+	int i, ok;
+
+	*jobs = NULL;
+	*job_slot = NULL;
+	*saved_cores = NULL;
+	*core_timing_diagram = NULL;
+	if (fread(header, sizeof(*header), 1, in) != 1 || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0 ||
+			header->version != CHECKPOINT_VERSION || header->cores <= 0 || header->total_jobs < 0 ||
+			header->active_jobs < 0 || header->active_jobs > header->total_jobs || header->time < 0)
+		return -1;
+
+	*jobs = malloc((header->active_jobs + 1) * sizeof(simulator_job_list_t));
+	*job_slot = malloc((header->total_jobs + 1) * sizeof(int));
+	*saved_cores = malloc(header->cores * sizeof(simulator_checkpoint_core_t));
+	*core_timing_diagram = calloc(header->cores, sizeof(char *));
+
+	ok = fread(*jobs, sizeof(simulator_job_list_t), header->active_jobs, in) == (size_t)header->active_jobs;
+	for (i = 0; i < header->active_jobs; i++)
+	{
+		simulator_job_list_t *job = &(*jobs)[i];
+		int has_bursts = job->bursts != NULL;
+
+		job->bursts = NULL;
+		if (!ok || !has_bursts)
+			continue;
+		ok = job->burst_count > 1 && job->burst_count % 2 == 1;
+		if (ok)
+		{
+			job->bursts = malloc(job->burst_count * sizeof(int));
+			ok = fread(job->bursts, sizeof(int), job->burst_count, in) == (size_t)job->burst_count;
+		}
+	}
+	ok = ok && fread(*job_slot, sizeof(int), header->total_jobs, in) == (size_t)header->total_jobs &&
+			fread(*saved_cores, sizeof(simulator_checkpoint_core_t), header->cores, in) == (size_t)header->cores;
+	for (i = 0; i < header->total_jobs && ok; i++)
+		ok = (*job_slot)[i] >= -1 && (*job_slot)[i] < header->active_jobs;
+	for (i = 0; i < header->cores && ok; i++)
+		ok = (*saved_cores)[i].job >= -1 && (*saved_cores)[i].job < header->active_jobs && (*saved_cores)[i].speed > 0;
+
+	for (i = 0; i < header->cores && ok; i++)
 	{
-		if (jobs[i].job_id == job_id && jobs[i].arrived)
+		int length;
+		ok = fread(&length, sizeof(int), 1, in) == 1 && length >= 0;
+		if (ok)
 		{
-			jobs[i].core_id = core_id;
-			return 1;
+			(*core_timing_diagram)[i] = malloc(length + 1);
+			ok = fread((*core_timing_diagram)[i], 1, length, in) == (size_t)length;
+			(*core_timing_diagram)[i][length] = '\0';
 		}
 	}
 
+	if (!ok)
+	{
+		for (i = 0; i < header->active_jobs; i++)
+			free((*jobs)[i].bursts);
+		for (i = 0; i < header->cores; i++)
+			free((*core_timing_diagram)[i]);
+		free(*jobs);
+		free(*job_slot);
+		free(*saved_cores);
+		free(*core_timing_diagram);
+		*jobs = NULL;
+		*job_slot = NULL;
+		*saved_cores = NULL;
+		*core_timing_diagram = NULL;
+		return -1;
+	}
 	return 0;
 }
 
@@ -78,32 +843,51 @@ void print_available_cores(int cores)
 	}
 }
 
-
-int main(int argc, char **argv)
+/*
+ * Runs one simulation as the command line asks. Returns the exit code.
+ */
+int simulate(int argc, char **argv)
 {
 	int c;
-	int cores = 0, scheme = -1, quantum = 0;
-	char *file_name;
+	int cores = 0, scheme = -1, quantum = 0, granularity = 0, aging = 0;
+	int *core_speeds = NULL, mixed_speeds = 0;
+	int multiqueue = 0, placement = PLACE_LEAST_LOADED, steal = STEAL_BUSIEST, migration_cost = 0;
+	int switch_cost = 0, migration_penalty = 0;
+	char *file_name, *job_log_name = NULL, *telemetry_name = NULL, *event_log_name = NULL;
+	int percentiles = 0, sample_interval = 0, quiet = 0;
+	int gang = 0, backfill = 0, io_jobs = 0, swf_scale = 1;
+	int *dependency_edges = NULL, dependency_count = 0, dependency_capacity = 0;
+	int half_life = -1, *group_weights = NULL, group_weight_count = 0;
+	int nodes = 0, dispatch = DISPATCH_RANDOM, window = 1, threads = 0;
+	char *checkpoint_name = NULL, *restore_name = NULL;
+	int checkpoint_time = -1, configured = 0;
 
 	/*
 	 * Parse command line options.
 	 */
-	while ((c = getopt(argc, argv, "c:s:")) != -1)
+	while ((c = getopt(argc, argv, SIMULATOR_OPTIONS)) != -1)
 	{
+		// With -r, any scheduling option forks the checkpoint instead of resuming it
+		if (strchr("csaqvMxmgfW", c) != NULL)
+			configured = 1;
+
 		switch (c)
 		{
 			case 'c':
-				cores = atoi(optarg);
+				free(core_speeds);
+				cores = parse_cores(optarg, &core_speeds);
+				mixed_speeds = strchr(optarg, ':') != NULL;
 
 				if (cores <= 0)
 				{
-					fprintf(stderr, "Option -c <cores> require a positive number.\n");
+					fprintf(stderr, "Option -c <cores> require a positive number, or count:speed groups with positive speeds.\n");
 					print_usage(argv[0]);
 					return 1;
 				}
 				break;
 
 			case 's':
+				granularity = 0;
 				if (strcasecmp(optarg, "FCFS") == 0) { scheme = FCFS; }
 				else if (strcasecmp(optarg, "SJF") == 0) { scheme = SJF; }
 				else if (strcasecmp(optarg, "PSJF") == 0) { scheme = PSJF; }
@@ -111,8 +895,11 @@ int main(int argc, char **argv)
 				else if (strcasecmp(optarg, "PPRI") == 0) { scheme = PPRI; }
 				else if (strncasecmp(optarg, "RR", 2) == 0)
 				{
+					char *colon = strchr(optarg, ':');
 					scheme = RR;
 					quantum = atoi(optarg + 2);
+					if (colon != NULL)
+						granularity = atoi(colon + 1);
 
 					if (quantum <= 0)
 					{
@@ -120,8 +907,237 @@ int main(int argc, char **argv)
 						print_usage(argv[0]);
 						return 1;
 					}
-				}
-				break;
+					if (colon != NULL && (granularity <= 0 || granularity > quantum))
+					{
+						fprintf(stderr, "Option -s <scheme> requires adaptive RR's granularity to be positive and at most its latency. (Eg: -s RR12:2)\n");
+						print_usage(argv[0]);
+						return 1;
+					}
+				}
+				else if (strncasecmp(optarg, "STRIDE", 6) == 0 || strncasecmp(optarg, "LOTTERY", 7) == 0)
+				{
+					scheme = (strncasecmp(optarg, "STRIDE", 6) == 0) ? STRIDE : LOTTERY;
+					quantum = atoi(optarg + (scheme == STRIDE ? 6 : 7));
+
+					if (quantum <= 0)
+					{
+						fprintf(stderr, "Option -s <scheme> requires a positive number for the quantum of STRIDE/LOTTERY. (Eg: -s STRIDE2)\n");
+						print_usage(argv[0]);
+						return 1;
+					}
+				}
+				break;
+
+			case 'a':
+				aging = atoi(optarg);
+
+				if (aging <= 0)
+				{
+					fprintf(stderr, "Option -a <aging interval> requires a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'q':
+				multiqueue = 1;
+				if (strcasecmp(optarg, "LEAST") == 0) { placement = PLACE_LEAST_LOADED; }
+				else if (strcasecmp(optarg, "RR") == 0) { placement = PLACE_ROUND_ROBIN; }
+				else
+				{
+					fprintf(stderr, "Option -q <placement> must be least or rr.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'v':
+				if (strcasecmp(optarg, "BUSIEST") == 0) { steal = STEAL_BUSIEST; }
+				else if (strcasecmp(optarg, "RANDOM") == 0) { steal = STEAL_RANDOM; }
+				else
+				{
+					fprintf(stderr, "Option -v <victim> must be busiest or random.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'M':
+				migration_cost = atoi(optarg);
+
+				if (migration_cost < 0)
+				{
+					fprintf(stderr, "Option -M <migration cost> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'x':
+				switch_cost = atoi(optarg);
+
+				if (switch_cost < 0)
+				{
+					fprintf(stderr, "Option -x <switch cost> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'm':
+				migration_penalty = atoi(optarg);
+
+				if (migration_penalty < 0)
+				{
+					fprintf(stderr, "Option -m <migration cost> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'g':
+				gang = 1;
+				if (strcasecmp(optarg, "EASY") == 0) { backfill = 1; }
+				else if (strcasecmp(optarg, "NONE") == 0) { backfill = 0; }
+				else
+				{
+					fprintf(stderr, "Option -g <backfill> must be easy or none.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'j':
+				job_log_name = optarg;
+				break;
+
+			case 'e':
+				event_log_name = optarg;
+				break;
+
+			case 'P':
+				percentiles = 1;
+				break;
+
+			case 'T':
+				telemetry_name = optarg;
+				break;
+
+			case 'i':
+				sample_interval = atoi(optarg);
+
+				if (sample_interval < 0)
+				{
+					fprintf(stderr, "Option -i <interval> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'Q':
+				quiet = 1;
+				break;
+
+			case 'k':
+				checkpoint_time = atoi(optarg);
+				checkpoint_name = strchr(optarg, ':');
+
+				if (checkpoint_time < 0 || checkpoint_name == NULL || checkpoint_name[1] == '\0')
+				{
+					fprintf(stderr, "Option -k <time>:<file> requires a non-negative time and a file name. (Eg: -k 100:run.ckpt)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				checkpoint_name++;
+				break;
+
+			case 'r':
+				restore_name = optarg;
+				break;
+
+			case 'N':
+				nodes = atoi(optarg);
+
+				if (nodes <= 0)
+				{
+					fprintf(stderr, "Option -N <nodes> requires a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'd':
+				if (strcasecmp(optarg, "RANDOM") == 0) { dispatch = DISPATCH_RANDOM; }
+				else if (strcasecmp(optarg, "RR") == 0) { dispatch = DISPATCH_ROUND_ROBIN; }
+				else if (strcasecmp(optarg, "JSQ") == 0) { dispatch = DISPATCH_SHORTEST_QUEUE; }
+				else if (strcasecmp(optarg, "P2C") == 0) { dispatch = DISPATCH_TWO_CHOICES; }
+				else
+				{
+					fprintf(stderr, "Option -d <dispatch> must be random, rr, jsq or p2c.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'w':
+				window = atoi(optarg);
+
+				if (window <= 0)
+				{
+					fprintf(stderr, "Option -w <window> requires a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 't':
+				threads = atoi(optarg);
+
+				if (threads <= 0)
+				{
+					fprintf(stderr, "Option -t <threads> requires a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'f':
+				half_life = atoi(optarg);
+
+				if (half_life < 0)
+				{
+					fprintf(stderr, "Option -f <half-life> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'W':
+				free(group_weights);
+				group_weight_count = parse_group_weights(optarg, &group_weights);
+
+				if (group_weight_count < 0)
+				{
+					fprintf(stderr, "Option -W requires group:weight pairs with positive weights. (Eg: -W 0:3,1:1)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'S':
+				swf_scale = atoi(optarg);
+
+				if (swf_scale <= 0)
+				{
+					fprintf(stderr, "Option -S <seconds> requires a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'C':
+				// The result cache is main()'s business
+				break;
 
 			case '?':
 				print_usage(argv[0]);
@@ -133,6 +1149,62 @@ int main(int argc, char **argv)
 		}
 	}
 
+	/*
+	 * A checkpoint supplies the jobs, and the configuration too unless the
+	 * run forks from it; a fork keeps the checkpoint's cores and scheme
+	 * unless -c or -s replace them.
+	 */
+	FILE *restore_file = NULL;
+	simulator_checkpoint_t checkpoint;
+	simulator_job_list_t *restored_jobs = NULL;
+	simulator_checkpoint_core_t *restored_cores = NULL;
+	int *restored_slots = NULL;
+	char **restored_diagram = NULL;
+	if (restore_name != NULL)
+	{
+		restore_file = fopen(restore_name, "rb");
+		if (restore_file == NULL)
+		{
+			fprintf(stderr, "Unable to open file \"%s\".\n", restore_name);
+			return 2;
+		}
+		if (read_checkpoint(restore_file, &checkpoint, &restored_jobs, &restored_slots, &restored_cores, &restored_diagram) != 0 ||
+				(!configured && scheduler_restore(restore_file) != 0))
+		{
+			fprintf(stderr, "\"%s\" is not a checkpoint written by this simulator.\n", restore_name);
+			return 2;
+		}
+
+		if (cores == 0)
+		{
+			cores = checkpoint.cores;
+			mixed_speeds = configured ? 0 : checkpoint.mixed_speeds;
+			core_speeds = malloc(cores * sizeof(int));
+			for (c = 0; c < cores; c++)
+				core_speeds[c] = configured ? CORE_SPEED_UNIT : restored_cores[c].speed;
+		}
+		if (scheme == -1)
+		{
+			scheme = checkpoint.scheme;
+			quantum = checkpoint.quantum;
+			granularity = checkpoint.granularity;
+		}
+		if (!configured)
+		{
+			aging = checkpoint.aging;
+			multiqueue = checkpoint.multiqueue;
+			placement = checkpoint.placement;
+			steal = checkpoint.steal;
+			migration_cost = checkpoint.migration_cost;
+			switch_cost = checkpoint.switch_cost;
+			migration_penalty = checkpoint.migration_penalty;
+			gang = checkpoint.gang;
+			backfill = checkpoint.backfill;
+		}
+		io_jobs = checkpoint.io_jobs;
+		fclose(restore_file);
+	}
+
 	if (cores == 0)
 	{
 		fprintf(stderr, "Required option -c <cores> is not present.\n");
@@ -147,136 +1219,602 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
-	if (optind == argc - 1)
+	if (multiqueue && (scheme == STRIDE || scheme == LOTTERY))
+	{
+		fprintf(stderr, "Option -q <placement> is not supported by stride or lottery.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (gang && scheme != FCFS && scheme != SJF && scheme != PRI)
+	{
+		fprintf(stderr, "Option -g <backfill> requires fcfs, sjf or pri.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (gang && (aging > 0 || multiqueue || switch_cost > 0 || migration_penalty > 0 || mixed_speeds))
+	{
+		fprintf(stderr, "Option -g <backfill> cannot be combined with -a, -q, -x, -m or core speeds.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (nodes > 0 && (multiqueue || switch_cost > 0 || migration_penalty > 0 || mixed_speeds || gang || job_log_name != NULL || event_log_name != NULL || telemetry_name != NULL ||
+			checkpoint_name != NULL || restore_name != NULL))
+	{
+		fprintf(stderr, "Option -N <nodes> cannot be combined with -q, -x, -m, -g, -j, -e, -T, -k, -r or core speeds.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (restore_name != NULL && configured && (gang || checkpoint.gang || io_jobs))
+	{
+		fprintf(stderr, "A checkpoint can only be forked with scheduling options if neither it nor the fork uses -g <backfill> or I/O bursts.\n");
+		return 2;
+	}
+
+	if (restore_name != NULL && optind == argc)
+		file_name = restore_name;
+	else if (restore_name == NULL && optind == argc - 1)
 		file_name = argv[optind];
 	else
 	{
-		fprintf(stderr, "A single input file is required.\n");
+		fprintf(stderr, restore_name != NULL ? "Option -r <checkpoint> takes the place of the input file.\n" : "A single input file is required.\n");
 		print_usage(argv[0]);
 		return 1;
 	}
 
 
-	/*
-	 * Open the file, read the file, and populate the jobs data structure.
-	 */
-	FILE *file = fopen(file_name, "r");
-	if (file == NULL)
+	/*
+	 * Open the file, read the file, and populate the jobs data structure,
+	 * unless they come from a checkpoint.
+	 */
+	int job_id = 0;
+	int jobs_ct = 10;
+	simulator_job_list_t* jobs = restored_jobs;
+
+	if (restore_file == NULL)
+	{
+		FILE *file = fopen(file_name, "r");
+		if (file == NULL)
+		{
+			fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
+			return 2;
+		}
+
+
+		jobs = malloc(jobs_ct * sizeof(simulator_job_list_t));
+
+		size_t length = strlen(file_name);
+		int swf = length >= 4 && strcmp(file_name + length - 4, ".swf") == 0;
+		if (swf && (job_id = read_swf(file, file_name, swf_scale, cores, gang, &jobs, &jobs_ct)) < 0)
+		{
+			// An SWF job has no bursts to free
+			fclose(file);
+			return discard_input(2, jobs, 0, core_speeds, group_weights, dependency_edges);
+		}
+
+		char line[1024 + 1];
+		if (!swf)
+			fgets(line, 1024, file);  // Ignore the first (header) line
+		while (!swf && fgets(line, 1024, file) != NULL)
+		{
+			// Optional columns may be left empty to reach the ones after them
+			char *fields[6] = { NULL }, *rest = line;
+			line[strcspn(line, "\r\n")] = '\0';
+			for (int f = 0; f < 6 && rest != NULL; f++)
+			{
+				fields[f] = strsep(&rest, ",");
+				if (fields[f][0] == '\0')
+					fields[f] = NULL;
+			}
+			char *arrival_time = fields[0], *run_time = fields[1], *priority = fields[2];
+			char *cores_required = fields[3], *dependencies = fields[4], *group = fields[5];
+
+			if (arrival_time != NULL && run_time != NULL && priority != NULL)
+			{
+				if (job_id == jobs_ct)
+				{
+					jobs_ct *= 2;
+					jobs = realloc(jobs, jobs_ct * sizeof(simulator_job_list_t));
+
+					if (!jobs)
+					{
+						fprintf(stderr, "Out of memory.\n");
+						return 2;
+					}
+				}
+
+				jobs[job_id].job_id = job_id;
+				jobs[job_id].arrival_time = atoi(arrival_time);
+				jobs[job_id].burst_count = parse_bursts(run_time, &jobs[job_id].bursts);
+				jobs[job_id].burst = 0;
+				jobs[job_id].blocked = 0;
+				jobs[job_id].run_time = jobs[job_id].bursts != NULL ? jobs[job_id].bursts[0] : atoi(run_time);
+				jobs[job_id].work = (long long)jobs[job_id].run_time * CORE_SPEED_UNIT;
+				jobs[job_id].priority = atoi(priority);
+				jobs[job_id].cores = cores_required != NULL ? atoi(cores_required) : 1;
+				jobs[job_id].group = group != NULL ? atoi(group) : 0;
+				jobs[job_id].core_id = -1;
+				jobs[job_id].arrived = 0;
+
+				if (jobs[job_id].cores <= 0 || jobs[job_id].burst_count == 0 || jobs[job_id].group < 0 || (dependencies != NULL &&
+						parse_dependencies(dependencies, job_id, &dependency_edges, &dependency_count, &dependency_capacity) != 0))
+				{
+					fprintf(stderr, "Illegal file format.\n");
+					fclose(file);
+					return discard_input(2, jobs, job_id + 1, core_speeds, group_weights, dependency_edges);
+				}
+				if (jobs[job_id].burst_count > 1)
+					io_jobs = 1;
+				if (check_job_cores(&jobs[job_id], cores, gang) != 0)
+				{
+					fclose(file);
+					return discard_input(2, jobs, job_id + 1, core_speeds, group_weights, dependency_edges);
+				}
+
+				job_id++;
+			}
+			else
+			{
+				fprintf(stderr, "Illegal file format.\n");
+				fclose(file);
+				return discard_input(2, jobs, job_id, core_speeds, group_weights, dependency_edges);
+			}
+		}
+
+		fclose(file);
+	}
+	else
+		job_id = checkpoint.total_jobs;
+
+	// A checkpoint lists only the jobs that were still active
+	int listed_jobs = restore_file == NULL ? job_id : checkpoint.active_jobs;
+
+	if (gang && io_jobs)
+	{
+		fprintf(stderr, "Jobs with I/O bursts cannot be gang-scheduled.\n");
+		return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+	}
+
+	if (nodes > 0 && io_jobs)
+	{
+		fprintf(stderr, "Jobs with I/O bursts cannot be run on a cluster.\n");
+		return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+	}
+
+	if (half_life >= 0 && (scheme == STRIDE || scheme == LOTTERY || multiqueue || gang || nodes > 0 || checkpoint_name != NULL))
+	{
+		fprintf(stderr, "Fair share works with fcfs, sjf, psjf, pri, ppri and rr, and not with -q, -g, -N or -k.\n");
+		return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+	}
+
+	if (group_weight_count > 0 && half_life < 0)
+	{
+		fprintf(stderr, "Option -W needs fair share (-f <half-life>).\n");
+		return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+	}
+
+	/*
+	 * Dependencies are handed to the scheduler as compressed sparse rows, and
+	 * the longest chain through them bounds how short any schedule can be.
+	 */
+	int *dependency_first = NULL, *dependency_successors = NULL;
+	long long critical_length = 0;
+	if (dependency_count > 0)
+	{
+		if (gang || nodes > 0 || checkpoint_name != NULL)
+		{
+			fprintf(stderr, "Jobs with dependencies cannot be %s.\n", gang ? "gang-scheduled" : nodes > 0 ? "run on a cluster" : "checkpointed");
+			return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+		}
+		int built = build_dependencies(dependency_edges, dependency_count, job_id, &dependency_first, &dependency_successors);
+		if (built != 0)
+		{
+			fprintf(stderr, built == -2 ? "Out of memory.\n" : "A job depends on a job that is not in the file.\n");
+			return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+		}
+		free(dependency_edges);
+		dependency_edges = NULL;
+		critical_length = critical_path(jobs, job_id, dependency_first, dependency_successors);
+		if (critical_length < 0)
+		{
+			fprintf(stderr, "The job dependencies form a cycle.\n");
+			free(dependency_first);
+			free(dependency_successors);
+			return discard_input(2, jobs, listed_jobs, core_speeds, group_weights, dependency_edges);
+		}
+	}
+
+	if (nodes > 0)
+	{
+		free(core_speeds);
+		return run_cluster(jobs, job_id, nodes, cores, scheme, quantum, granularity, aging, dispatch, window, threads, percentiles);
+	}
+
+	FILE *job_log = NULL;
+	int job_log_binary = 0;
+	if (job_log_name != NULL)
+	{
+		size_t length = strlen(job_log_name);
+		job_log_binary = length >= 4 && strcmp(job_log_name + length - 4, ".bin") == 0;
+		job_log = fopen(job_log_name, job_log_binary ? "wb" : "w");
+		if (job_log == NULL)
+		{
+			fprintf(stderr, "Unable to open file \"%s\".\n", job_log_name);
+			return 2;
+		}
+	}
+
+	FILE *event_log_file = NULL;
+	eventlog_t event_log_writer;
+	if (event_log_name != NULL)
+	{
+		event_log_file = fopen(event_log_name, "wb");
+		if (event_log_file == NULL || eventlog_open(&event_log_writer, event_log_file, cores, scheme, quantum) != 0)
+		{
+			fprintf(stderr, "Unable to open file \"%s\".\n", event_log_name);
+			return 2;
+		}
+		event_log = &event_log_writer;
+	}
+
+	FILE *telemetry_file = NULL;
+	int telemetry_binary = 0;
+	telemetry_t telemetry;
+	if (telemetry_name != NULL)
+	{
+		size_t length = strlen(telemetry_name);
+		telemetry_binary = length >= 4 && strcmp(telemetry_name + length - 4, ".bin") == 0;
+		telemetry_file = fopen(telemetry_name, telemetry_binary ? "wb" : "w");
+		if (telemetry_file == NULL || telemetry_init(&telemetry, TELEMETRY_SAMPLES) != 0 ||
+				telemetry_stream(&telemetry, telemetry_file, telemetry_binary) != 0)
+		{
+			fprintf(stderr, "Unable to open file \"%s\".\n", telemetry_name);
+			return 2;
+		}
+	}
+
+
+	/*
+	 * Run the simulation.
+	 */
+
+	if (restore_name == NULL)
+		printf("Loaded %d core(s) and %d job(s) using ", cores, job_id);
+	else
+		printf("%s %d core(s) and %d job(s) from a checkpoint at time %d using ", configured ? "Forked" : "Restored", cores, job_id, checkpoint.time);
+	print_scheme(scheme, quantum, granularity, aging);
+	if (multiqueue) { printf(" on per-core run queues (%s placement, %s victim)", placement == PLACE_ROUND_ROBIN ? "round robin" : "least loaded", steal == STEAL_RANDOM ? "random" : "busiest"); }
+	if (switch_cost > 0 || migration_penalty > 0) { printf(" charging %d per context switch and %d per migration", switch_cost, migration_penalty); }
+	if (gang) { printf(" with gang scheduling (%s)", backfill ? "EASY backfilling" : "no backfilling"); }
+	if (io_jobs) { printf(" with jobs blocking on I/O"); }
+	if (dependency_count > 0) { printf(" with %d job dependencies", dependency_count); }
+	if (half_life >= 0) { printf(" with fair share between groups (usage half-life %d)", half_life); }
+	printf(" scheduling...\n\n");
+
+	// A restored scheduler already has its configuration
+	if (restore_name == NULL || configured)
+	{
+		scheduler_start_up(cores, scheme);
+		scheduler_set_aging(aging);
+		scheduler_set_quantum(quantum, granularity);
+		if (multiqueue)
+			scheduler_set_multiqueue(placement, steal, migration_cost);
+		if (switch_cost > 0 || migration_penalty > 0)
+			scheduler_set_switch_costs(switch_cost, migration_penalty);
+		if (mixed_speeds)
+			scheduler_set_core_speeds(core_speeds);
+		if (gang && scheduler_set_gang(backfill) != 0)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+		if (io_jobs)
+			scheduler_set_io_bursts(1);
+		if (dependency_count > 0 && scheduler_set_dependencies(job_id, dependency_first, dependency_successors) != 0)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+		if (half_life >= 0)
+		{
+			// A fork's job list no longer holds every job, in order
+			int listed = restore_name != NULL ? checkpoint.active_jobs : job_id;
+			int *groups = calloc(job_id + 1, sizeof(int));
+			for (int g = 0; g < listed; g++)
+				groups[jobs[g].job_id] = jobs[g].group;
+			if (scheduler_set_fair_share(job_id, groups, half_life) != 0)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				return 2;
+			}
+			free(groups);
+			for (int g = 0; g < group_weight_count; g++)
+				scheduler_set_group_weight(group_weights[2 * g], group_weights[2 * g + 1]);
+		}
+	}
+	if (job_log != NULL)
+		scheduler_set_job_log(job_log, job_log_binary);
+
+
+	int time = 0, i, j, k;
+	int active_jobs = job_id, jobs_alive = 0, total_jobs = job_id;
+	int start_time = 0;  // A fork's statistics and utilization start at its checkpoint
+	if (restore_name != NULL)
 	{
-		fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
-		return 2;
+		time = checkpoint.time;
+		active_jobs = checkpoint.active_jobs;
+		jobs_alive = checkpoint.jobs_alive;
 	}
 
+	// Scratch space for the jobs arriving in a single time unit
+	int *arrival_index = malloc(job_id * sizeof(int));
+	int *arrival_core = malloc(job_id * sizeof(int));
+	scheduler_job_spec_t *arrival_spec = malloc(job_id * sizeof(scheduler_job_spec_t));
 
-	int job_id = 0;
-	int jobs_ct = 10;
-	simulator_job_list_t* jobs = malloc(jobs_ct * sizeof(simulator_job_list_t));
-
-	char line[1024 + 1];
-	fgets(line, 1024, file);  // Ignore the first (header) line
-	while (fgets(line, 1024, file) != NULL)
+	// Where each job currently sits in the job list (-1 once it has finished)
+	int *job_slot = restored_slots;
+	if (restore_name == NULL)
 	{
-		char *arrival_time = strtok(line, ",");
-		char *run_time = strtok(NULL, ",");
-		char *priority = strtok(NULL, ",");
+		job_slot = malloc(job_id * sizeof(int));
+		for (i = 0; i < job_id; i++)
+			job_slot[i] = i;
+	}
 
-		if (arrival_time != NULL && run_time != NULL && priority != NULL)
+	/*
+	 * A fork gives the jobs that had arrived to its own scheduler as if they
+	 * arrived at the checkpoint with the work they have left, on idle cores.
+	 * A job whose last time unit ran just before the checkpoint is done.
+	 */
+	if (restore_name != NULL && configured)
+	{
+		start_time = time;
+		jobs_alive = 0;
+		for (i = 0; i < active_jobs; )
 		{
-			if (job_id == jobs_ct)
+			if (!jobs[i].arrived)
 			{
-				jobs_ct *= 2;
-				jobs = realloc(jobs, jobs_ct * sizeof(simulator_job_list_t));
-
-				if (!jobs)
-				{
-					fprintf(stderr, "Out of memory.\n");
-					return 2;
-				}
+				i++;
+				continue;
 			}
 
-			jobs[job_id].job_id = job_id;
-			jobs[job_id].arrival_time = atoi(arrival_time);
-			jobs[job_id].run_time = atoi(run_time);
-			jobs[job_id].priority = atoi(priority);
-			jobs[job_id].core_id = -1;
-			jobs[job_id].arrived = 0;
+			if (jobs[i].work <= 0)
+			{
+				job_slot[jobs[i].job_id] = -1;
+				memcpy(&jobs[i], &jobs[active_jobs - 1], sizeof(simulator_job_list_t));
+				job_slot[jobs[i].job_id] = i;
+				active_jobs--;
+				continue;
+			}
 
-			job_id++;
-		}
-		else
-		{
-			fprintf(stderr, "Illegal file format.\n");
-			return 2;
+			jobs[i].arrival_time = time;
+			jobs[i].run_time = (int)((jobs[i].work + CORE_SPEED_UNIT - 1) / CORE_SPEED_UNIT);
+			jobs[i].work = (long long)jobs[i].run_time * CORE_SPEED_UNIT;
+			jobs[i].core_id = -1;
+			jobs[i].arrived = 0;
+			i++;
 		}
 	}
 
-	fclose(file);
-
-
 	/*
-	 * Run the simulation.
+	 * The jobs yet to arrive, by arrival time and then job id, so a time unit
+	 * reads only the jobs arriving in it rather than every job in the trace.
+	 * Each key is the arrival time in the high 32 bits and the job id below.
 	 */
-
-	printf("Loaded %d core(s) and %d job(s) using ", cores, job_id);
-	if (scheme == FCFS) { printf("First Come First Served (FCFS)"); }
-	else if (scheme == SJF) { printf("Non-preemptive Shortest Job First (SJF)"); }
-	else if (scheme == PSJF) { printf("Preemptive Shortest Job First (PSJF)"); }
-	else if (scheme == PRI) { printf("Non-preemptive Priority (PRI)"); }
-	else if (scheme == PPRI) { printf("Preemptive Priority (PPRI)"); }
-	else if (scheme == RR) { printf("Round Robin (RR) with a quantum of %d", quantum); }
-	printf(" scheduling...\n\n");
-
-	scheduler_start_up(cores, scheme);
-
-
-	int time = 0, i, j;
-	int active_jobs = job_id, jobs_alive = 0;
-
-	int *quantum_clock = malloc(cores * sizeof(int));
+	long long *arrival_order = malloc((active_jobs + 1) * sizeof(long long));
+	int arrivals_left = 0, next_arrival = 0;
+	for (i = 0; i < active_jobs; i++)
+	{
+		if (!jobs[i].arrived)
+			arrival_order[arrivals_left++] = (long long)jobs[i].arrival_time * 4294967296LL + jobs[i].job_id;
+	}
+	qsort(arrival_order, arrivals_left, sizeof(long long), compare_long_long);
+	int first_arrival = arrivals_left > 0 ? (int)(arrival_order[0] >> 32) : time;
+
+	// Finish and quantum expiries are timers on a wheel, so a time unit only
+	// touches the cores whose timers actually fire
+	timerwheel_t wheel;
+	timerwheel_init(&wheel, time);
+	int *expired_cores = malloc(cores * sizeof(int));
+	int *finished_jobs = malloc(cores * sizeof(int));
+
+	simulator_core_t *core_state = malloc(cores * sizeof(simulator_core_t));
+	int *penalty_clock = malloc(cores * sizeof(int));
 	char **core_timing_diagram = malloc(cores * sizeof(char *));
 	int core_timing_diagram_size = 1024;
+	int restored = restore_name != NULL && !configured;
+
+	for (i = 0; restored && i < cores; i++)
+	{
+		while (strlen(restored_diagram[i]) >= (unsigned int)core_timing_diagram_size)
+			core_timing_diagram_size *= 2;
+	}
 
 	for (i = 0; i < cores; i++)
 	{
-		quantum_clock[i] = -1;
+		core_state[i].job = -1;
+		core_state[i].speed = core_speeds[i];
+		core_state[i].busy = 0;
+		timerwheel_entry_init(&core_state[i].finish, &core_state[i]);
+		timerwheel_entry_init(&core_state[i].quantum, &core_state[i]);
+		penalty_clock[i] = 0;
 		core_timing_diagram[i] = malloc(core_timing_diagram_size + 1);
 		core_timing_diagram[i][0] = '\0';
+
+		// Resume the core exactly as the checkpoint left it
+		if (restored)
+		{
+			core_state[i].job = restored_cores[i].job;
+			core_state[i].busy = restored_cores[i].busy;
+			if (restored_cores[i].finish != -1)
+				timerwheel_arm(&wheel, &core_state[i].finish, restored_cores[i].finish);
+			if (restored_cores[i].quantum != -1)
+				timerwheel_arm(&wheel, &core_state[i].quantum, restored_cores[i].quantum);
+			penalty_clock[i] = restored_cores[i].penalty;
+			strcpy(core_timing_diagram[i], restored_diagram[i]);
+		}
 	}
 
+	if (restore_name != NULL)
+	{
+		for (i = 0; i < checkpoint.cores; i++)
+			free(restored_diagram[i]);
+		free(restored_diagram);
+		free(restored_cores);
+	}
+
+	int checkpointed = 0;
 	while (active_jobs > 0)
 	{
-		printf("=== [TIME %d] ===\n", time);
+		if (time == checkpoint_time)
+		{
+			simulator_checkpoint_t header = { .magic = CHECKPOINT_MAGIC, .version = CHECKPOINT_VERSION, .cores = cores,
+					.scheme = scheme, .quantum = quantum, .granularity = granularity, .aging = aging, .multiqueue = multiqueue, .placement = placement,
+					.steal = steal, .migration_cost = migration_cost, .switch_cost = switch_cost,
+					.migration_penalty = migration_penalty, .mixed_speeds = mixed_speeds, .gang = gang, .backfill = backfill,
+					.io_jobs = io_jobs, .time = time, .active_jobs = active_jobs, .jobs_alive = jobs_alive, .total_jobs = total_jobs };
+			if (write_checkpoint(checkpoint_name, &header, jobs, job_slot, core_state, penalty_clock, core_timing_diagram) != 0)
+			{
+				fprintf(stderr, "Unable to write the checkpoint to \"%s\".\n", checkpoint_name);
+				return 2;
+			}
+			printf("Saved a checkpoint at time %d to \"%s\".\n", time, checkpoint_name);
+			checkpointed = 1;
+			break;
+		}
+
+		if (!quiet)
+			printf("=== [TIME %d] ===\n", time);
+
+		int finished_now = 0, expired_now = 0, events = 0;
+		timerwheel_entry_t *timer = timerwheel_advance(&wheel, time);
+		for (; timer != NULL; timer = timer->m_next)
+		{
+			simulator_core_t *core = timer->m_data;
+			if (timer == &core->finish)
+				finished_jobs[finished_now++] = core->job;
+			else
+				expired_cores[expired_now++] = core - core_state;
+		}
 
 		/*
-		 * 1. Check if any jobs finished in the last time unit.
+		 * 1. Check if any jobs finished in the last time unit, or finished a CPU
+		 *    burst and now block on I/O.
+		 *
+		 * Finished jobs are handled in job list order. Deleting a job moves the
+		 * last job into its place; if that job finished too, it is handled next.
+		 * A blocked job keeps its place.
 		 */
-		for (i = 0; i < active_jobs; i++)
+		qsort(finished_jobs, finished_now, sizeof(int), compare_int);
+		for (k = 0; k < finished_now; )
 		{
-			if (jobs[i].run_time == 0)
+			i = finished_jobs[k];
+			assert(jobs[i].work <= 0);
+
+			// Notify the scheduler has finished
+			int job_id = jobs[i].job_id;
+			int core_id = jobs[i].core_id;
+			int blocks = jobs[i].burst + 1 < jobs[i].burst_count, io_time = 0;
+			if (gang && !quiet)
+			{
+				printf("Job %d, running on core(s) ", job_id);
+				print_gang_cores(job_id, 0, cores);
+				printf(", finished.\n");
+			}
+
+			int new_job_id;
+			if (blocks)
 			{
-				// Notify the scheduler has finished
-				int job_id = jobs[i].job_id;
-				int core_id = jobs[i].core_id;
-				int new_job_id = scheduler_job_finished(jobs[i].core_id, jobs[i].job_id, time);
+				io_time = jobs[i].bursts[jobs[i].burst + 1];
+				jobs[i].burst += 2;
+				jobs[i].work = (long long)jobs[i].bursts[jobs[i].burst] * CORE_SPEED_UNIT;
+				new_job_id = scheduler_job_blocked(core_id, job_id, time, io_time, jobs[i].bursts[jobs[i].burst]);
+			}
+			else
+				new_job_id = scheduler_job_finished(jobs[i].core_id, jobs[i].job_id, time);
+
+			// Gang scheduling starts the next jobs with START records instead
+			log_event(time, blocks ? EVENTLOG_BLOCK : EVENTLOG_FINISH, job_id, core_id, gang ? -1 : new_job_id);
 
-				if (scheme == RR)
-					quantum_clock[jobs[i].core_id] = quantum;
+			idle_core(&core_state[core_id], &wheel);
+			if (jobs[i].cores > 1)
+			{
+				for (c = 0; c < cores; c++)
+					if (core_state[c].job == i)
+						core_state[c].job = -1;
+			}
 
+			if (blocks)
+			{
+				jobs[i].core_id = -1;
+				jobs[i].blocked = 1;
+				k++;
+			}
+			else
+			{
 				// Delete the finished jobs, decrease the number of active jobs
+				free(jobs[i].bursts);
+				job_slot[job_id] = -1;
 				if (i != active_jobs - 1)
+				{
 					memcpy(&jobs[i], &jobs[active_jobs - 1], sizeof(simulator_job_list_t));
+					job_slot[jobs[i].job_id] = i;
+					if (jobs[i].cores > 1)
+					{
+						for (c = 0; c < cores; c++)
+							if (core_state[c].job == active_jobs - 1)
+								core_state[c].job = i;
+					}
+					else if (jobs[i].core_id != -1)
+						core_state[jobs[i].core_id].job = i;
+
+					if (finished_now - 1 > k && finished_jobs[finished_now - 1] == active_jobs - 1)
+						finished_now--;
+					else
+						k++;
+				}
+				else
+					k++;
 				active_jobs--;
-				jobs_alive--;
-				i--;
+			}
+			jobs_alive--;
+			events++;
 
-				// Set the new job
-				if ( new_job_id != -1 && !set_active_job(new_job_id, core_id, jobs, active_jobs) )
+			if (gang)
+			{
+				if (start_gang_jobs(core_state, cores, jobs, job_slot, total_jobs, &wheel, time, quiet) == -1)
 				{
-					printf("The scheduler_job_finished() selected an invalid job (job_id == %d).\n", new_job_id);
 					print_available_jobs(jobs, active_jobs);
 					return 3;
 				}
-				else
+				if (!quiet)
+				{
+					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+				}
+				continue;
+			}
+
+			// Set the new job
+			int new_index = -1;
+			if ( new_job_id != -1 && (new_index = set_active_job(new_job_id, core_id, jobs, job_slot, total_jobs)) == -1 )
+			{
+				printf("The scheduler_job_finished() selected an invalid job (job_id == %d).\n", new_job_id);
+				print_available_jobs(jobs, active_jobs);
+				return 3;
+			}
+			else
+			{
+				if (new_job_id != -1)
+					place_on_core(core_state, core_id, new_index, jobs, &wheel, time, quantum, penalty_clock);
+
+				if (!quiet && blocks)
+				{
+					printf("Job %d, running on core %d, blocked on I/O for %d time unit(s). Core %d is now running job %d.\n", job_id, core_id, io_time, core_id, new_job_id);
+					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+				}
+				else if (!quiet)
 				{
 					printf("Job %d, running on core %d, finished. Core %d is now running job %d.\n", job_id, core_id, core_id, new_job_id);
 					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
@@ -293,86 +1831,196 @@ int main(int argc, char **argv)
 		/*
 		 * 2. Check of any quantums expired in the last time unit.
 		 */
-		if (scheme == RR)
+		qsort(expired_cores, expired_now, sizeof(int), compare_int);
+		for (k = 0; k < expired_now; k++)
 		{
-			for (i = 0; i < cores; i++)
+			int core_id = expired_cores[k];
+
+			// A job that finished on this core in step 1 restarted its quantum
+			if (core_state[core_id].job == -1 || timerwheel_pending(&core_state[core_id].quantum))
+				continue;
+
+			// Notify the scheduler the quantum has expired
+			j = core_state[core_id].job;
+			int old_job_id = jobs[j].job_id;
+			int new_job_id = scheduler_quantum_expired(core_id, time);
+			log_event(time, EVENTLOG_EXPIRY, old_job_id, core_id, new_job_id);
+
+			jobs[j].core_id = -1;
+			idle_core(&core_state[core_id], &wheel);
+
+			// Set the new job
+			int new_index = -1;
+			if ( new_job_id != -1 && (new_index = set_active_job(new_job_id, core_id, jobs, job_slot, total_jobs)) == -1 )
+			{
+				printf("The scheduler_quantum_expired() selected an invalid job (job_id == %d).\n", new_job_id);
+				print_available_jobs(jobs, active_jobs);
+				return 3;
+			}
+			else
 			{
-				if (quantum_clock[i] == 0)
+				if (new_job_id != -1)
+					place_on_core(core_state, core_id, new_index, jobs, &wheel, time, quantum, penalty_clock);
+
+				events++;
+				if (!quiet)
 				{
-					for (j = 0; j < active_jobs; j++)
-					{
-						if (jobs[j].core_id == i)
-						{
-							// Notify the scheduler the quantum has expired
-							int core_id = jobs[j].core_id;
-							int old_job_id = jobs[j].job_id;
-							int new_job_id = scheduler_quantum_expired(jobs[j].core_id, time);
-
-							jobs[j].core_id = -1;
-
-							quantum_clock[core_id] = quantum;
-
-							// Set the new job
-							if ( new_job_id != -1 && !set_active_job(new_job_id, core_id, jobs, active_jobs) )
-							{
-								printf("The scheduler_quantum_expired() selected an invalid job (job_id == %d).\n", new_job_id);
-								print_available_jobs(jobs, active_jobs);
-								return 3;
-							}
-							else
-							{
-								printf("Job %d, running on core %d, had its quantum expire. Core %d is now running job %d.\n", old_job_id, core_id, core_id, new_job_id);
-								printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-							}
-
-							break;
-						}
-					}
+					printf("Job %d, running on core %d, had its quantum expire. Core %d is now running job %d.\n", old_job_id, core_id, core_id, new_job_id);
+					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
 				}
 			}
 		}
 
 
 		/*
-		 * 3. Check for any new jobs that arrive in this time unit
+		 * 3. Check for any blocked jobs whose I/O completed and any new jobs that arrive in this time unit
 		 */
-		for (i = 0; i < active_jobs; i++)
+		int woke_id, woke_core;
+		while (io_jobs && (woke_id = scheduler_job_woke(time, &woke_core)) != -1)
+		{
+			if (woke_id >= total_jobs || job_slot[woke_id] == -1 || !jobs[job_slot[woke_id]].blocked)
+			{
+				printf("The scheduler_job_woke() woke a job that is not blocked (job_id == %d).\n", woke_id);
+				print_available_jobs(jobs, active_jobs);
+				return 3;
+			}
+			if (woke_core < -1 || woke_core >= cores)
+			{
+				printf("The scheduler_job_woke() selected an invalid core (core_id == %d).\n", woke_core);
+				print_available_cores(cores);
+				return 3;
+			}
+
+			i = job_slot[woke_id];
+			jobs[i].blocked = 0;
+			jobs_alive++;
+			events++;
+			log_event(time, EVENTLOG_WAKE, woke_id, woke_core, jobs[i].bursts[jobs[i].burst]);
+
+			if (!quiet)
+			{
+				if (woke_core != -1)
+					printf("Job %d (running time=%d) woke up from I/O. Job %d is now running on core %d.\n", woke_id, jobs[i].bursts[jobs[i].burst], woke_id, woke_core);
+				else
+					printf("Job %d (running time=%d) woke up from I/O. Job %d is set to idle (-1).\n", woke_id, jobs[i].bursts[jobs[i].burst], woke_id);
+				printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+			}
+
+			if (woke_core != -1)
+				place_on_core(core_state, woke_core, i, jobs, &wheel, time, quantum, penalty_clock);
+		}
+
+		int released_id, released_core;
+		while (dependency_count > 0 && (released_id = scheduler_job_released(time, &released_core)) != -1)
+		{
+			if (released_id >= total_jobs || job_slot[released_id] == -1 || !jobs[job_slot[released_id]].arrived ||
+					jobs[job_slot[released_id]].core_id != -1)
+			{
+				printf("The scheduler_job_released() released a job that is not waiting (job_id == %d).\n", released_id);
+				print_available_jobs(jobs, active_jobs);
+				return 3;
+			}
+			if (released_core < -1 || released_core >= cores)
+			{
+				printf("The scheduler_job_released() selected an invalid core (core_id == %d).\n", released_core);
+				print_available_cores(cores);
+				return 3;
+			}
+
+			i = job_slot[released_id];
+			events++;
+
+			if (!quiet)
+			{
+				if (released_core != -1)
+					printf("Job %d (running time=%d) can start now that the jobs it depends on finished. Job %d is now running on core %d.\n",
+							released_id, jobs[i].run_time, released_id, released_core);
+				else
+					printf("Job %d (running time=%d) can start now that the jobs it depends on finished. Job %d is set to idle (-1).\n",
+							released_id, jobs[i].run_time, released_id);
+				printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+			}
+
+			if (released_core != -1)
+			{
+				log_event(time, EVENTLOG_START, released_id, released_core, 0);
+				place_on_core(core_state, released_core, i, jobs, &wheel, time, quantum, penalty_clock);
+			}
+		}
+
+		// Jobs arriving together are handled in job list order
+		int arrived_now = 0;
+		for (; next_arrival < arrivals_left && arrival_order[next_arrival] >> 32 <= time; next_arrival++)
 		{
-			if (jobs[i].arrival_time == time)
+			if (arrival_order[next_arrival] >> 32 == time)
+				arrival_index[arrived_now++] = job_slot[arrival_order[next_arrival] & 0xFFFFFFFFLL];
+		}
+		qsort(arrival_index, arrived_now, sizeof(int), compare_int);
+		for (k = 0; k < arrived_now; k++)
+		{
+			i = arrival_index[k];
+			arrival_spec[k].job_number = jobs[i].job_id;
+			arrival_spec[k].running_time = jobs[i].run_time;
+			arrival_spec[k].priority = jobs[i].priority;
+		}
+
+		// Hand the whole burst to the scheduler at once
+		if (arrived_now > 0 && !gang)
+			scheduler_new_jobs_batch(arrival_spec, arrived_now, time, arrival_core);
+
+		for (k = 0; k < arrived_now; k++)
+		{
+			i = arrival_index[k];
+			int new_job_core_id = arrival_core[k];
+			jobs[i].arrived = 1;
+			jobs_alive++;
+			events++;
+			log_event(time, EVENTLOG_ARRIVAL, jobs[i].job_id, gang ? -1 : new_job_core_id, jobs[i].run_time);
+
+			if (gang)
 			{
-				int new_job_core_id = scheduler_new_job(jobs[i].job_id, time, jobs[i].run_time, jobs[i].priority);
-				jobs[i].arrived = 1;
-				jobs_alive++;
+				if (!quiet)
+					printf("A new job, job %d (running time=%d, priority=%d, cores=%d), arrived.\n",
+							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].cores);
+
+				scheduler_new_gang_job(jobs[i].job_id, time, jobs[i].run_time, jobs[i].priority, jobs[i].cores);
+				if (start_gang_jobs(core_state, cores, jobs, job_slot, total_jobs, &wheel, time, quiet) == -1)
+				{
+					print_available_jobs(jobs, active_jobs);
+					return 3;
+				}
+				if (!quiet)
+				{
+					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+				}
+				continue;
+			}
 
-				if (new_job_core_id >= 0 && new_job_core_id < cores)
+			if (new_job_core_id >= 0 && new_job_core_id < cores)
+			{
+				if (!quiet)
 				{
 					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is now running on core %d.\n",
 							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].job_id, new_job_core_id);
 					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-
-					// Find if anyone is currently using the core.
-					for (j = 0; j < active_jobs; j++)
-						if (jobs[j].core_id == new_job_core_id)
-							jobs[j].core_id = -1;
-
-					// Assign the core to the new job
-					jobs[i].core_id = new_job_core_id;
-
-					if (scheme == RR)
-						quantum_clock[new_job_core_id] = quantum;
 				}
-				else if (new_job_core_id == -1)
+
+				place_on_core(core_state, new_job_core_id, i, jobs, &wheel, time, quantum, penalty_clock);
+			}
+			else if (new_job_core_id == -1)
+			{
+				if (!quiet)
 				{
 					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is set to idle (-1).\n",
 							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].job_id);
 					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
 				}
-				else
-				{
-					printf("The scheduler_new_job() selected an invalid core (core_id == %d).\n", new_job_core_id);
-					print_available_cores(cores);
-					return 3;
-				}
+			}
+			else
+			{
+				printf("The scheduler_new_job() selected an invalid core (core_id == %d).\n", new_job_core_id);
+				print_available_cores(cores);
+				return 3;
 			}
 		}
 
@@ -384,30 +2032,41 @@ int main(int argc, char **argv)
 		int cores_working = 0;
 
 		for (i = 0; i < cores; i++)
+		{
 			time_string[i][0] = '\0';
 
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].core_id != -1)
-			{
-				cores_working++;
-				jobs[i].run_time--;
-				quantum_clock[jobs[i].core_id]--;
+			if (core_state[i].job == -1)
+				continue;
 
-				assert(time_string[jobs[i].core_id][0] == '\0');
+			j = core_state[i].job;
+			cores_working++;
+			core_state[i].busy++;
 
-				if (jobs[i].job_id < 10)
-					sprintf(time_string[jobs[i].core_id], "%d", jobs[i].job_id);
-				else if (jobs[i].job_id < 10 + 26)
-					sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 + 'a');
-				else if (jobs[i].job_id < 10 + 26 + 26)
-					sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 - 26 + 'A');
-				else
-					snprintf(time_string[jobs[i].core_id], 10, "(%d)", jobs[i].job_id);
+			assert(jobs[j].core_id == i || jobs[j].cores > 1);
+
+			// The core is paying dispatch overhead, the job makes no progress
+			if (penalty_clock[i] > 0)
+			{
+				penalty_clock[i]--;
+				strcpy(time_string[i], "*");
+				continue;
 			}
+
+			// Every core of a gang job shows it, but only the first drains its work
+			if (jobs[j].core_id == i)
+				jobs[j].work -= core_state[i].speed;
+
+			if (jobs[j].job_id < 10)
+				sprintf(time_string[i], "%d", jobs[j].job_id);
+			else if (jobs[j].job_id < 10 + 26)
+				sprintf(time_string[i], "%c", jobs[j].job_id - 10 + 'a');
+			else if (jobs[j].job_id < 10 + 26 + 26)
+				sprintf(time_string[i], "%c", jobs[j].job_id - 10 - 26 + 'A');
+			else
+				snprintf(time_string[i], 10, "(%d)", jobs[j].job_id);
 		}
 
-		for (i = 0; i < cores; i++)
+		for (i = 0; i < cores && !quiet; i++)
 		{
 			// If the core is idle, print a '-'
 			if (time_string[i][0] == '\0')
@@ -437,25 +2096,33 @@ int main(int argc, char **argv)
 		/*
 		 * 5. Print data!
 		 */
-		printf("At the end of time unit %d...\n", time);
+		if (!quiet)
+		{
+			printf("At the end of time unit %d...\n", time);
 
-		for (i = 0; i < cores; i++)
-			printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
+			for (i = 0; i < cores; i++)
+				printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
 
-		printf("\n");
+			printf("\n");
 
-		printf("  Queue: ");
-		scheduler_show_queue();
-		printf("\n");
-		printf("\n");
+			printf("  Queue: ");
+			scheduler_show_queue();
+			printf("\n");
+			printf("\n");
+		}
+
+		if (telemetry_file != NULL && (sample_interval > 0 ? time % sample_interval == 0 : events > 0))
+			telemetry_sample(&telemetry, time, scheduler_ready_count(), cores_working,
+					scheduler_preemption_count(), scheduler_context_switch_count(), scheduler_last_quantum());
 
 
 		/*
 		 * 6. Sanity Checking
 		 *
 		 * - If there's a job alive (needing to be ran) and all CPUs are idle, the scheduler failed to schedule properly.
+		 *   Jobs still waiting on the jobs they depend on do not count.
 		 */
-		if (jobs_alive > 0 && cores_working == 0)
+		if (jobs_alive > (dependency_count > 0 ? scheduler_held_count() : 0) && cores_working == 0)
 		{
 			printf("All cores are idle and at least one job remains unscheduled.\n");
 			print_available_jobs(jobs, active_jobs);
@@ -470,23 +2137,232 @@ int main(int argc, char **argv)
 	}
 
 
-	printf("FINAL TIMING DIAGRAM:\n");
-	for (i = 0; i < cores; i++)
-		printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
+	if (checkpoint_name != NULL && !checkpointed)
+		fprintf(stderr, "The run finished at time %d, before the checkpoint at time %d was due.\n", time, checkpoint_time);
 
-	printf("\n");
-	printf("Average Waiting Time: %.2f\n", scheduler_average_waiting_time());
-	printf("Average Turnaround Time: %.2f\n", scheduler_average_turnaround_time());
-	printf("Average Response Time: %.2f\n", scheduler_average_response_time());
+	if (!checkpointed)
+	{
+		if (!quiet)
+		{
+			printf("FINAL TIMING DIAGRAM:\n");
+			for (i = 0; i < cores; i++)
+				printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
+
+			printf("\n");
+		}
+		printf("Average Waiting Time: %.2f\n", scheduler_average_waiting_time());
+		printf("Average Turnaround Time: %.2f\n", scheduler_average_turnaround_time());
+		printf("Average Response Time: %.2f\n", scheduler_average_response_time());
+
+		if (percentiles)
+		{
+			const char *names[] = { "Waiting", "Turnaround", "Response" };
+			metric_t metrics[] = { METRIC_WAITING, METRIC_TURNAROUND, METRIC_RESPONSE };
+
+			printf("\n");
+			for (i = 0; i < 3; i++)
+				printf("%s Time p50/p90/p99/p99.9: %d / %d / %d / %d\n", names[i],
+						scheduler_percentile(metrics[i], 0.5), scheduler_percentile(metrics[i], 0.9),
+						scheduler_percentile(metrics[i], 0.99), scheduler_percentile(metrics[i], 0.999));
+		}
+
+		if (granularity > 0)
+		{
+			printf("\n");
+			printf("Average Quantum: %.2f\n", scheduler_average_quantum());
+		}
+
+		if (multiqueue)
+		{
+			printf("\n");
+			printf("Steals: %d\n", scheduler_steal_count());
+			printf("Average Queue Imbalance: %.2f\n", scheduler_average_imbalance());
+			printf("Max Queue Imbalance: %d\n", scheduler_max_imbalance());
+		}
+
+		if (switch_cost > 0 || migration_penalty > 0)
+		{
+			if (!multiqueue)
+				printf("\n");
+			printf("Context Switches: %d\n", scheduler_context_switch_count());
+			printf("Migrations: %d\n", scheduler_migration_count());
+		}
+
+		if (multiqueue || switch_cost > 0 || migration_penalty > 0)
+			printf("Overhead Time: %d\n", scheduler_overhead_time());
+
+		if (gang)
+		{
+			printf("\n");
+			printf("Backfilled Jobs: %d\n", scheduler_backfill_count());
+		}
+
+		if (io_jobs)
+		{
+			printf("\n");
+			printf("I/O Blocks: %d\n", scheduler_block_count());
+		}
+
+		if (half_life >= 0)
+		{
+			// The spread between groups shows whether any of them was starved
+			float least_waiting = -1, most_waiting = -1;
+			int groups_run = 0;
+			for (int g = 0; g < scheduler_group_count(); g++)
+			{
+				float waiting = scheduler_group_waiting_time(g);
+				if (waiting < 0)
+					continue;
+				groups_run++;
+				if (least_waiting < 0 || waiting < least_waiting)
+					least_waiting = waiting;
+				if (waiting > most_waiting)
+					most_waiting = waiting;
+			}
+			printf("\n");
+			printf("Groups: %d\n", groups_run);
+			printf("Group Average Waiting Time (min / max): %.2f / %.2f\n", least_waiting, most_waiting);
+		}
+
+		if (dependency_count > 0)
+		{
+			printf("\n");
+			printf("Critical Path Length: %lld\n", critical_length);
+			printf("Makespan: %d (%.2fx the critical path)\n", time - first_arrival,
+					critical_length > 0 ? (double)(time - first_arrival) / critical_length : 0.0);
+		}
+
+		if (mixed_speeds || gang || io_jobs)
+		{
+			printf("\n");
+			printf("Core Utilization:\n");
+			for (i = 0; i < cores; i++)
+				printf("  Core %2d (speed %.2f): %.2f%%\n", i, (double)core_state[i].speed / CORE_SPEED_UNIT,
+						time > start_time ? 100.0 * core_state[i].busy / (time - start_time) : 0.0);
+		}
+	}
 
 	scheduler_clean_up();
 
+	if (job_log != NULL)
+		fclose(job_log);
+
+	if (event_log != NULL)
+	{
+		if (eventlog_close(event_log) != 0)
+			fprintf(stderr, "Unable to write all of the event log to \"%s\".\n", event_log_name);
+		fclose(event_log_file);
+		event_log = NULL;
+	}
+
+	if (telemetry_file != NULL)
+	{
+		if (telemetry_flush(&telemetry) != 0)
+			fprintf(stderr, "Unable to write all of the telemetry to \"%s\".\n", telemetry_name);
+
+		fclose(telemetry_file);
+		telemetry_destroy(&telemetry);
+	}
+
 
-	free(quantum_clock);
+	free(core_state);
+	free(core_speeds);
+	free(penalty_clock);
+	free(job_slot);
+	free(expired_cores);
+	free(finished_jobs);
+	free(arrival_index);
+	free(arrival_order);
+	free(arrival_core);
+	free(arrival_spec);
+	free(dependency_first);
+	free(dependency_successors);
+	free(group_weights);
 	for (i=0; i < cores; i++)
 		free(core_timing_diagram[i]);
 	free(core_timing_diagram);
+	for (i = 0; i < active_jobs; i++)
+		free(jobs[i].bursts);
 	free(jobs);
 
 	return 0;
 }
+
+
+/*
+ * With -C, prints the output and error output of a run that is already in
+ * the result cache instead of simulating it, and stores those of a run that
+ * is not.
+ * Runs writing other files (-j, -e, -T, -k) are simulated every time, as a
+ * hit could not write them.
+ */
+int main(int argc, char **argv)
+{
+	char *cache_dir = NULL, *restore_name = NULL, *file_name = NULL;
+	int c, i, cacheable = 1, status;
+
+	// simulate() parses the options again and reports any mistakes
+	opterr = 0;
+	while ((c = getopt(argc, argv, SIMULATOR_OPTIONS)) != -1)
+	{
+		if (c == 'C')
+			cache_dir = optarg;
+		else if (c == 'r')
+			restore_name = optarg;
+		else if (strchr("jeTk?", c) != NULL)
+			cacheable = 0;
+	}
+	if (optind == argc - 1)
+		file_name = argv[optind];
+	opterr = 1;
+	optind = 1;
+	if (cache_dir == NULL || !cacheable)
+		return simulate(argc, argv);
+
+	/*
+	 * The key covers every argument and the contents of the input file and
+	 * checkpoint, so a changed workload misses. Entries are also filed under
+	 * a hash of the executable, so a rebuild of the simulator or any of its
+	 * libraries never reads results an older build stored.
+	 */
+	unsigned long long build = RESULTCACHE_SEED, key = RESULTCACHE_SEED;
+	if (resultcache_hash_file(&build, "/proc/self/exe") != 0 && resultcache_hash_file(&build, argv[0]) != 0)
+	{
+		fprintf(stderr, "Unable to read the simulator's own executable; running without the result cache.\n");
+		return simulate(argc, argv);
+	}
+	int args_length = 0;
+	for (i = 1; i < argc; i++)
+		args_length += strlen(argv[i]) + 1;
+	char *args = malloc(args_length + 1), *next = args;
+	for (i = 1; i < argc; i++)
+		next = stpcpy(next, argv[i]) + 1;
+	key = resultcache_hash(key, args, args_length);
+	// An unreadable file is simulate()'s to report
+	if ((file_name != NULL && resultcache_hash_file(&key, file_name) != 0) ||
+			(restore_name != NULL && resultcache_hash_file(&key, restore_name) != 0))
+	{
+		free(args);
+		return simulate(argc, argv);
+	}
+
+	resultcache_t cache;
+	int hit = resultcache_open(&cache, cache_dir, build, key, args, args_length) == 0 ? resultcache_replay(&cache, stdout, stderr) : 0;
+	if (hit != 0)
+		status = hit == 1 ? 0 : 2;
+	else if (resultcache_capture(&cache, stdout, stderr) != 0)
+	{
+		fprintf(stderr, "Unable to write to the result cache in \"%s\"; running without it.\n", cache_dir);
+		status = simulate(argc, argv);
+	}
+	else
+	{
+		status = simulate(argc, argv);
+		// Only a run that completed is worth repeating
+		if (resultcache_finish(&cache, stdout, stderr, status == 0) != 0)
+			fprintf(stderr, "Unable to store the result in \"%s\".\n", cache_dir);
+	}
+	resultcache_close(&cache);
+	free(args);
+	return status;
+}
@@ -0,0 +1,108 @@
+/** @file wheeltest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libtimerwheel/libtimerwheel.h"
+
+#define TIMERS 2000
+#define HORIZON 300000
+
+int main()
+{
+	timerwheel_t w;
+	timerwheel_entry_t *timers = malloc(TIMERS * sizeof(timerwheel_entry_t));
+	int *deadline = malloc(TIMERS * sizeof(int));
+	int ids[4] = { 0, 1, 2, 3 };
+	int i, now;
+
+	/* A handful of timers across levels, one of them cancelled. */
+	timerwheel_init(&w, 0);
+	for (i = 0; i < 4; i++)
+		timerwheel_entry_init(&timers[i], &ids[i]);
+	timerwheel_arm(&w, &timers[0], 5);
+	timerwheel_arm(&w, &timers[1], 70);
+	timerwheel_arm(&w, &timers[2], 5000);
+	timerwheel_arm(&w, &timers[3], 3);
+	timerwheel_cancel(&w, &timers[3]);
+
+	printf("Pending timers: %d (expected 3).\n", timerwheel_size(&w));
+	printf("Next deadline: %d (expected 5).\n", timerwheel_next_deadline(&w));
+
+	printf("Expiry order (expected 0@5 1@70 2@5000): ");
+	for (now = 0; now <= 6000; now++)
+	{
+		timerwheel_entry_t *e;
+		for (e = timerwheel_advance(&w, now); e != NULL; e = e->m_next)
+			printf("%d@%d ", *(int *)e->m_data, now);
+	}
+	printf("\n");
+
+	/* Randomised check against the deadlines themselves, re-arming on expiry. */
+	int errors = 0, fired = 0, armed = TIMERS;
+	srand(241);
+	timerwheel_init(&w, 0);
+	for (i = 0; i < TIMERS; i++)
+	{
+		timerwheel_entry_init(&timers[i], &deadline[i]);
+		deadline[i] = rand() % 100000;
+		timerwheel_arm(&w, &timers[i], deadline[i]);
+	}
+
+	for (now = 0; now < HORIZON; now++)
+	{
+		if (now % 97 == 0 && timerwheel_size(&w) > 0)
+		{
+			int expect = HORIZON * 100;
+			for (i = 0; i < TIMERS; i++)
+				if (timerwheel_pending(&timers[i]) && deadline[i] < expect)
+					expect = deadline[i];
+			if (timerwheel_next_deadline(&w) != expect)
+				errors++;
+		}
+
+		timerwheel_entry_t *e = timerwheel_advance(&w, now);
+		while (e != NULL)
+		{
+			timerwheel_entry_t *next = e->m_next;
+			int *d = e->m_data;
+			if (*d != now)
+				errors++;
+			fired++;
+
+			if (rand() % 2 && now < HORIZON / 2)
+			{
+				*d = now + 1 + rand() % (rand() % 2 ? 50 : 100000);
+				timerwheel_arm(&w, e, *d);
+				armed++;
+			}
+			e = next;
+		}
+
+		// Cancel and re-arm some pending timers
+		i = rand() % TIMERS;
+		if (timerwheel_pending(&timers[i]) && now < HORIZON / 2)
+		{
+			if (rand() % 3 == 0)
+			{
+				timerwheel_cancel(&w, &timers[i]);
+				armed--;
+			}
+			else
+			{
+				deadline[i] = now + 1 + rand() % 5000;
+				timerwheel_arm(&w, &timers[i], deadline[i]);
+			}
+		}
+	}
+
+	printf("Timers fired at the wrong time: %d (expected 0).\n", errors);
+	printf("Timers still pending: %d (expected 0).\n", timerwheel_size(&w));
+	printf("Armed timers that never fired: %d (expected 0).\n", armed - fired);
+
+	free(timers);
+	free(deadline);
+
+	return 0;
+}